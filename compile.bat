@@ -9,4 +9,5 @@ C:\VulkanSDK\1.3.261.1\Bin\glslc.exe data\shaders\point_light.vert -o data\shade
 C:\VulkanSDK\1.3.261.1\Bin\glslc.exe data\shaders\point_light.frag -o data\shaders\point_light.frag.spv
 C:\VulkanSDK\1.3.261.1\Bin\glslc.exe data\shaders\texture_pbr.vert -o data\shaders\texture_pbr.vert.spv
 C:\VulkanSDK\1.3.261.1\Bin\glslc.exe data\shaders\texture_pbr.frag -o data\shaders\texture_pbr.frag.spv
+C:\VulkanSDK\1.3.261.1\Bin\glslc.exe data\shaders\gpu_cull.comp -o data\shaders\gpu_cull.comp.spv
 pause
\ No newline at end of file
@@ -1,23 +1,27 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 in_color;
 layout (location = 3) in vec2 in_uv;
 
 layout (location = 0) out vec4 out_color;
 
-layout (set = 0, binding = 5) uniform sampler2D tex;
+// bindless texture table
+layout (set = 1, binding = 0) uniform sampler2D textures[];
 
 layout (push_constant) uniform Push
 {
     mat4 model_matrix;
+    vec4 uv_transform; // xy offset, zw scale of the packed uvs
     bool use_texture;
+    int  texture_index;
 } push;
 
 void main()
 {
     if (push.use_texture)
     {
-        out_color.rgb = texture(tex, in_uv).rgb;
+        out_color.rgb = texture(textures[push.texture_index], in_uv).rgb;
         out_color.a = 1.0f;
         return;
     }
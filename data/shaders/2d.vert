@@ -2,9 +2,7 @@
 
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_color;
-layout (location = 2) in vec3 in_normal;
 layout (location = 3) in vec2 in_uv;
-layout (location = 4) in vec3 in_tangent;
 
 layout (location = 0) out vec3 out_color;
 layout (location = 3) out vec2  out_uv;
@@ -19,6 +17,9 @@ layout (set = 0, binding = 0) uniform global_ubo
 layout (push_constant) uniform Push
 {
     mat4 model_matrix;
+    vec4 uv_transform; // xy offset, zw scale of the packed uvs
+    bool use_texture;
+    int  texture_index;
 } push;
 
 void main()
@@ -26,6 +27,6 @@ void main()
     vec4 position = push.model_matrix * vec4(in_position, 1.0f);
     
     out_color           = in_color;
-    out_uv              = in_uv;
+    out_uv              = push.uv_transform.xy + in_uv * push.uv_transform.zw;
     gl_Position         = ubo.projection * (ubo.view * position);
 }
\ No newline at end of file
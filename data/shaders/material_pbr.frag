@@ -5,6 +5,8 @@ layout (location = 1) in vec3 in_position;
 layout (location = 2) in vec3 in_normal;
 layout (location = 3) in vec2 in_uv;
 layout (location = 4) in vec3 in_tangent;
+layout (location = 5) flat in vec4 in_base_color_metallic; // w is metallic
+layout (location = 6) flat in float in_roughness;
 
 layout (location = 0) out vec4 out_color;
 
@@ -29,17 +31,6 @@ layout (set = 0, binding = 0) uniform global_ubo
 const vec3 dielectric = vec3(0.04f);
 const float ambient = 0.01f;
 
-layout (push_constant) uniform Push
-{
-    mat4  model_matrix;
-    mat4  normal_matrix;
-    float r;
-    float g;
-    float b;
-    float metallic;
-    float roughness;
-} push;
-
 /*
     * light          : light source
     * point_to_shade : target position
@@ -157,9 +148,9 @@ void main()
     vec3 camera_pos_world = ubo.inverse_view[3].xyz;
     vec3 view_dir         = normalize(camera_pos_world - in_position);
 
-    vec3 base_color = vec3(push.r, push.g, push.b);
-    float metallic  = push.metallic;
-    float roughness = push.roughness;
+    vec3 base_color = in_base_color_metallic.rgb;
+    float metallic  = in_base_color_metallic.w;
+    float roughness = in_roughness;
 
     out_color.rgb = base_color * ambient;
     out_color.a   = 1.0f;
@@ -1,10 +1,12 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 in_color;
 layout (location = 1) in vec3 in_position;
 layout (location = 2) in vec3 in_normal;
 layout (location = 3) in vec2 in_uv;
 layout (location = 4) in vec3 in_tangent;
+layout (location = 5) flat in ivec4 in_texture_indices; // diffuse, normal, specular, glossiness
 
 layout (location = 0) out vec4 out_color;
 
@@ -24,17 +26,13 @@ layout (set = 0, binding = 0) uniform global_ubo
     int num_lights;
 } ubo;
 
-layout (set = 0, binding = 1) uniform sampler2D diffuse_texture;
-layout (set = 0, binding = 2) uniform sampler2D normal_texture;
-layout (set = 0, binding = 3) uniform sampler2D specular_texture;
-layout (set = 0, binding = 4) uniform sampler2D gloss_texture;
+// bindless texture table
+layout (set = 1, binding = 0) uniform sampler2D textures[];
 
 #define PI 3.1415926535897932384626433832795
 
 layout (push_constant) uniform Push
 {
-    mat4 model_matrix;
-    mat4 normal_matrix;
     int  shading_mode;
     bool use_normal_map;
 } push;
@@ -102,10 +100,11 @@ void main()
     vec3 camera_pos_world = ubo.inverse_view[3].xyz;
     vec3 view_dir         = normalize(camera_pos_world - in_position);
     
-    vec3 diffuse_color  = texture(diffuse_texture, in_uv).rgb;
-    vec3 normal_color   = texture(normal_texture, in_uv).rgb;
-    vec3 specular_color = texture(specular_texture, in_uv).rgb;
-    float gloss_color   = texture(gloss_texture, in_uv).r;
+    vec3 diffuse_color  = texture(textures[nonuniformEXT(in_texture_indices.x)], in_uv).rgb;
+    vec2 normal_xy      = texture(textures[nonuniformEXT(in_texture_indices.y)], in_uv).rg * 2.0f - 1.0f; // cooked normal maps are two-channel BC5
+    vec3 normal_color   = vec3(normal_xy, sqrt(max(1.0f - dot(normal_xy, normal_xy), 0.0f))) * 0.5f + 0.5f;
+    vec3 specular_color = texture(textures[nonuniformEXT(in_texture_indices.z)], in_uv).rgb;
+    float gloss_color   = texture(textures[nonuniformEXT(in_texture_indices.w)], in_uv).r;
 
     out_color = shade_pixel(in_normal, in_tangent, view_dir, diffuse_color, normal_color, specular_color, gloss_color);
 }
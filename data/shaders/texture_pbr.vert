@@ -2,15 +2,16 @@
 
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec3 in_color;
-layout (location = 2) in vec3 in_normal;
+layout (location = 2) in vec2 in_normal;  // octahedral
 layout (location = 3) in vec2 in_uv;
-layout (location = 4) in vec3 in_tangent;
+layout (location = 4) in vec2 in_tangent; // octahedral
 
 layout (location = 0) out vec3 out_color;
 layout (location = 1) out vec3 out_position;
 layout (location = 2) out vec3 out_normal;
 layout (location = 3) out vec2 out_uv;
 layout (location = 4) out vec3 out_tangent;
+layout (location = 5) flat out ivec4 out_texture_indices;
 
 struct point_light
 {
@@ -28,23 +29,42 @@ layout (set = 0, binding = 0) uniform global_ubo
     int num_lights;
 } ubo;
 
-// There must be no more than one push constant block statically used per shader entry point.
-layout (push_constant) uniform Push
+struct object_data
 {
-    mat4 model_matrix;
-    mat4 normal_matrix;
-    int  shading_mode;
-    bool use_normal_map;
-} push;
+    mat4  model_matrix;
+    mat3  normal_matrix;
+    vec4  base_color;      // w is metallic
+    vec4  material;        // x is roughness
+    ivec4 texture_indices; // diffuse, normal, specular, glossiness
+    vec4  uv_transform;    // xy offset, zw scale of the packed uvs
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer object_buffer
+{
+    object_data objects[];
+};
+
+// Inverse of the octahedral packing in model::pack()
+vec3 decode_octahedral(vec2 folded)
+{
+    vec3 direction = vec3(folded, 1.0f - abs(folded.x) - abs(folded.y));
+    float t        = max(-direction.z, 0.0f);
+    direction.xy  += vec2(direction.x >= 0.0f ? -t : t, direction.y >= 0.0f ? -t : t);
+    return normalize(direction);
+}
 
 void main()
 {
-    vec4 position_world = push.model_matrix * vec4(in_position, 1.0f);
+    object_data object = objects[gl_InstanceIndex];
+    
+    vec4 position_world = object.model_matrix * vec4(in_position, 1.0f);
     gl_Position         = ubo.projection * (ubo.view * position_world);
 
-    out_normal   = normalize(mat3(push.normal_matrix) * in_normal);
-    out_tangent  = normalize(mat3(push.normal_matrix) * in_tangent.xyz);
+    out_normal   = normalize(object.normal_matrix * decode_octahedral(in_normal));
+    out_tangent  = normalize(object.normal_matrix * decode_octahedral(in_tangent));
     out_position = position_world.xyz;
     out_color    = in_color;
-    out_uv       = in_uv;
+    out_uv       = object.uv_transform.xy + in_uv * object.uv_transform.zw;
+
+    out_texture_indices = object.texture_indices;
 }
\ No newline at end of file
@@ -0,0 +1,546 @@
+﻿#include "benchmarks.h"
+
+// Project includes
+#include "src/core/bvh.h"
+#include "src/core/frustum_culler.h"
+#include "src/core/game_object.h"
+#include "src/core/mesh_cache.h"
+#include "src/core/mesh_optimizer.h"
+#include "src/core/transform_kernel.h"
+#include "src/engine/engine.h"
+#include "src/engine/job_system.h"
+#include "src/utility/utils.h"
+
+// Standard includes
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(CMAKE_BUILD)
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../../../"
+#endif
+#else
+#ifndef ENGINE_DIR
+#define ENGINE_DIR ""
+#endif
+#endif
+
+namespace dae
+{
+    namespace
+    {
+        using clock = std::chrono::high_resolution_clock;
+        using isa   = transform_kernel::isa;
+
+        auto elapsed_ms(clock::time_point start) -> double
+        {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        }
+
+        // Average over iterations runs of work
+        template <typename work_type>
+        auto average_ms(int iterations, work_type &&work) -> double
+        {
+            auto const start = clock::now();
+            for (int iteration = 0; iteration < iterations; ++iteration)
+            {
+                work();
+            }
+            return elapsed_ms(start) / static_cast<double>(std::max(iterations, 1));
+        }
+
+        // Starts a table row with its label left aligned in a column of width characters
+        auto row(std::string_view label, int width = 12) -> std::ostream &
+        {
+            return std::cout << ONE_TAB << std::left << std::setw(width) << label;
+        }
+
+        // Batch paths this CPU runs; the enum is ordered, so everything up to the best one is supported
+        auto batch_isas() -> std::vector<isa>
+        {
+            std::vector<isa> targets{};
+            for (auto const target : {isa::sse2, isa::avx2})
+            {
+                if (target <= transform_kernel::best_isa())
+                {
+                    targets.push_back(target);
+                }
+            }
+            return targets;
+        }
+
+        // A 50 degree 16:9 camera at the origin looking down +z, like the engine's default projection
+        auto camera_frustum(float far) -> frustum_culler::planes
+        {
+            float const tan_half_fovy = std::tan(glm::radians(25.0f));
+            glm::mat4 clip{0.0f};
+            clip[0][0] = 1.0f / (16.0f / 9.0f * tan_half_fovy);
+            clip[1][1] = 1.0f / tan_half_fovy;
+            clip[2][2] = far / (far - 0.1f);
+            clip[2][3] = 1.0f;
+            clip[3][2] = -(far * 0.1f) / (far - 0.1f);
+            clip = glm::transpose(clip);
+            frustum_culler::planes frustum{clip[3] + clip[0], clip[3] - clip[0], clip[3] + clip[1], clip[3] - clip[1], clip[2], clip[3] - clip[2]};
+            for (auto &plane : frustum)
+            {
+                plane /= glm::length(glm::vec3{plane});
+            }
+            return frustum;
+        }
+
+        // The bundled OBJ files, sorted, relative to the data directory
+        auto model_files(std::filesystem::path const &root) -> std::vector<std::filesystem::path>
+        {
+            std::vector<std::filesystem::path> files{};
+            for (auto const &entry : std::filesystem::directory_iterator{root / "assets/models"})
+            {
+                if (entry.is_regular_file() and entry.path().extension() == ".obj")
+                {
+                    files.push_back(entry.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            return files;
+        }
+
+        auto data_root() -> std::filesystem::path
+        {
+            engine::data_path = "data/";
+            return ENGINE_DIR + engine::data_path;
+        }
+
+        // Loading every bundled model without its mesh cache and with it
+        void mesh_cache_benchmark(int)
+        {
+            auto const root = data_root();
+            std::cout << '\n' << YELLOW_TEXT("[Mesh Cache Benchmark]") << '\n';
+            double total_cold = 0.0;
+            double total_warm = 0.0;
+            for (auto const &file : model_files(root))
+            {
+                std::string const relative_path = std::filesystem::relative(file, root).generic_string();
+                mesh_cache::remove(file.string());
+
+                model::builder cold{};
+                auto start = clock::now();
+                cold.load_model(relative_path);
+                double const cold_ms = elapsed_ms(start);
+
+                model::builder warm{};
+                start = clock::now();
+                warm.load_model(relative_path);
+                double const warm_ms = elapsed_ms(start);
+
+                total_cold += cold_ms;
+                total_warm += warm_ms;
+                row(file.filename().string(), 20)
+                    << "cold: " << std::fixed << std::setprecision(2) << std::setw(10) << cold_ms
+                    << "warm: " << std::setw(10) << warm_ms
+                    << "speedup: " << cold_ms / std::max(warm_ms, 0.001) << "x\n";
+            }
+            row("total", 20)
+                << "cold: " << std::fixed << std::setprecision(2) << std::setw(10) << total_cold
+                << "warm: " << std::setw(10) << total_warm
+                << "speedup: " << total_cold / std::max(total_warm, 0.001) << "x\n";
+        }
+
+        // Cache efficiency of every bundled model before and after the mesh optimizer
+        void mesh_optimizer_benchmark(int)
+        {
+            auto const root = data_root();
+            std::cout << '\n' << YELLOW_TEXT("[Mesh Optimizer Benchmark]") << " (FIFO cache of " << mesh_optimizer::cache_size << " vertices)\n";
+            for (auto const &file : model_files(root))
+            {
+                std::string const relative_path = std::filesystem::relative(file, root).generic_string();
+
+                model::builder builder{};
+                builder.optimize = false;
+                builder.load_model(relative_path);
+                auto const before = mesh_optimizer::analyze(builder);
+
+                auto const start = clock::now();
+                mesh_optimizer::optimize(builder);
+                double const optimize_ms = elapsed_ms(start);
+                auto const after = mesh_optimizer::analyze(builder);
+
+                // Leave the optimized mesh behind so the next regular load hits the cache
+                builder.optimize = true;
+                mesh_cache::save(file.string(), builder);
+
+                row(file.filename().string(), 20)
+                    << "triangles: " << std::setw(10) << before.triangle_count
+                    << std::fixed << std::setprecision(3)
+                    << "ACMR: " << before.acmr << " -> " << std::setw(8) << after.acmr
+                    << "ATVR: " << before.atvr << " -> " << std::setw(8) << after.atvr
+                    << std::setprecision(2) << "time: " << optimize_ms << " ms\n";
+            }
+        }
+
+        // Per-frame matrix cost for mostly static objects, recomputed every frame vs cached
+        void transforms_benchmark(int object_count)
+        {
+            constexpr int   frame_count   = 100;
+            constexpr float dynamic_ratio = 0.01f;
+
+            std::mt19937 rng{42};
+            std::uniform_real_distribution<float> dist{-10.0f, 10.0f};
+            std::vector<transform_component> transforms(static_cast<size_t>(std::max(object_count, 1)));
+            for (auto &transform : transforms)
+            {
+                transform.set_translation({dist(rng), dist(rng), dist(rng)});
+                transform.set_rotation({dist(rng), dist(rng), dist(rng)});
+                transform.set_scale(glm::vec3{1.0f + std::abs(dist(rng)) * 0.1f});
+            }
+            size_t const dynamic_count = static_cast<size_t>(static_cast<float>(transforms.size()) * dynamic_ratio);
+            std::uniform_int_distribution<size_t> pick{0, transforms.size() - 1};
+
+            // Printed with the results, so the optimizer cannot discard the matrices
+            float checksum = 0.0f;
+            auto const consume = [&checksum](glm::mat4 const &matrix, glm::mat4 const &normal)
+            {
+                checksum += matrix[3][0] + normal[0][0];
+            };
+
+            double uncached_ms = 0.0;
+            double cached_ms   = 0.0;
+            for (int frame = 0; frame < frame_count; ++frame)
+            {
+                for (size_t i = 0; i < dynamic_count; ++i)
+                {
+                    auto &transform = transforms[pick(rng)];
+                    transform.set_rotation(transform.rotation() + glm::vec3{0.0f, 0.01f, 0.0f});
+                }
+
+                uncached_ms += average_ms(1, [&]
+                {
+                    for (auto const &transform : transforms)
+                    {
+                        consume(transform_component::make_matrix(transform.translation(), transform.rotation(), transform.scale()),
+                                transform_component::make_normal_matrix(transform.rotation(), transform.scale()));
+                    }
+                });
+                cached_ms += average_ms(1, [&]
+                {
+                    for (auto const &transform : transforms)
+                    {
+                        consume(transform.mat4(), transform.normal_matrix());
+                    }
+                });
+            }
+
+            std::cout << '\n' << YELLOW_TEXT("[Transform Benchmark]") << '\n';
+            std::cout << ONE_TAB << "objects: " << transforms.size() << ", dynamic per frame: " << dynamic_count
+                      << ", frames: " << frame_count << '\n';
+            row("uncached") << std::fixed << std::setprecision(3) << uncached_ms / frame_count << " ms/frame\n";
+            row("cached") << cached_ms / frame_count << " ms/frame\n";
+            row("speedup") << uncached_ms / std::max(cached_ms, 0.001) << "x\n";
+            row("checksum") << checksum << '\n';
+        }
+
+        // Per-object glm path vs every supported batch path of transform_kernel
+        void transform_kernel_benchmark(int object_count)
+        {
+            constexpr int iteration_count = 20;
+
+            size_t const count = static_cast<size_t>(std::max(object_count, 1));
+            std::mt19937 rng{42};
+            std::uniform_real_distribution<float> position{-10.0f, 10.0f};
+            std::uniform_real_distribution<float> angle{-glm::pi<float>(), glm::pi<float>()};
+            std::uniform_real_distribution<float> scale{0.5f, 2.0f};
+
+            std::vector<float> data(count * 9);
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t component = 0; component < 9; ++component)
+                {
+                    auto &value = data[component * count + i];
+                    value = component < 3 ? position(rng) : component < 6 ? angle(rng) : scale(rng);
+                }
+            }
+            transform_kernel::input const in{
+                data.data() + count * 0, data.data() + count * 1, data.data() + count * 2,
+                data.data() + count * 3, data.data() + count * 4, data.data() + count * 5,
+                data.data() + count * 6, data.data() + count * 7, data.data() + count * 8
+            };
+
+            std::vector<glm::mat4> reference_matrices(count);
+            std::vector<glm::mat4> reference_normals(count);
+            std::vector<glm::mat4> matrices(count);
+            std::vector<glm::mat4> normals(count);
+
+            std::cout << '\n' << YELLOW_TEXT("[Transform Kernel Benchmark]") << '\n';
+            std::cout << ONE_TAB << "objects: " << count << ", iterations: " << iteration_count
+                      << ", selected: " << transform_kernel::isa_name(transform_kernel::best_isa()) << '\n';
+
+            // Baseline: the per-object glm path as transform_component uses it, on AoS input
+            std::vector<transform_component> transforms(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                transforms[i].set_translation({in.translation_x[i], in.translation_y[i], in.translation_z[i]});
+                transforms[i].set_rotation({in.rotation_x[i], in.rotation_y[i], in.rotation_z[i]});
+                transforms[i].set_scale({in.scale_x[i], in.scale_y[i], in.scale_z[i]});
+            }
+            double const glm_ms = average_ms(iteration_count, [&]
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    auto const &transform = transforms[i];
+                    reference_matrices[i] = transform_component::make_matrix(transform.translation(), transform.rotation(), transform.scale());
+                    reference_normals[i] = transform_component::make_normal_matrix(transform.rotation(), transform.scale());
+                }
+            });
+            row("glm") << std::fixed << std::setprecision(3) << glm_ms << " ms\n";
+
+            auto targets = batch_isas();
+            targets.insert(targets.begin(), isa::scalar);
+            for (auto const target : targets)
+            {
+                double const ms = average_ms(iteration_count, [&] { transform_kernel::compute(target, in, count, matrices.data(), normals.data()); });
+
+                float max_error = 0.0f;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (int column = 0; column < 4; ++column)
+                    {
+                        for (int row = 0; row < 4; ++row)
+                        {
+                            max_error = std::max(max_error, std::abs(matrices[i][column][row] - reference_matrices[i][column][row]));
+                            max_error = std::max(max_error, std::abs(normals[i][column][row] - reference_normals[i][column][row]));
+                        }
+                    }
+                }
+                row(transform_kernel::isa_name(target)) << std::fixed << std::setprecision(3) << ms << " ms"
+                    << ONE_TAB << "speedup: " << glm_ms / std::max(ms, 0.001) << "x"
+                    << ONE_TAB << "max error: " << std::scientific << max_error << '\n';
+            }
+        }
+
+        // Scalar vs every supported batch path of frustum_culler
+        void culling_benchmark(int object_count)
+        {
+            constexpr int iteration_count = 50;
+
+            size_t const count = static_cast<size_t>(std::max(object_count, 1));
+            std::mt19937 rng{42};
+            std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+            std::uniform_real_distribution<float> extent{0.1f, 2.0f};
+
+            std::vector<float> data(count * 6);
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t component = 0; component < 6; ++component)
+                {
+                    data[component * count + i] = component < 3 ? position(rng) : extent(rng);
+                }
+            }
+            frustum_culler::input const in{
+                data.data() + count * 0, data.data() + count * 1, data.data() + count * 2,
+                data.data() + count * 3, data.data() + count * 4, data.data() + count * 5
+            };
+            auto const frustum = camera_frustum(100.0f);
+
+            std::vector<uint8_t> reference(count);
+            std::vector<uint8_t> visible(count);
+
+            std::cout << '\n' << YELLOW_TEXT("[Frustum Culling Benchmark]") << '\n';
+            std::cout << ONE_TAB << "objects: " << count << ", iterations: " << iteration_count
+                      << ", selected: " << transform_kernel::isa_name(transform_kernel::best_isa()) << '\n';
+
+            size_t reference_count = 0;
+            double const scalar_ms = average_ms(iteration_count, [&] { reference_count = frustum_culler::cull(isa::scalar, frustum, in, count, reference.data()); });
+            row("scalar") << std::fixed << std::setprecision(3) << scalar_ms << " ms"
+                << ONE_TAB << "visible: " << reference_count << '\n';
+
+            for (auto const target : batch_isas())
+            {
+                size_t visible_count = 0;
+                double const ms = average_ms(iteration_count, [&] { visible_count = frustum_culler::cull(target, frustum, in, count, visible.data()); });
+                row(transform_kernel::isa_name(target)) << std::fixed << std::setprecision(3) << ms << " ms"
+                    << ONE_TAB << "speedup: " << scalar_ms / std::max(ms, 0.001) << "x"
+                    << ONE_TAB << "matches scalar: " << (visible == reference and visible_count == reference_count ? "yes" : "no") << '\n';
+            }
+        }
+
+        // Build, refit and the three queries of a bvh at one object count, against the linear culling kernel
+        void bvh_benchmark(size_t count)
+        {
+            // Constant density: the cube grows with the object count, so the frustum sees a similar share of it
+            float const side = 4.0f * std::cbrt(static_cast<float>(count));
+            std::mt19937 rng{42};
+            std::uniform_real_distribution<float> position{-side * 0.5f, side * 0.5f};
+            std::uniform_real_distribution<float> extent{0.1f, 1.0f};
+            std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+
+            std::vector<bvh::box> boxes(count);
+            for (auto &b : boxes)
+            {
+                glm::vec3 const center{position(rng), position(rng), position(rng)};
+                glm::vec3 const half{extent(rng), extent(rng), extent(rng)};
+                b = {center - half, center + half};
+            }
+
+            bvh tree;
+            double const serial_build_ms = average_ms(1, [&] { tree.build(boxes, false); });
+            double const parallel_build_ms = average_ms(1, [&] { tree.build(boxes, true); });
+            float const built_cost = tree.sah_cost();
+            double const full_refit_ms = average_ms(1, [&] { tree.refit(boxes); });
+
+            // 1% of the objects move a little every frame, for 60 frames
+            std::vector<uint32_t> moved(count / 100);
+            std::uniform_int_distribution<uint32_t> pick{0, static_cast<uint32_t>(count - 1)};
+            double incremental_refit_ms = 0.0;
+            for (int frame = 0; frame < 60; ++frame)
+            {
+                for (auto &item : moved)
+                {
+                    item = pick(rng);
+                    glm::vec3 const offset{unit(rng) * 0.1f, unit(rng) * 0.1f, unit(rng) * 0.1f};
+                    boxes[item].min += offset;
+                    boxes[item].max += offset;
+                }
+                incremental_refit_ms += average_ms(1, [&] { tree.refit(boxes, moved); });
+            }
+            incremental_refit_ms /= 60.0;
+
+            // In the middle of the cube, seeing a quarter of its side far
+            auto const frustum = camera_frustum(side * 0.25f);
+
+            std::vector<float> soa(count * 6);
+            for (size_t i = 0; i < count; ++i)
+            {
+                glm::vec3 const center = (boxes[i].min + boxes[i].max) * 0.5f;
+                glm::vec3 const half = (boxes[i].max - boxes[i].min) * 0.5f;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    soa[axis * count + i] = center[axis];
+                    soa[(axis + 3) * count + i] = half[axis];
+                }
+            }
+            frustum_culler::input const in{
+                soa.data() + count * 0, soa.data() + count * 1, soa.data() + count * 2,
+                soa.data() + count * 3, soa.data() + count * 4, soa.data() + count * 5
+            };
+            std::vector<uint8_t> linear_visible(count);
+            std::vector<uint8_t> tree_visible(count);
+            size_t linear_count = 0;
+            double const linear_cull_ms = average_ms(1, [&] { linear_count = frustum_culler::cull(frustum, in, count, linear_visible.data()); });
+            uint32_t boxes_tested = 0;
+            size_t tree_count = 0;
+            double const tree_cull_ms = average_ms(1, [&] { tree_count = tree.cull(frustum, tree_visible.data(), boxes_tested); });
+
+            constexpr int query_count = 1000;
+            size_t hits = 0;
+            double const ray_us = average_ms(query_count, [&]
+            {
+                glm::vec3 const origin{position(rng), position(rng), -side};
+                glm::vec3 const direction{unit(rng) * 0.2f, unit(rng) * 0.2f, 1.0f};
+                hits += tree.raycast(origin, direction).item != bvh::invalid_item ? 1 : 0;
+            }) * 1000.0;
+
+            std::vector<uint32_t> found;
+            double const sphere_us = average_ms(query_count, [&]
+            {
+                tree.overlap_sphere({position(rng), position(rng), position(rng)}, 5.0f, found);
+            }) * 1000.0;
+
+            std::cout << ONE_TAB << "objects: " << count << ONE_TAB << "nodes: " << tree.node_count() << '\n' << std::fixed << std::setprecision(3)
+                      << ONE_TAB << ONE_TAB << "build: " << serial_build_ms << " ms serial, " << parallel_build_ms << " ms parallel" << '\n'
+                      << ONE_TAB << ONE_TAB << "refit: " << full_refit_ms << " ms all, " << incremental_refit_ms << " ms for 1% moved"
+                      << ONE_TAB << "sah cost: " << built_cost << " -> " << tree.sah_cost() << " after 60 frames" << '\n'
+                      << ONE_TAB << ONE_TAB << "cull: " << tree_cull_ms << " ms, " << boxes_tested << " boxes tested"
+                      << ONE_TAB << "linear kernel: " << linear_cull_ms << " ms" << ONE_TAB << "visible: " << tree_count
+                      << (tree_count == linear_count and tree_visible == linear_visible ? " (matches)" : " (MISMATCH)") << '\n'
+                      << ONE_TAB << ONE_TAB << "raycast: " << ray_us << " us (" << hits << " of " << query_count << " hit)"
+                      << ONE_TAB << "sphere r=5: " << sphere_us << " us, " << static_cast<double>(found.size()) / query_count << " objects avg" << '\n';
+        }
+
+        // Without a size, 10k, 100k and 1M objects
+        void bvh_benchmarks(int object_count)
+        {
+            std::cout << '\n' << YELLOW_TEXT("[BVH Benchmark]") << '\n';
+            std::cout << ONE_TAB << "threads: " << job_system::instance().thread_count() << '\n';
+            auto const object_counts = object_count > 0 ? std::vector<int>{object_count} : std::vector<int>{10000, 100000, 1000000};
+            for (auto const count : object_counts)
+            {
+                bvh_benchmark(static_cast<size_t>(count));
+            }
+        }
+
+        // Serial vs parallel_for at several grain sizes
+        void jobs_benchmark(int item_count)
+        {
+            auto &jobs = job_system::instance();
+            size_t const count = static_cast<size_t>(std::max(item_count, 1));
+            std::vector<glm::mat4> matrices(count);
+
+            // One world matrix per item: enough work to be realistic, small enough that scheduling overhead shows
+            auto const work = [&matrices](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float const x = static_cast<float>(i);
+                    matrices[i] = transform_component::make_matrix({x, 0.0f, 0.0f}, {x * 0.001f, x * 0.002f, x * 0.003f}, glm::vec3{1.0f});
+                }
+            };
+            constexpr int iteration_count = 10;
+
+            std::cout << '\n' << YELLOW_TEXT("[Job System Benchmark]") << '\n';
+            std::cout << ONE_TAB << "items: " << count << ", threads: " << jobs.thread_count() << '\n';
+
+            double const serial_ms = average_ms(iteration_count, [&] { work(0, count); });
+            row("serial", 16) << std::fixed << std::setprecision(3) << serial_ms << " ms"
+                << ONE_TAB << count / serial_ms / 1000.0 << " M items/s\n";
+
+            for (size_t const grain_size : {64, 256, 1024, 4096, 16384})
+            {
+                double const ms = average_ms(iteration_count, [&] { jobs.parallel_for(count, grain_size, work); });
+                row("grain " + std::to_string(grain_size), 16) << ms << " ms"
+                    << ONE_TAB << count / ms / 1000.0 << " M items/s"
+                    << ONE_TAB << "speedup: " << serial_ms / std::max(ms, 0.001) << "x\n";
+            }
+        }
+
+        struct benchmark_entry
+        {
+            std::string_view flag;
+            int              default_size;
+            void           (*run)(int size);
+        };
+
+        constexpr std::array benchmark_entries{
+            benchmark_entry{"--benchmark-mesh-cache",       0,       mesh_cache_benchmark},
+            benchmark_entry{"--benchmark-mesh-optimizer",   0,       mesh_optimizer_benchmark},
+            benchmark_entry{"--benchmark-transforms",       100000,  transforms_benchmark},
+            benchmark_entry{"--benchmark-transform-kernel", 100000,  transform_kernel_benchmark},
+            benchmark_entry{"--benchmark-culling",          100000,  culling_benchmark},
+            benchmark_entry{"--benchmark-bvh",              0,       bvh_benchmarks},
+            benchmark_entry{"--benchmark-jobs",             1000000, jobs_benchmark},
+        };
+    }
+
+    auto benchmarks::run(int argc, char *argv[]) -> bool
+    {
+        if (argc < 2)
+        {
+            return false;
+        }
+        std::string_view const flag{argv[1]};
+        auto const entry = std::find_if(benchmark_entries.begin(), benchmark_entries.end(), [flag](auto const &e) { return e.flag == flag; });
+        if (entry == benchmark_entries.end())
+        {
+            return false;
+        }
+        entry->run(argc > 2 ? std::atoi(argv[2]) : entry->default_size);
+        return true;
+    }
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+
+namespace dae
+{
+    // Standalone measurements of engine subsystems, selected with a --benchmark-* flag instead of running the engine.
+    // Each prints its own table; none of them needs a window or a device.
+    struct benchmarks final
+    {
+        // Runs the benchmark argv[1] names with argv[2], when given, as its size; false when argv[1] names none
+        static auto run(int argc, char *argv[]) -> bool;
+    };
+}
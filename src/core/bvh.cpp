@@ -0,0 +1,484 @@
+﻿#include "bvh.h"
+
+// Project includes
+#include "src/engine/job_system.h"
+
+// Standard includes
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace dae
+{
+    namespace
+    {
+        constexpr uint32_t bin_count      = 16;
+        constexpr float    traversal_cost = 1.0f; // relative to one box test
+        constexpr uint32_t all_planes     = 0b111111;
+
+        auto half_area(glm::vec3 const &min, glm::vec3 const &max) -> float
+        {
+            glm::vec3 const size = glm::max(max - min, glm::vec3{0.0f});
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        // -1 outside, 1 inside every plane in mask, 0 straddling; mask loses the planes the box is inside of
+        auto classify(frustum_culler::planes const &frustum, glm::vec3 const &min, glm::vec3 const &max, uint32_t &mask) -> int
+        {
+            glm::vec3 const center = (min + max) * 0.5f;
+            glm::vec3 const extent = (max - min) * 0.5f;
+            for (uint32_t p = 0; p < 6; ++p)
+            {
+                if (not (mask & (1u << p)))
+                {
+                    continue;
+                }
+                auto const &plane = frustum[p];
+                float const distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                float const reach = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+                if (distance + reach < 0.0f)
+                {
+                    return -1;
+                }
+                if (distance - reach >= 0.0f)
+                {
+                    mask &= ~(1u << p);
+                }
+            }
+            return mask == 0 ? 1 : 0;
+        }
+
+        // Entry distance of the ray into the box, or a negative value when it misses within max_distance
+        auto intersect(glm::vec3 const &origin, glm::vec3 const &inverse_direction, float max_distance, glm::vec3 const &min, glm::vec3 const &max) -> float
+        {
+            glm::vec3 const t0 = (min - origin) * inverse_direction;
+            glm::vec3 const t1 = (max - origin) * inverse_direction;
+            glm::vec3 const near = glm::min(t0, t1);
+            glm::vec3 const far = glm::max(t0, t1);
+            float const enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+            float const exit = std::min(std::min(far.x, far.y), std::min(far.z, max_distance));
+            return enter <= exit ? enter : -1.0f;
+        }
+
+        auto overlaps(glm::vec3 const &center, float radius_squared, glm::vec3 const &min, glm::vec3 const &max) -> bool
+        {
+            glm::vec3 const offset = center - glm::clamp(center, min, max);
+            return glm::dot(offset, offset) <= radius_squared;
+        }
+    }
+
+    void bvh::build(std::vector<box> const &boxes, bool parallel)
+    {
+        auto const count = static_cast<uint32_t>(boxes.size());
+        entries_.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            entries_[i] = {boxes[i].min, i, boxes[i].max, 0};
+        }
+        leaf_of_.assign(count, 0);
+
+        // A binary tree with at least one item per leaf never has more than 2n - 1 nodes
+        nodes_.resize(std::max(count * 2, 2u) - 1);
+        ranges_.resize(nodes_.size());
+        parents_.resize(nodes_.size());
+        dirty_.assign(nodes_.size(), 0);
+        parents_[0] = 0;
+        ranges_[0] = {0, count};
+        node_count_.store(1, std::memory_order_relaxed);
+        if (count == 0)
+        {
+            nodes_[0] = {glm::vec3{0.0f}, 0, glm::vec3{0.0f}, 0};
+        }
+        else
+        {
+            build_node(0, 0, count, 0, parallel);
+        }
+
+        items_.resize(count);
+        item_boxes_.resize(count);
+        slot_of_.resize(count);
+        for (uint32_t slot = 0; slot < count; ++slot)
+        {
+            auto const &entry = entries_[slot];
+            items_[slot] = entry.item;
+            item_boxes_[slot] = {entry.min, entry.max};
+            slot_of_[entry.item] = slot;
+        }
+        entries_.clear();
+    }
+
+    void bvh::build_node(uint32_t node_index, uint32_t first, uint32_t count, uint32_t depth, bool parallel)
+    {
+        assert(depth <= max_depth and "BVH deeper than its traversal stacks allow");
+
+        // Centroids are kept doubled, (min + max), which bins the same and saves the multiply
+        box bounds{};
+        box centroid_bounds{};
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            auto const &entry = entries_[i];
+            bounds.min = glm::min(bounds.min, entry.min);
+            bounds.max = glm::max(bounds.max, entry.max);
+            glm::vec3 const centroid = entry.min + entry.max;
+            centroid_bounds.min = glm::min(centroid_bounds.min, centroid);
+            centroid_bounds.max = glm::max(centroid_bounds.max, centroid);
+        }
+        auto &current = nodes_[node_index];
+        current.min = bounds.min;
+        current.max = bounds.max;
+        ranges_[node_index] = {first, count};
+
+        auto const make_leaf = [&]
+        {
+            current.first = first;
+            current.count = count;
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                leaf_of_[entries_[i].item] = node_index;
+            }
+        };
+        if (count <= max_leaf_items)
+        {
+            make_leaf();
+            return;
+        }
+
+        uint32_t left_count = 0;
+        if (depth >= max_sah_depth)
+        {
+            // SAH can keep splitting off a few items per level on clustered input; median splits on the widest
+            // centroid axis halve the count every level, which bounds the tree depth
+            glm::vec3 const centroid_extent = centroid_bounds.max - centroid_bounds.min;
+            int const axis = centroid_extent.x >= centroid_extent.y and centroid_extent.x >= centroid_extent.z ? 0 : centroid_extent.y >= centroid_extent.z ? 1 : 2;
+            left_count = count / 2;
+            std::nth_element(entries_.begin() + first, entries_.begin() + first + left_count, entries_.begin() + first + count,
+                [axis](build_entry const &lhs, build_entry const &rhs)
+                {
+                    return lhs.min[axis] + lhs.max[axis] < rhs.min[axis] + rhs.max[axis];
+                });
+        }
+        else
+        {
+            // Binned SAH over all three axes: bin the centroids, then sweep the bins from both sides
+            float    best_cost  = std::numeric_limits<float>::max();
+            int      best_axis  = -1;
+            uint32_t best_split = 0;
+            glm::vec3 const centroid_extent = centroid_bounds.max - centroid_bounds.min;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (centroid_extent[axis] <= 0.0f)
+                {
+                    continue;
+                }
+                std::array<box, bin_count>      bins{};
+                std::array<uint32_t, bin_count> bin_items{};
+                float const scale = static_cast<float>(bin_count) / centroid_extent[axis];
+                for (uint32_t i = first; i < first + count; ++i)
+                {
+                    auto const &entry = entries_[i];
+                    auto const bin = std::min(static_cast<uint32_t>((entry.min[axis] + entry.max[axis] - centroid_bounds.min[axis]) * scale), bin_count - 1);
+                    bins[bin].min = glm::min(bins[bin].min, entry.min);
+                    bins[bin].max = glm::max(bins[bin].max, entry.max);
+                    ++bin_items[bin];
+                }
+
+                std::array<float, bin_count - 1> left_cost{};
+                box      left{};
+                uint32_t left_items = 0;
+                for (uint32_t split = 0; split < bin_count - 1; ++split)
+                {
+                    left.min = glm::min(left.min, bins[split].min);
+                    left.max = glm::max(left.max, bins[split].max);
+                    left_items += bin_items[split];
+                    left_cost[split] = left_items == 0 ? 0.0f : half_area(left.min, left.max) * static_cast<float>(left_items);
+                }
+                box      right{};
+                uint32_t right_items = 0;
+                for (uint32_t split = bin_count - 1; split > 0; --split)
+                {
+                    right.min = glm::min(right.min, bins[split].min);
+                    right.max = glm::max(right.max, bins[split].max);
+                    right_items += bin_items[split];
+                    float const cost = left_cost[split - 1] + half_area(right.min, right.max) * static_cast<float>(right_items);
+                    if (right_items < count and cost < best_cost)
+                    {
+                        best_cost  = cost;
+                        best_axis  = axis;
+                        best_split = split;
+                    }
+                }
+            }
+
+            if (best_axis >= 0)
+            {
+                float const leaf_cost = static_cast<float>(count);
+                float const split_cost = traversal_cost + best_cost / half_area(bounds.min, bounds.max);
+                if (split_cost >= leaf_cost and count <= max_leaf_items * 4)
+                {
+                    make_leaf();
+                    return;
+                }
+
+                float const scale = static_cast<float>(bin_count) / centroid_extent[best_axis];
+                float const offset = centroid_bounds.min[best_axis];
+                auto const middle = std::partition(entries_.begin() + first, entries_.begin() + first + count, [&](build_entry const &entry)
+                {
+                    return std::min(static_cast<uint32_t>((entry.min[best_axis] + entry.max[best_axis] - offset) * scale), bin_count - 1) < best_split;
+                });
+                left_count = static_cast<uint32_t>(middle - (entries_.begin() + first));
+            }
+        }
+        if (left_count == 0 or left_count == count)
+        {
+            // Every centroid in one spot; any split is as good as another
+            left_count = count / 2;
+        }
+
+        uint32_t const left_index = node_count_.fetch_add(2, std::memory_order_relaxed);
+        current.first = left_index;
+        current.count = 0;
+        parents_[left_index]     = node_index;
+        parents_[left_index + 1] = node_index;
+
+        if (parallel and count > parallel_threshold)
+        {
+            job_counter counter;
+            job_system::instance().run([this, left_index, first, left_count, count, depth]
+            {
+                build_node(left_index + 1, first + left_count, count - left_count, depth + 1, true);
+            }, &counter);
+            build_node(left_index, first, left_count, depth + 1, true);
+            job_system::instance().wait(counter);
+        }
+        else
+        {
+            build_node(left_index, first, left_count, depth + 1, parallel);
+            build_node(left_index + 1, first + left_count, count - left_count, depth + 1, parallel);
+        }
+    }
+
+    void bvh::refit(std::vector<box> const &boxes)
+    {
+        for (uint32_t slot = 0; slot < items_.size(); ++slot)
+        {
+            item_boxes_[slot] = boxes[items_[slot]];
+        }
+        for (uint32_t node_index = node_count(); node_index-- > 0;)
+        {
+            refit_node(node_index);
+        }
+    }
+
+    void bvh::refit(std::vector<box> const &boxes, std::vector<uint32_t> const &moved)
+    {
+        // Mark the paths up to the root, stopping where another item's path already did
+        dirty_nodes_.clear();
+        for (auto const item : moved)
+        {
+            item_boxes_[slot_of_[item]] = boxes[item];
+            for (uint32_t node_index = leaf_of_[item]; not dirty_[node_index]; node_index = parents_[node_index])
+            {
+                dirty_[node_index] = 1;
+                dirty_nodes_.push_back(node_index);
+                if (node_index == 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        std::sort(dirty_nodes_.begin(), dirty_nodes_.end(), std::greater{});
+        for (auto const node_index : dirty_nodes_)
+        {
+            refit_node(node_index);
+            dirty_[node_index] = 0;
+        }
+    }
+
+    void bvh::refit_node(uint32_t node_index)
+    {
+        auto &current = nodes_[node_index];
+        box bounds{};
+        if (current.count > 0)
+        {
+            for (uint32_t slot = current.first; slot < current.first + current.count; ++slot)
+            {
+                bounds.min = glm::min(bounds.min, item_boxes_[slot].min);
+                bounds.max = glm::max(bounds.max, item_boxes_[slot].max);
+            }
+        }
+        else
+        {
+            auto const &left = nodes_[current.first];
+            auto const &right = nodes_[current.first + 1];
+            bounds.min = glm::min(left.min, right.min);
+            bounds.max = glm::max(left.max, right.max);
+        }
+        current.min = bounds.min;
+        current.max = bounds.max;
+    }
+
+    auto bvh::cull(frustum_culler::planes const &frustum, uint8_t *visible, uint32_t &boxes_tested) const -> size_t
+    {
+        std::fill_n(visible, items_.size(), uint8_t{0});
+        boxes_tested = 0;
+        if (items_.empty())
+        {
+            return 0;
+        }
+
+        struct entry
+        {
+            uint32_t node_index;
+            uint32_t mask;
+        };
+        std::array<entry, stack_capacity> stack{};
+        uint32_t stack_size = 0;
+        stack[stack_size++] = {0, all_planes};
+
+        size_t visible_count = 0;
+        while (stack_size > 0)
+        {
+            auto [node_index, mask] = stack[--stack_size];
+            auto const &current = nodes_[node_index];
+            if (mask != 0 and classify(frustum, current.min, current.max, mask) < 0)
+            {
+                continue;
+            }
+            if (mask == 0)
+            {
+                auto const [first, count] = ranges_[node_index];
+                for (uint32_t slot = first; slot < first + count; ++slot)
+                {
+                    visible[items_[slot]] = 1;
+                }
+                visible_count += count;
+                continue;
+            }
+            if (current.count == 0)
+            {
+                assert(stack_size + 2 <= stack.size() and "BVH deeper than its traversal stack");
+                stack[stack_size++] = {current.first + 1, mask};
+                stack[stack_size++] = {current.first, mask};
+                continue;
+            }
+            boxes_tested += current.count;
+            for (uint32_t slot = current.first; slot < current.first + current.count; ++slot)
+            {
+                uint32_t item_mask = mask;
+                if (classify(frustum, item_boxes_[slot].min, item_boxes_[slot].max, item_mask) < 0)
+                {
+                    continue;
+                }
+                visible[items_[slot]] = 1;
+                ++visible_count;
+            }
+        }
+        return visible_count;
+    }
+
+    auto bvh::raycast(glm::vec3 const &origin, glm::vec3 const &direction, float max_distance) const -> ray_hit
+    {
+        ray_hit hit{};
+        hit.distance = max_distance;
+        if (items_.empty())
+        {
+            return hit;
+        }
+
+        glm::vec3 const inverse_direction = 1.0f / direction;
+        std::array<uint32_t, stack_capacity> stack{};
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            auto const &current = nodes_[stack[--stack_size]];
+            if (intersect(origin, inverse_direction, hit.distance, current.min, current.max) < 0.0f)
+            {
+                continue;
+            }
+            if (current.count == 0)
+            {
+                // Nearer child on top, so its hits shorten the ray before the other one is tested
+                auto const &left = nodes_[current.first];
+                auto const &right = nodes_[current.first + 1];
+                float const left_distance = intersect(origin, inverse_direction, hit.distance, left.min, left.max);
+                float const right_distance = intersect(origin, inverse_direction, hit.distance, right.min, right.max);
+                bool const left_first = right_distance < 0.0f or (left_distance >= 0.0f and left_distance <= right_distance);
+                assert(stack_size + 2 <= stack.size() and "BVH deeper than its traversal stack");
+                if (left_distance >= 0.0f and right_distance >= 0.0f)
+                {
+                    stack[stack_size++] = left_first ? current.first + 1 : current.first;
+                }
+                if (left_distance >= 0.0f or right_distance >= 0.0f)
+                {
+                    stack[stack_size++] = left_first ? current.first : current.first + 1;
+                }
+                continue;
+            }
+            for (uint32_t slot = current.first; slot < current.first + current.count; ++slot)
+            {
+                float const distance = intersect(origin, inverse_direction, hit.distance, item_boxes_[slot].min, item_boxes_[slot].max);
+                if (distance >= 0.0f and (hit.item == invalid_item or distance < hit.distance))
+                {
+                    hit.item = items_[slot];
+                    hit.distance = distance;
+                }
+            }
+        }
+        return hit;
+    }
+
+    void bvh::overlap_sphere(glm::vec3 const &center, float radius, std::vector<uint32_t> &items) const
+    {
+        if (items_.empty())
+        {
+            return;
+        }
+
+        float const radius_squared = radius * radius;
+        std::array<uint32_t, stack_capacity> stack{};
+        uint32_t stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            auto const &current = nodes_[stack[--stack_size]];
+            if (not overlaps(center, radius_squared, current.min, current.max))
+            {
+                continue;
+            }
+            if (current.count == 0)
+            {
+                assert(stack_size + 2 <= stack.size() and "BVH deeper than its traversal stack");
+                stack[stack_size++] = current.first + 1;
+                stack[stack_size++] = current.first;
+                continue;
+            }
+            for (uint32_t slot = current.first; slot < current.first + current.count; ++slot)
+            {
+                if (overlaps(center, radius_squared, item_boxes_[slot].min, item_boxes_[slot].max))
+                {
+                    items.push_back(items_[slot]);
+                }
+            }
+        }
+    }
+
+    auto bvh::sah_cost() const -> float
+    {
+        if (items_.empty())
+        {
+            return 0.0f;
+        }
+        float const root_area = std::max(half_area(nodes_[0].min, nodes_[0].max), std::numeric_limits<float>::min());
+        float cost = 0.0f;
+        for (uint32_t node_index = 0; node_index < node_count(); ++node_index)
+        {
+            auto const &current = nodes_[node_index];
+            float const area = half_area(current.min, current.max) / root_area;
+            cost += area * (current.count > 0 ? static_cast<float>(current.count) : traversal_cost);
+        }
+        return cost;
+    }
+}
@@ -0,0 +1,122 @@
+﻿#pragma once
+
+// Project includes
+#include "src/core/frustum_culler.h"
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+namespace dae
+{
+    // Bounding volume hierarchy over axis aligned boxes, one per item; scenes use their dense storage indices as items.
+    // Built top down with a binned surface area heuristic, subtrees above parallel_threshold items as jobs on the
+    // job system. Moving items only refit the nodes above them; the tree gets looser that way, so callers rebuild
+    // once sah_cost() grew too far past what build() left.
+    class bvh final
+    {
+    public:
+        static constexpr uint32_t invalid_item       = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t max_leaf_items     = 4;
+        static constexpr uint32_t parallel_threshold = 16 * 1024;
+
+        // Deeper than max_sah_depth the build falls back to median splits, which halve a 32 bit item count at most 32 more
+        // times. That bounds the depth, and a depth first walk never holds more than depth + 1 pending nodes.
+        static constexpr uint32_t max_sah_depth  = 24;
+        static constexpr uint32_t max_depth      = max_sah_depth + 32;
+        static constexpr uint32_t stack_capacity = 64;
+        static_assert(max_depth + 1 <= stack_capacity);
+
+        struct box
+        {
+            glm::vec3 min{std::numeric_limits<float>::max()};
+            glm::vec3 max{-std::numeric_limits<float>::max()};
+        };
+
+        struct ray_hit
+        {
+            uint32_t item     = invalid_item;
+            float    distance = std::numeric_limits<float>::max();
+        };
+
+    public:
+        bvh() = default;
+        ~bvh() = default;
+
+        bvh(bvh const &other)            = delete;
+        bvh(bvh &&other)                 = delete;
+        bvh &operator=(bvh const &other) = delete;
+        bvh &operator=(bvh &&other)      = delete;
+
+        void build(std::vector<box> const &boxes, bool parallel = true);
+
+        // Boxes keep their item indices; the second form only walks up from the items in moved
+        void refit(std::vector<box> const &boxes);
+        void refit(std::vector<box> const &boxes, std::vector<uint32_t> const &moved);
+
+        // Same result as frustum_culler::cull() over every box: 1 for items at least partly inside, 0 for the others.
+        // Subtrees inside a plane skip it further down and subtrees inside all of them are taken without tests.
+        // Returns how many are visible; boxes_tested counts the item boxes that still had to be tested.
+        auto cull(frustum_culler::planes const &frustum, uint8_t *visible, uint32_t &boxes_tested) const -> size_t;
+
+        // Nearest item box along the ray, direction does not need to be normalized; distances are in its units
+        [[nodiscard]] auto raycast(glm::vec3 const &origin, glm::vec3 const &direction, float max_distance = std::numeric_limits<float>::max()) const -> ray_hit;
+
+        // Appends every item whose box overlaps the sphere
+        void overlap_sphere(glm::vec3 const &center, float radius, std::vector<uint32_t> &items) const;
+
+        // Expected cost of a random query relative to the root's surface area, in box tests
+        [[nodiscard]] auto sah_cost() const -> float;
+        [[nodiscard]] auto item_count() const -> uint32_t { return static_cast<uint32_t>(items_.size()); }
+        [[nodiscard]] auto node_count() const -> uint32_t { return node_count_.load(std::memory_order_relaxed); }
+
+    private:
+        // Leaves have count > 0 and own items_[first, first + count); inner nodes have their children at first and
+        // first + 1. Children are always allocated after their parent, so a reverse sweep visits them first.
+        struct node
+        {
+            glm::vec3 min;
+            uint32_t  first;
+            glm::vec3 max;
+            uint32_t  count;
+        };
+        static_assert(sizeof(node) == 32);
+
+        // Any subtree's items are contiguous in items_, since the build partitions in place
+        struct item_range
+        {
+            uint32_t first;
+            uint32_t count;
+        };
+
+        // Partitioned in place instead of items_, so the build streams through boxes rather than gathering them
+        struct build_entry
+        {
+            glm::vec3 min;
+            uint32_t  item;
+            glm::vec3 max;
+            uint32_t  padding;
+        };
+
+        void build_node(uint32_t node_index, uint32_t first, uint32_t count, uint32_t depth, bool parallel);
+        void refit_node(uint32_t node_index);
+
+    private:
+        std::vector<node>        nodes_;
+        std::vector<item_range>  ranges_;      // by node
+        std::vector<uint32_t>    parents_;
+        std::vector<uint32_t>    items_;       // grouped by leaf
+        std::vector<box>         item_boxes_;  // copies of the boxes in items_ order, so leaves read them in sequence
+        std::vector<uint32_t>    slot_of_;     // by item, its position in items_
+        std::vector<uint32_t>    leaf_of_;     // by item
+        std::vector<build_entry> entries_;     // build only
+        std::vector<uint8_t>     dirty_;       // by node, refit only
+        std::vector<uint32_t>    dirty_nodes_;
+        std::atomic<uint32_t>  node_count_{0};
+    };
+}
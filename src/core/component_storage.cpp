@@ -0,0 +1,113 @@
+﻿#include "component_storage.h"
+
+// Project includes
+#include "src/core/model.h"
+
+// Standard includes
+#include <cassert>
+#include <utility>
+
+namespace dae
+{
+    auto component_storage::create(std::string name) -> game_object::id_t
+    {
+        auto const id = next_id_++;
+        sparse_.push_back(size());
+        light_sparse_.push_back(invalid_index);
+
+        entities_.push_back(id);
+        names_.push_back(std::move(name));
+        transforms_.emplace_back();
+        colors_.emplace_back(0.0f);
+        materials_.emplace_back();
+        models_.emplace_back();
+        use_textures_.push_back(false);
+        texture_indices_.emplace_back(0);
+        visibility_.push_back(1);
+        return id;
+    }
+
+    void component_storage::destroy(game_object::id_t id)
+    {
+        assert(contains(id) and "Entity does not exist");
+        remove_point_light(id);
+
+        auto const index = sparse_[id];
+        auto const last  = size() - 1;
+        if (index != last)
+        {
+            entities_[index]        = entities_[last];
+            names_[index]           = std::move(names_[last]);
+            transforms_[index]      = transforms_[last];
+            colors_[index]          = colors_[last];
+            materials_[index]       = materials_[last];
+            models_[index]          = std::move(models_[last]);
+            use_textures_[index]    = use_textures_[last];
+            texture_indices_[index] = texture_indices_[last];
+            visibility_[index]      = visibility_[last];
+            sparse_[entities_[index]] = index;
+        }
+        entities_.pop_back();
+        names_.pop_back();
+        transforms_.pop_back();
+        colors_.pop_back();
+        materials_.pop_back();
+        models_.pop_back();
+        use_textures_.pop_back();
+        texture_indices_.pop_back();
+        visibility_.pop_back();
+        sparse_[id] = invalid_index;
+    }
+
+    auto component_storage::contains(game_object::id_t id) const -> bool
+    {
+        return id < sparse_.size() and sparse_[id] != invalid_index;
+    }
+
+    auto component_storage::index_of(game_object::id_t id) const -> index_t
+    {
+        assert(contains(id) and "Entity does not exist");
+        return sparse_[id];
+    }
+
+    void component_storage::add_point_light(game_object::id_t id, point_light_component light)
+    {
+        assert(contains(id) and "Entity does not exist");
+        if (light_sparse_[id] != invalid_index)
+        {
+            point_lights_[light_sparse_[id]] = light;
+            return;
+        }
+        light_sparse_[id] = static_cast<index_t>(point_lights_.size());
+        light_entities_.push_back(id);
+        point_lights_.push_back(light);
+    }
+
+    auto component_storage::point_light(game_object::id_t id) -> point_light_component *
+    {
+        if (not contains(id) or light_sparse_[id] == invalid_index)
+        {
+            return nullptr;
+        }
+        return &point_lights_[light_sparse_[id]];
+    }
+
+    void component_storage::remove_point_light(game_object::id_t id)
+    {
+        auto const index = light_sparse_[id];
+        if (index == invalid_index)
+        {
+            return;
+        }
+        auto const last = static_cast<index_t>(point_lights_.size() - 1);
+        if (index != last)
+        {
+            light_entities_[index] = light_entities_[last];
+            point_lights_[index]   = point_lights_[last];
+            light_sparse_[light_entities_[index]] = index;
+        }
+        light_entities_.pop_back();
+        point_lights_.pop_back();
+        light_sparse_[id] = invalid_index;
+    }
+}
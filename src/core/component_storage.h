@@ -0,0 +1,98 @@
+﻿#pragma once
+
+// Project includes
+#include "src/core/game_object.h"
+#include "src/utility/material.h"
+
+// Standard includes
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+namespace dae
+{
+    // Forward declarations
+    class model;
+
+    // Struct-of-arrays component storage for one scene. Every entity owns one slot in each dense array and all arrays
+    // share the same dense index, so systems iterate them linearly. Entity ids are stable for the lifetime of the
+    // entity and are never reused; dense indices are not, destroy() swaps the last entity into the freed slot.
+    // Point lights are optional and live in their own dense arrays keyed by entity id.
+    class component_storage final
+    {
+    public:
+        // Type aliases
+        using index_t = uint32_t;
+
+        static constexpr index_t invalid_index = std::numeric_limits<index_t>::max();
+
+    public:
+        component_storage() = default;
+        ~component_storage() = default;
+
+        component_storage(component_storage const &other)            = delete;
+        component_storage(component_storage &&other)                 = delete;
+        component_storage &operator=(component_storage const &other) = delete;
+        component_storage &operator=(component_storage &&other)      = delete;
+
+        auto create(std::string name) -> game_object::id_t;
+        void destroy(game_object::id_t id);
+
+        [[nodiscard]] auto contains(game_object::id_t id) const -> bool;
+        [[nodiscard]] auto index_of(game_object::id_t id) const -> index_t;
+        [[nodiscard]] auto size() const -> index_t { return static_cast<index_t>(entities_.size()); }
+
+        // Dense arrays, indexed by index_of()
+        [[nodiscard]] auto entities() const -> std::vector<game_object::id_t> const & { return entities_; }
+        [[nodiscard]] auto names() const -> std::vector<std::string> const & { return names_; }
+        [[nodiscard]] auto transforms() -> std::vector<transform_component> & { return transforms_; }
+        [[nodiscard]] auto transforms() const -> std::vector<transform_component> const & { return transforms_; }
+        [[nodiscard]] auto colors() -> std::vector<glm::vec3> & { return colors_; }
+        [[nodiscard]] auto colors() const -> std::vector<glm::vec3> const & { return colors_; }
+        [[nodiscard]] auto materials() -> std::vector<material> & { return materials_; }
+        [[nodiscard]] auto materials() const -> std::vector<material> const & { return materials_; }
+        [[nodiscard]] auto models() -> std::vector<std::shared_ptr<model>> & { return models_; }
+        [[nodiscard]] auto models() const -> std::vector<std::shared_ptr<model>> const & { return models_; }
+        [[nodiscard]] auto use_textures() -> std::vector<bool> & { return use_textures_; }
+        [[nodiscard]] auto use_textures() const -> std::vector<bool> const & { return use_textures_; }
+        [[nodiscard]] auto texture_indices() -> std::vector<glm::ivec4> & { return texture_indices_; }
+        [[nodiscard]] auto texture_indices() const -> std::vector<glm::ivec4> const & { return texture_indices_; }
+        [[nodiscard]] auto visibility() -> std::vector<uint8_t> & { return visibility_; }
+        [[nodiscard]] auto visibility() const -> std::vector<uint8_t> const & { return visibility_; }
+
+        // Point lights, one dense slot per entity that has a light
+        void add_point_light(game_object::id_t id, point_light_component light);
+        [[nodiscard]] auto point_light(game_object::id_t id) -> point_light_component *;
+        [[nodiscard]] auto light_entities() const -> std::vector<game_object::id_t> const & { return light_entities_; }
+        [[nodiscard]] auto point_lights() -> std::vector<point_light_component> & { return point_lights_; }
+        [[nodiscard]] auto point_lights() const -> std::vector<point_light_component> const & { return point_lights_; }
+
+    private:
+        void remove_point_light(game_object::id_t id);
+
+    private:
+        game_object::id_t next_id_ = 0;
+
+        // Entity id -> dense index, invalid_index for destroyed ids
+        std::vector<index_t> sparse_;
+        std::vector<index_t> light_sparse_;
+
+        std::vector<game_object::id_t>      entities_;
+        std::vector<std::string>            names_;
+        std::vector<transform_component>    transforms_;
+        std::vector<glm::vec3>              colors_;
+        std::vector<material>               materials_;
+        std::vector<std::shared_ptr<model>> models_;
+        std::vector<bool>                   use_textures_;
+        std::vector<glm::ivec4>             texture_indices_; // texture_registry handles: diffuse, normal, specular, glossiness
+        std::vector<uint8_t>                visibility_;      // 0 when culled this frame, see scene::render()
+
+        std::vector<game_object::id_t>     light_entities_;
+        std::vector<point_light_component> point_lights_;
+    };
+}
@@ -5,7 +5,7 @@
 
 namespace dae
 {
-    std::unique_ptr<model> factory::create_oval(glm::vec3 offset, float radiusX, float radiusY, int segments)
+    std::shared_ptr<model> factory::create_oval(glm::vec3 offset, float radiusX, float radiusY, int segments)
     {
         model::builder modelBuilder{};
 
@@ -34,10 +34,10 @@ namespace dae
         modelBuilder.indices.push_back(segments);
         modelBuilder.indices.push_back(1);
 
-        return std::make_unique<model>(modelBuilder);
+        return std::make_shared<model>(modelBuilder);
     }
 
-    std::unique_ptr<model> factory::create_n_gon(glm::vec3 offset, float radius, int sides)
+    std::shared_ptr<model> factory::create_n_gon(glm::vec3 offset, float radius, int sides)
     {
         model::builder modelBuilder{};
 
@@ -69,6 +69,6 @@ namespace dae
         modelBuilder.indices.push_back(sides - 1);
         modelBuilder.indices.push_back(1);
 
-        return std::make_unique<model>(modelBuilder);
+        return std::make_shared<model>(modelBuilder);
     }
 }
@@ -0,0 +1,168 @@
+﻿#include "frustum_culler.h"
+
+// Standard includes
+#include <bit>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DAE_FRUSTUM_CULLER_X86
+#include <immintrin.h>
+#endif
+
+// MSVC accepts any intrinsic without a compiler flag, GCC and Clang need the functions that use them marked
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DAE_TARGET_SSE2
+#define DAE_TARGET_AVX2
+#else
+#define DAE_TARGET_SSE2 __attribute__((target("sse2")))
+#define DAE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace dae
+{
+    namespace
+    {
+        // A box is outside a plane when even its corner furthest along the normal is behind it
+        auto cull_scalar(frustum_culler::planes const &frustum, frustum_culler::input const &in, size_t first, size_t count, uint8_t *visible) -> size_t
+        {
+            size_t visible_count = 0;
+            for (size_t i = first; i < count; ++i)
+            {
+                bool inside = true;
+                for (auto const &plane : frustum)
+                {
+                    float const distance = plane.x * in.center_x[i] + plane.y * in.center_y[i] + plane.z * in.center_z[i] + plane.w;
+                    float const reach = std::abs(plane.x) * in.extent_x[i] + std::abs(plane.y) * in.extent_y[i] + std::abs(plane.z) * in.extent_z[i];
+                    inside = inside and distance + reach >= 0.0f;
+                }
+                visible[i] = inside ? 1 : 0;
+                visible_count += inside ? 1 : 0;
+            }
+            return visible_count;
+        }
+
+#if defined(DAE_FRUSTUM_CULLER_X86)
+        // Spreads the low bits of a movemask over bytes of 0 or 1
+        void store_mask(uint8_t *visible, int mask, int lanes)
+        {
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                visible[lane] = static_cast<uint8_t>((mask >> lane) & 1);
+            }
+        }
+
+        DAE_TARGET_SSE2 auto cull_sse2(frustum_culler::planes const &frustum, frustum_culler::input const &in, size_t count, uint8_t *visible, size_t &visible_count) -> size_t
+        {
+            __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], w[6];
+            for (int p = 0; p < 6; ++p)
+            {
+                nx[p] = _mm_set1_ps(frustum[p].x);
+                ny[p] = _mm_set1_ps(frustum[p].y);
+                nz[p] = _mm_set1_ps(frustum[p].z);
+                ax[p] = _mm_set1_ps(std::abs(frustum[p].x));
+                ay[p] = _mm_set1_ps(std::abs(frustum[p].y));
+                az[p] = _mm_set1_ps(std::abs(frustum[p].z));
+                w[p]  = _mm_set1_ps(frustum[p].w);
+            }
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 const cx = _mm_loadu_ps(in.center_x + i);
+                __m128 const cy = _mm_loadu_ps(in.center_y + i);
+                __m128 const cz = _mm_loadu_ps(in.center_z + i);
+                __m128 const ex = _mm_loadu_ps(in.extent_x + i);
+                __m128 const ey = _mm_loadu_ps(in.extent_y + i);
+                __m128 const ez = _mm_loadu_ps(in.extent_z + i);
+
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int p = 0; p < 6; ++p)
+                {
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_add_ps(_mm_mul_ps(nz[p], cz), w[p]));
+                    distance = _mm_add_ps(distance, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez)));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+                }
+                int const mask = _mm_movemask_ps(inside);
+                store_mask(visible + i, mask, 4);
+                visible_count += static_cast<size_t>(std::popcount(static_cast<unsigned>(mask)));
+            }
+            return i;
+        }
+
+        DAE_TARGET_AVX2 auto cull_avx2(frustum_culler::planes const &frustum, frustum_culler::input const &in, size_t count, uint8_t *visible, size_t &visible_count) -> size_t
+        {
+            __m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], w[6];
+            for (int p = 0; p < 6; ++p)
+            {
+                nx[p] = _mm256_set1_ps(frustum[p].x);
+                ny[p] = _mm256_set1_ps(frustum[p].y);
+                nz[p] = _mm256_set1_ps(frustum[p].z);
+                ax[p] = _mm256_set1_ps(std::abs(frustum[p].x));
+                ay[p] = _mm256_set1_ps(std::abs(frustum[p].y));
+                az[p] = _mm256_set1_ps(std::abs(frustum[p].z));
+                w[p]  = _mm256_set1_ps(frustum[p].w);
+            }
+
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 const cx = _mm256_loadu_ps(in.center_x + i);
+                __m256 const cy = _mm256_loadu_ps(in.center_y + i);
+                __m256 const cz = _mm256_loadu_ps(in.center_z + i);
+                __m256 const ex = _mm256_loadu_ps(in.extent_x + i);
+                __m256 const ey = _mm256_loadu_ps(in.extent_y + i);
+                __m256 const ez = _mm256_loadu_ps(in.extent_z + i);
+
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (int p = 0; p < 6; ++p)
+                {
+                    __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_add_ps(_mm256_mul_ps(nz[p], cz), w[p]));
+                    distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez)));
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+                }
+                int const mask = _mm256_movemask_ps(inside);
+                store_mask(visible + i, mask, 8);
+                visible_count += static_cast<size_t>(std::popcount(static_cast<unsigned>(mask)));
+            }
+            return i;
+        }
+#endif
+    }
+
+    auto frustum_culler::cull(planes const &frustum, input const &in, size_t count, uint8_t *visible) -> size_t
+    {
+        static isa const target = transform_kernel::best_isa();
+        return cull(target, frustum, in, count, visible);
+    }
+
+    auto frustum_culler::cull(isa target, planes const &frustum, input const &in, size_t count, uint8_t *visible) -> size_t
+    {
+        size_t done          = 0;
+        size_t visible_count = 0;
+#if defined(DAE_FRUSTUM_CULLER_X86)
+        switch (target)
+        {
+            case isa::avx2:
+                done = cull_avx2(frustum, in, count, visible, visible_count);
+                break;
+            case isa::sse2:
+                done = cull_sse2(frustum, in, count, visible, visible_count);
+                break;
+            case isa::scalar:
+                break;
+        }
+#endif
+        return visible_count + cull_scalar(frustum, in, done, count, visible);
+    }
+
+    void frustum_culler::transform_box(glm::mat4 const &matrix, glm::vec3 const &min, glm::vec3 const &max, glm::vec3 &center, glm::vec3 &extent)
+    {
+        // Arvo: the new half extent along each axis sums the old ones weighted by the absolute rotation and scale
+        glm::vec3 const local_center = (min + max) * 0.5f;
+        glm::vec3 const local_extent = (max - min) * 0.5f;
+        center = glm::vec3{matrix * glm::vec4{local_center, 1.0f}};
+        extent = glm::abs(glm::vec3{matrix[0]}) * local_extent.x +
+                 glm::abs(glm::vec3{matrix[1]}) * local_extent.y +
+                 glm::abs(glm::vec3{matrix[2]}) * local_extent.z;
+    }
+}
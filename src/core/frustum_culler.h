@@ -0,0 +1,45 @@
+﻿#pragma once
+
+// Project includes
+#include "src/core/transform_kernel.h"
+
+// Standard includes
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+namespace dae
+{
+    // Tests world space bounding boxes against the planes of a view frustum. Boxes come as struct-of-arrays centers
+    // and half extents and are tested 4 (SSE2) or 8 (AVX2) at a time, with the same runtime instruction set choice
+    // and scalar fallback as transform_kernel.
+    struct frustum_culler final
+    {
+        using isa = transform_kernel::isa;
+
+        // As camera::frustum_planes() returns them: normalized, facing inwards
+        using planes = std::array<glm::vec4, 6>;
+
+        // Every array holds count elements
+        struct input
+        {
+            float const *center_x = nullptr;
+            float const *center_y = nullptr;
+            float const *center_z = nullptr;
+            float const *extent_x = nullptr;
+            float const *extent_y = nullptr;
+            float const *extent_z = nullptr;
+        };
+
+        // Writes 1 for every box that is at least partly inside the frustum and 0 for the others; returns how many
+        // are visible. Boxes that straddle a frustum corner outside every single plane's reach stay visible.
+        static auto cull(planes const &frustum, input const &in, size_t count, uint8_t *visible) -> size_t;
+        static auto cull(isa target, planes const &frustum, input const &in, size_t count, uint8_t *visible) -> size_t;
+
+        // Box around the transformed box, as center and half extent
+        static void transform_box(glm::mat4 const &matrix, glm::vec3 const &min, glm::vec3 const &max, glm::vec3 &center, glm::vec3 &extent);
+    };
+}
@@ -1,11 +1,37 @@
 ﻿#include "game_object.h"
 
+// Project includes
+#include "src/core/component_storage.h"
+
+// Standard includes
+
 namespace dae
 {
-    game_object::id_t game_object::next_id_ = 0;
-    
-    glm::mat4 transform_component::mat4()
+    auto transform_component::mat4() const -> glm::mat4 const &
+    {
+        update_matrices();
+        return matrix_;
+    }
+
+    auto transform_component::normal_matrix() const -> glm::mat4 const &
+    {
+        update_matrices();
+        return normal_matrix_;
+    }
+
+    void transform_component::update_matrices() const
+    {
+        if (cached_version_ == version_)
         {
+            return;
+        }
+        matrix_         = make_matrix(translation_, rotation_, scale_);
+        normal_matrix_  = make_normal_matrix(rotation_, scale_);
+        cached_version_ = version_;
+    }
+
+    auto transform_component::make_matrix(glm::vec3 const &translation, glm::vec3 const &rotation, glm::vec3 const &scale) -> glm::mat4
+    {
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
         const float c2 = glm::cos(rotation.x);
@@ -35,7 +61,7 @@ namespace dae
         };
     }
 
-    glm::mat4 transform_component::normal_matrix()
+    auto transform_component::make_normal_matrix(glm::vec3 const &rotation, glm::vec3 const &scale) -> glm::mat4
     {
         const float c3 = glm::cos(rotation.z);
         const float s3 = glm::sin(rotation.z);
@@ -62,4 +88,74 @@ namespace dae
                 }
         };
     }
+
+    auto game_object::name() const -> std::string const &
+    {
+        return storage_ptr_->names()[storage_ptr_->index_of(id_)];
+    }
+
+    auto game_object::transform() const -> transform_component &
+    {
+        return storage_ptr_->transforms()[storage_ptr_->index_of(id_)];
+    }
+
+    auto game_object::model() const -> std::shared_ptr<dae::model> const &
+    {
+        return storage_ptr_->models()[storage_ptr_->index_of(id_)];
+    }
+
+    void game_object::set_model(std::shared_ptr<dae::model> model)
+    {
+        storage_ptr_->models()[storage_ptr_->index_of(id_)] = std::move(model);
+    }
+
+    auto game_object::color() const -> glm::vec3 const &
+    {
+        return storage_ptr_->colors()[storage_ptr_->index_of(id_)];
+    }
+
+    void game_object::set_color(glm::vec3 const &color)
+    {
+        storage_ptr_->colors()[storage_ptr_->index_of(id_)] = color;
+    }
+
+    auto game_object::use_texture() const -> bool
+    {
+        return storage_ptr_->use_textures()[storage_ptr_->index_of(id_)];
+    }
+
+    void game_object::set_use_texture(bool use_texture)
+    {
+        storage_ptr_->use_textures()[storage_ptr_->index_of(id_)] = use_texture;
+    }
+
+    auto game_object::texture_indices() const -> glm::ivec4 const &
+    {
+        return storage_ptr_->texture_indices()[storage_ptr_->index_of(id_)];
+    }
+
+    void game_object::set_texture_indices(glm::ivec4 const &texture_indices)
+    {
+        storage_ptr_->texture_indices()[storage_ptr_->index_of(id_)] = texture_indices;
+    }
+
+    auto game_object::material() const -> dae::material const &
+    {
+        return storage_ptr_->materials()[storage_ptr_->index_of(id_)];
+    }
+
+    void game_object::set_material(float r, float g, float b, float metallic, float roughness)
+    {
+        storage_ptr_->materials()[storage_ptr_->index_of(id_)] = dae::material{glm::vec3{r, g, b}, metallic, roughness};
+    }
+
+    auto game_object::point_light() const -> point_light_component *
+    {
+        return storage_ptr_->point_light(id_);
+    }
+
+    void game_object::add_point_light(float light_intensity)
+    {
+        storage_ptr_->add_point_light(id_, point_light_component{light_intensity});
+    }
 }
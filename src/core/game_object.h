@@ -5,6 +5,7 @@
 #include "src/utility/material.h"
 
 // Standard includes
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -13,19 +14,46 @@
 
 namespace dae
 {
-    struct transform_component
+    class transform_component final
     {
-        glm::vec3 translation = {};
-        glm::vec3 scale       = {1.0f, 1.0f, 1.0f};
-        glm::vec3 rotation    = {};
+    public:
+        [[nodiscard]] auto translation() const -> glm::vec3 const & { return translation_; }
+        [[nodiscard]] auto rotation() const -> glm::vec3 const & { return rotation_; }
+        [[nodiscard]] auto scale() const -> glm::vec3 const & { return scale_; }
+
+        void set_translation(glm::vec3 const &translation) { translation_ = translation; ++version_; }
+        void set_rotation(glm::vec3 const &rotation) { rotation_ = rotation; ++version_; }
+        void set_scale(glm::vec3 const &scale) { scale_ = scale; ++version_; }
+
+        // Bumped by every setter; lets consumers detect changes without comparing matrices
+        [[nodiscard]] auto version() const -> uint32_t { return version_; }
+
+        // Cached, rebuilt only when the transform changed since the last call. The rebuild writes the cache from a
+        // const call without synchronization: different transforms may be read from different threads, but one
+        // transform must not be read from two threads at once while it is stale
+        [[nodiscard]] auto mat4() const -> glm::mat4 const &;
+        [[nodiscard]] auto normal_matrix() const -> glm::mat4 const &;
 
         // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
         // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
         // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
         // Intrinsic rotations: R = Y(1), X(2), Z(3)
         // Extrinsic rotations: R = Z(3), X(2), Y(1)
-        glm::mat4 mat4();
-        glm::mat4 normal_matrix();
+        static auto make_matrix(glm::vec3 const &translation, glm::vec3 const &rotation, glm::vec3 const &scale) -> glm::mat4;
+        static auto make_normal_matrix(glm::vec3 const &rotation, glm::vec3 const &scale) -> glm::mat4;
+
+    private:
+        void update_matrices() const;
+
+    private:
+        glm::vec3 translation_ = {};
+        glm::vec3 scale_       = {1.0f, 1.0f, 1.0f};
+        glm::vec3 rotation_    = {};
+        uint32_t  version_     = 1;
+
+        mutable uint32_t  cached_version_ = 0;
+        mutable glm::mat4 matrix_         = {1.0f};
+        mutable glm::mat4 normal_matrix_  = {1.0f};
     };
 
     struct point_light_component
@@ -33,6 +61,11 @@ namespace dae
         float light_intensity = 1.0f;
     };
     
+    // Forward declarations
+    class component_storage;
+
+    // Lightweight handle to an entity whose components live in a scene's component_storage. Copies refer to the
+    // same entity; references returned by the accessors are invalidated when the storage grows or shrinks
     class game_object final
     {
     public:
@@ -40,35 +73,29 @@ namespace dae
         using id_t = unsigned int;
 
     public:
-        explicit game_object(std::string name) : id_{next_id_++}, name_{std::move(name)} {}
-        ~game_object() = default;
-        
-        game_object(game_object const &)            = delete;
-        game_object &operator=(game_object const &) = delete;
-        game_object(game_object &&)                 = default;
-        game_object &operator=(game_object &&)      = default;
+        game_object(component_storage *storage_ptr, id_t id) : storage_ptr_{storage_ptr}, id_{id} {}
 
         [[nodiscard]] auto id() const -> id_t { return id_; }
-        [[nodiscard]] auto name() const -> std::string { return name_; }
-        [[nodiscard]] auto material() const -> material const & { return material_; }
-        void set_material(float r, float g, float b, float metallic, float roughness)
-        {
-            material_ = dae::material{glm::vec3{r, g, b}, metallic, roughness};
-        }
+        [[nodiscard]] auto name() const -> std::string const &;
 
-    public:
-        std::unique_ptr<model> model     = {};
-        glm::vec3              color     = {};
-        transform_component    transform = {};
+        [[nodiscard]] auto transform() const -> transform_component &;
+        [[nodiscard]] auto model() const -> std::shared_ptr<dae::model> const &;
+        void set_model(std::shared_ptr<dae::model> model);
+        [[nodiscard]] auto color() const -> glm::vec3 const &;
+        void set_color(glm::vec3 const &color);
+        [[nodiscard]] auto use_texture() const -> bool;
+        void set_use_texture(bool use_texture);
+        [[nodiscard]] auto texture_indices() const -> glm::ivec4 const &;
+        void set_texture_indices(glm::ivec4 const &texture_indices);
+        [[nodiscard]] auto material() const -> dae::material const &;
+        void set_material(float r, float g, float b, float metallic, float roughness);
 
-        std::unique_ptr<point_light_component> point_light = nullptr;
-        bool use_texture = false;
+        // Returns nullptr when the entity has no light attached
+        [[nodiscard]] auto point_light() const -> point_light_component *;
+        void add_point_light(float light_intensity);
 
     private:
-        id_t          id_;
-        std::string   name_;
-        dae::material material_ = {};
-
-        static id_t next_id_;
+        component_storage *storage_ptr_;
+        id_t              id_;
     };
 }
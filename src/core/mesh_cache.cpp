@@ -0,0 +1,306 @@
+﻿#include "mesh_cache.h"
+
+// Project includes
+#include "src/utility/utils.h"
+
+// Standard includes
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Platform includes
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+    namespace
+    {
+        // Read-only memory mapping of a whole file, unmapped on destruction
+        class mapped_file final
+        {
+        public:
+            explicit mapped_file(std::string const &path)
+            {
+#if defined(_WIN32)
+                file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file_ == INVALID_HANDLE_VALUE)
+                {
+                    return;
+                }
+                LARGE_INTEGER file_size{};
+                if (not GetFileSizeEx(file_, &file_size) or file_size.QuadPart == 0)
+                {
+                    return;
+                }
+                mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping_ == nullptr)
+                {
+                    return;
+                }
+                data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+                if (data_ != nullptr)
+                {
+                    size_ = static_cast<size_t>(file_size.QuadPart);
+                }
+#else
+                file_ = open(path.c_str(), O_RDONLY);
+                if (file_ < 0)
+                {
+                    return;
+                }
+                struct stat file_stat{};
+                if (fstat(file_, &file_stat) != 0 or file_stat.st_size == 0)
+                {
+                    return;
+                }
+                void *data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_, 0);
+                if (data != MAP_FAILED)
+                {
+                    data_ = data;
+                    size_ = static_cast<size_t>(file_stat.st_size);
+                }
+#endif
+            }
+
+            ~mapped_file()
+            {
+#if defined(_WIN32)
+                if (data_ != nullptr) UnmapViewOfFile(data_);
+                if (mapping_ != nullptr) CloseHandle(mapping_);
+                if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+                if (data_ != nullptr) munmap(data_, size_);
+                if (file_ >= 0) close(file_);
+#endif
+            }
+
+            mapped_file(mapped_file const &other)            = delete;
+            mapped_file(mapped_file &&other)                 = delete;
+            mapped_file &operator=(mapped_file const &other) = delete;
+            mapped_file &operator=(mapped_file &&other)      = delete;
+
+            [[nodiscard]] auto data() const -> std::byte const * { return static_cast<std::byte const *>(data_); }
+            [[nodiscard]] auto size() const -> size_t { return size_; }
+
+        private:
+#if defined(_WIN32)
+            HANDLE file_    = INVALID_HANDLE_VALUE;
+            HANDLE mapping_ = nullptr;
+#else
+            int file_ = -1;
+#endif
+            void   *data_ = nullptr;
+            size_t  size_ = 0;
+        };
+
+        // 64-bit FNV-1a over the raw source file
+        auto hash_file(std::string const &path) -> uint64_t
+        {
+            mapped_file const file{path};
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (size_t i = 0; i < file.size(); ++i)
+            {
+                hash ^= static_cast<uint64_t>(file.data()[i]);
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        auto source_mtime(std::filesystem::path const &path) -> int64_t
+        {
+            std::error_code error{};
+            auto const time = std::filesystem::last_write_time(path, error);
+            return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+        }
+
+        // Narrowest index type that addresses every vertex of the builder
+        auto index_size(model::builder const &builder) -> uint32_t
+        {
+            return builder.vertices.size() <= size_t{std::numeric_limits<uint16_t>::max()} + 1 ? sizeof(uint16_t) : sizeof(uint32_t);
+        }
+
+        template<typename index_type>
+        void read_indices(std::byte const *data, size_t count, std::vector<uint32_t> &indices)
+        {
+            indices.resize(count);
+            if constexpr (std::is_same_v<index_type, uint32_t>)
+            {
+                std::memcpy(indices.data(), data, count * sizeof(uint32_t));
+            }
+            else
+            {
+                std::vector<index_type> stored(count);
+                std::memcpy(stored.data(), data, count * sizeof(index_type));
+                std::ranges::copy(stored, indices.begin());
+            }
+        }
+
+        template<typename index_type>
+        void write_indices(std::ofstream &file, std::vector<uint32_t> const &indices)
+        {
+            if constexpr (std::is_same_v<index_type, uint32_t>)
+            {
+                file.write(reinterpret_cast<char const *>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+            }
+            else
+            {
+                std::vector<index_type> stored(indices.size());
+                std::ranges::transform(indices, stored.begin(), [](uint32_t index) { return static_cast<index_type>(index); });
+                file.write(reinterpret_cast<char const *>(stored.data()), static_cast<std::streamsize>(stored.size() * sizeof(index_type)));
+            }
+        }
+
+        auto builder_flags(model::builder const &builder) -> uint32_t
+        {
+            return builder.optimize ? mesh_cache::optimized_flag : 0;
+        }
+
+        auto is_compatible(mesh_cache::header const &header, size_t file_size, uint32_t flags) -> bool
+        {
+            mesh_cache::header const expected{};
+            if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 or
+                header.version != mesh_cache::version or
+                header.vertex_size != sizeof(model::vertex) or
+                (header.index_size != sizeof(uint16_t) and header.index_size != sizeof(uint32_t)) or
+                header.flags != flags)
+            {
+                return false;
+            }
+            return file_size == sizeof(mesh_cache::header) + header.vertex_count * header.vertex_size + header.index_count * header.index_size;
+        }
+    }
+
+    auto mesh_cache::load(std::string const &source_path, model::builder &builder) -> bool
+    {
+        // The mapping is scoped so it is released before save() renames over the file, which Windows refuses while
+        // the file is mapped
+        bool refresh_header = false;
+        {
+            mapped_file const file{cache_path(source_path)};
+            if (file.size() < sizeof(header))
+            {
+                return false;
+            }
+
+            header cache_header{};
+            std::memcpy(&cache_header, file.data(), sizeof(header));
+            if (not is_compatible(cache_header, file.size(), builder_flags(builder)))
+            {
+                return false;
+            }
+
+            // A missing source means the asset ships as cache only; otherwise size + mtime is the fast path and the
+            // content hash is the fallback for touched-but-unchanged files (e.g. after a checkout)
+            std::error_code error{};
+            if (std::filesystem::exists(source_path, error))
+            {
+                auto const size = std::filesystem::file_size(source_path, error);
+                if (error or size != cache_header.source_size)
+                {
+                    return false;
+                }
+                if (source_mtime(source_path) != cache_header.source_mtime)
+                {
+                    if (hash_file(source_path) != cache_header.source_hash)
+                    {
+                        return false;
+                    }
+                    refresh_header = true;
+                }
+            }
+
+            auto const *vertex_data = file.data() + sizeof(header);
+            auto const *index_data  = vertex_data + cache_header.vertex_count * sizeof(model::vertex);
+
+            builder.vertices.resize(cache_header.vertex_count);
+            std::memcpy(builder.vertices.data(), vertex_data, cache_header.vertex_count * sizeof(model::vertex));
+            if (cache_header.index_size == sizeof(uint16_t))
+            {
+                read_indices<uint16_t>(index_data, cache_header.index_count, builder.indices);
+            }
+            else
+            {
+                read_indices<uint32_t>(index_data, cache_header.index_count, builder.indices);
+            }
+        }
+
+        if (refresh_header)
+        {
+            save(source_path, builder);
+        }
+        return true;
+    }
+
+    void mesh_cache::save(std::string const &source_path, model::builder const &builder)
+    {
+        std::error_code error{};
+        header cache_header{};
+        cache_header.version      = version;
+        cache_header.vertex_size  = sizeof(model::vertex);
+        cache_header.index_size   = index_size(builder);
+        cache_header.flags        = builder_flags(builder);
+        cache_header.source_size  = std::filesystem::file_size(source_path, error);
+        cache_header.source_mtime = source_mtime(source_path);
+        cache_header.source_hash  = hash_file(source_path);
+        cache_header.vertex_count = builder.vertices.size();
+        cache_header.index_count  = builder.indices.size();
+
+        // Write to a temporary file first so a crash never leaves a truncated cache behind
+        std::string const path      = cache_path(source_path);
+        std::string const temp_path = path + ".tmp";
+        {
+            std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+            if (not file)
+            {
+#ifndef NDEBUG
+                std::cout << YELLOW_TEXT("Failed to write mesh cache: ") << path << '\n';
+#endif
+                return;
+            }
+            file.write(reinterpret_cast<char const *>(&cache_header), sizeof(header));
+            file.write(reinterpret_cast<char const *>(builder.vertices.data()), static_cast<std::streamsize>(builder.vertices.size() * sizeof(model::vertex)));
+            if (cache_header.index_size == sizeof(uint16_t))
+            {
+                write_indices<uint16_t>(file, builder.indices);
+            }
+            else
+            {
+                write_indices<uint32_t>(file, builder.indices);
+            }
+        }
+        std::filesystem::rename(temp_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+        }
+    }
+
+    void mesh_cache::remove(std::string const &source_path)
+    {
+        std::error_code error{};
+        std::filesystem::remove(cache_path(source_path), error);
+    }
+
+    auto mesh_cache::cache_path(std::string const &source_path) -> std::string
+    {
+        return source_path + extension;
+    }
+}
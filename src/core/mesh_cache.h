@@ -0,0 +1,42 @@
+﻿#pragma once
+
+// Project includes
+#include "model.h"
+
+// Standard includes
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+    // Binary snapshot of a model::builder (post-dedup, post-optimize vertices + indices) stored next to the source asset;
+    // indices are stored 16 bit whenever the vertex count allows and widened again on load
+    struct mesh_cache final
+    {
+        struct header
+        {
+            char     magic[4]     = {'D', 'A', 'E', 'M'};
+            uint32_t version      = 0;
+            uint32_t vertex_size  = 0;
+            uint32_t index_size   = 0;
+            uint32_t flags        = 0;
+            uint32_t reserved     = 0;
+            uint64_t source_size  = 0;
+            int64_t  source_mtime = 0;
+            uint64_t source_hash  = 0;
+            uint64_t vertex_count = 0;
+            uint64_t index_count  = 0;
+        };
+
+        // Bump whenever model::vertex or the builder's post-processing changes
+        static constexpr uint32_t version = 3;
+        // Header flags; a cache only satisfies builders that ask for the same post-processing
+        static constexpr uint32_t optimized_flag = 1u << 0;
+        static constexpr char const *extension = ".meshcache";
+
+        static auto load(std::string const &source_path, model::builder &builder) -> bool;
+        static void save(std::string const &source_path, model::builder const &builder);
+        static void remove(std::string const &source_path);
+        static auto cache_path(std::string const &source_path) -> std::string;
+    };
+}
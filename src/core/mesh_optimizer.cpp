@@ -0,0 +1,335 @@
+﻿#include "mesh_optimizer.h"
+
+// Standard includes
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace dae
+{
+    namespace
+    {
+        constexpr uint32_t invalid_vertex = ~0u;
+
+        // FIFO cache simulated with time stamps: a vertex is resident while fewer than cache_size misses happened since
+        // it was loaded; advancing the clock by more than cache_size flushes it
+        class vertex_cache final
+        {
+        public:
+            explicit vertex_cache(size_t vertex_count) : stamps_(vertex_count, 0) {}
+
+            auto access(uint32_t vertex) -> uint32_t
+            {
+                if (time_ - stamps_[vertex] > mesh_optimizer::cache_size)
+                {
+                    stamps_[vertex] = time_++;
+                    return 1;
+                }
+                return 0;
+            }
+
+            void flush() { time_ += mesh_optimizer::cache_size + 1; }
+
+            [[nodiscard]] auto time() const -> uint32_t { return time_; }
+            [[nodiscard]] auto stamp(uint32_t vertex) const -> uint32_t { return stamps_[vertex]; }
+
+        private:
+            std::vector<uint32_t> stamps_;
+            uint32_t time_ = mesh_optimizer::cache_size + 1;
+        };
+
+        // Triangles around every vertex, flattened; a triangle using a vertex twice is listed twice
+        struct adjacency final
+        {
+            std::vector<uint32_t> offsets   = {};
+            std::vector<uint32_t> triangles = {};
+
+            adjacency(std::vector<uint32_t> const &indices, size_t vertex_count)
+                : offsets(vertex_count + 1, 0)
+                , triangles(indices.size())
+            {
+                for (uint32_t const index : indices)
+                {
+                    ++offsets[index + 1];
+                }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+                std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            [[nodiscard]] auto count(uint32_t vertex) const -> uint32_t { return offsets[vertex + 1] - offsets[vertex]; }
+        };
+
+        // Tipsify: fan around the most recently cached vertex that still has triangles left and whose remaining fan fits
+        // the cache; when none does, fall back to the dead-end stack and then to input order, which starts a new cluster
+        void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count, std::vector<uint32_t> &clusters)
+        {
+            adjacency const adjacent{indices, vertex_count};
+
+            std::vector<uint32_t> live(vertex_count);
+            for (uint32_t v = 0; v < vertex_count; ++v)
+            {
+                live[v] = adjacent.count(v);
+            }
+
+            std::vector<bool>     emitted(indices.size() / 3, false);
+            std::vector<uint32_t> dead_end{};
+            std::vector<uint32_t> candidates{};
+            std::vector<uint32_t> result{};
+            dead_end.reserve(indices.size());
+            result.reserve(indices.size());
+
+            vertex_cache cache{vertex_count};
+            uint32_t     cursor = 0;
+
+            auto const skip_dead_end = [&]() -> uint32_t
+            {
+                while (not dead_end.empty())
+                {
+                    uint32_t const vertex = dead_end.back();
+                    dead_end.pop_back();
+                    if (live[vertex] > 0)
+                    {
+                        return vertex;
+                    }
+                }
+                for (; cursor < vertex_count; ++cursor)
+                {
+                    if (live[cursor] > 0)
+                    {
+                        return cursor;
+                    }
+                }
+                return invalid_vertex;
+            };
+
+            clusters.clear();
+            uint32_t fan = skip_dead_end();
+            while (fan != invalid_vertex)
+            {
+                clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+
+                while (fan != invalid_vertex)
+                {
+                    candidates.clear();
+                    for (uint32_t i = adjacent.offsets[fan]; i < adjacent.offsets[fan + 1]; ++i)
+                    {
+                        uint32_t const triangle = adjacent.triangles[i];
+                        if (emitted[triangle])
+                        {
+                            continue;
+                        }
+                        emitted[triangle] = true;
+
+                        for (uint32_t corner = 0; corner < 3; ++corner)
+                        {
+                            uint32_t const vertex = indices[triangle * 3 + corner];
+                            result.push_back(vertex);
+                            dead_end.push_back(vertex);
+                            candidates.push_back(vertex);
+                            --live[vertex];
+                            cache.access(vertex);
+                        }
+                    }
+
+                    // Prefer the oldest vertex that will still be cached after emitting its remaining fan
+                    uint32_t next          = invalid_vertex;
+                    int64_t  best_priority = -1;
+                    for (uint32_t const vertex : candidates)
+                    {
+                        if (live[vertex] == 0)
+                        {
+                            continue;
+                        }
+                        uint32_t const age      = cache.time() - cache.stamp(vertex);
+                        int64_t        priority = 0;
+                        if (age + 2 * live[vertex] <= mesh_optimizer::cache_size)
+                        {
+                            priority = age;
+                        }
+                        if (priority > best_priority)
+                        {
+                            best_priority = priority;
+                            next          = vertex;
+                        }
+                    }
+                    fan = next;
+                }
+                fan = skip_dead_end();
+            }
+
+            indices = std::move(result);
+        }
+
+        // Splits the Tipsify clusters further wherever the running ACMR already reaches the cluster's own ACMR (within
+        // the threshold), so overdraw sorting has more pieces to work with at a bounded cache cost
+        auto split_clusters(std::vector<uint32_t> const &indices, size_t vertex_count, std::vector<uint32_t> const &clusters) -> std::vector<uint32_t>
+        {
+            uint32_t const triangle_count = static_cast<uint32_t>(indices.size() / 3);
+            vertex_cache cache{vertex_count};
+
+            auto const triangle_misses = [&](uint32_t triangle)
+            {
+                return cache.access(indices[triangle * 3 + 0]) + cache.access(indices[triangle * 3 + 1]) + cache.access(indices[triangle * 3 + 2]);
+            };
+
+            std::vector<uint32_t> result{};
+            result.reserve(clusters.size());
+            for (size_t c = 0; c < clusters.size(); ++c)
+            {
+                uint32_t const start = clusters[c];
+                uint32_t const end   = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+
+                cache.flush();
+                uint32_t cluster_misses = 0;
+                for (uint32_t t = start; t < end; ++t)
+                {
+                    cluster_misses += triangle_misses(t);
+                }
+                float const threshold = mesh_optimizer::overdraw_threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - start);
+
+                result.push_back(start);
+                cache.flush();
+                uint32_t running_misses    = 0;
+                uint32_t running_triangles = 0;
+                for (uint32_t t = start; t < end; ++t)
+                {
+                    running_misses += triangle_misses(t);
+                    ++running_triangles;
+                    if (static_cast<float>(running_misses) <= threshold * static_cast<float>(running_triangles) and t + 1 < end)
+                    {
+                        result.push_back(t + 1);
+                        cache.flush();
+                        running_misses    = 0;
+                        running_triangles = 0;
+                    }
+                }
+            }
+            return result;
+        }
+
+        // Sorts clusters so the ones facing away from the mesh center are drawn first; those are the most likely to
+        // occlude the rest of the mesh, which then fails the depth test instead of being shaded and overwritten
+        void optimize_overdraw(std::vector<uint32_t> &indices, std::vector<model::vertex> const &vertices, std::vector<uint32_t> const &clusters)
+        {
+            uint32_t const triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+            struct cluster final
+            {
+                uint32_t  start    = 0;
+                uint32_t  end      = 0;
+                glm::vec3 centroid = {};
+                glm::vec3 normal   = {};
+                float     area     = 0.0f;
+                float     sort_key = 0.0f;
+            };
+
+            std::vector<cluster> sorted(clusters.size());
+            glm::vec3 mesh_centroid{};
+            float     mesh_area = 0.0f;
+            for (size_t c = 0; c < clusters.size(); ++c)
+            {
+                auto &current = sorted[c];
+                current.start = clusters[c];
+                current.end   = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+
+                for (uint32_t t = current.start; t < current.end; ++t)
+                {
+                    glm::vec3 const &p0 = vertices[indices[t * 3 + 0]].position;
+                    glm::vec3 const &p1 = vertices[indices[t * 3 + 1]].position;
+                    glm::vec3 const &p2 = vertices[indices[t * 3 + 2]].position;
+
+                    glm::vec3 const cross = glm::cross(p1 - p0, p2 - p0);
+                    float const     area  = glm::length(cross);
+
+                    current.centroid += (p0 + p1 + p2) * (area / 3.0f);
+                    current.normal   += cross;
+                    current.area     += area;
+                }
+
+                mesh_centroid += current.centroid;
+                mesh_area     += current.area;
+                current.centroid = current.area > 0.0f ? current.centroid / current.area : glm::vec3{};
+                current.normal   = glm::length(current.normal) > 0.0f ? glm::normalize(current.normal) : glm::vec3{};
+            }
+            mesh_centroid = mesh_area > 0.0f ? mesh_centroid / mesh_area : glm::vec3{};
+
+            for (auto &current : sorted)
+            {
+                current.sort_key = glm::dot(current.centroid - mesh_centroid, current.normal);
+            }
+            std::stable_sort(sorted.begin(), sorted.end(), [](cluster const &a, cluster const &b) { return a.sort_key > b.sort_key; });
+
+            std::vector<uint32_t> result{};
+            result.reserve(indices.size());
+            for (auto const &current : sorted)
+            {
+                result.insert(result.end(), indices.begin() + current.start * 3, indices.begin() + current.end * 3);
+            }
+            indices = std::move(result);
+        }
+
+        // Renumbers vertices in order of first use so the vertex fetch walks memory linearly; unreferenced vertices are dropped
+        void optimize_vertex_fetch(std::vector<model::vertex> &vertices, std::vector<uint32_t> &indices)
+        {
+            std::vector<uint32_t>     remap(vertices.size(), invalid_vertex);
+            std::vector<model::vertex> result{};
+            result.reserve(vertices.size());
+
+            for (uint32_t &index : indices)
+            {
+                if (remap[index] == invalid_vertex)
+                {
+                    remap[index] = static_cast<uint32_t>(result.size());
+                    result.push_back(vertices[index]);
+                }
+                index = remap[index];
+            }
+            vertices = std::move(result);
+        }
+    }
+
+    void mesh_optimizer::optimize(model::builder &builder)
+    {
+        if (builder.indices.empty() or builder.indices.size() % 3 != 0)
+        {
+            return;
+        }
+
+        std::vector<uint32_t> clusters{};
+        optimize_vertex_cache(builder.indices, builder.vertices.size(), clusters);
+        clusters = split_clusters(builder.indices, builder.vertices.size(), clusters);
+        optimize_overdraw(builder.indices, builder.vertices, clusters);
+        optimize_vertex_fetch(builder.vertices, builder.indices);
+    }
+
+    auto mesh_optimizer::analyze(model::builder const &builder) -> statistics
+    {
+        statistics result{};
+        result.triangle_count = static_cast<uint32_t>(builder.indices.size() / 3);
+        if (result.triangle_count == 0)
+        {
+            return result;
+        }
+
+        vertex_cache      cache{builder.vertices.size()};
+        std::vector<bool> referenced(builder.vertices.size(), false);
+        for (uint32_t const index : builder.indices)
+        {
+            result.cache_misses += cache.access(index);
+            if (not referenced[index])
+            {
+                referenced[index] = true;
+                ++result.vertex_count;
+            }
+        }
+
+        result.acmr = static_cast<float>(result.cache_misses) / static_cast<float>(result.triangle_count);
+        result.atvr = static_cast<float>(result.cache_misses) / static_cast<float>(result.vertex_count);
+        return result;
+    }
+}
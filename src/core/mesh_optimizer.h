@@ -0,0 +1,32 @@
+﻿#pragma once
+
+// Project includes
+#include "model.h"
+
+// Standard includes
+#include <cstdint>
+
+namespace dae
+{
+    // Offline reordering of an indexed triangle list for the GPU: Tipsify (Sander et al. 2007) for post-transform cache
+    // hits, cluster sorting for overdraw and a first-use vertex remap for fetch locality
+    struct mesh_optimizer final
+    {
+        struct statistics
+        {
+            uint32_t triangle_count = 0;
+            uint32_t vertex_count   = 0;
+            uint32_t cache_misses   = 0;
+            float    acmr           = 0.0f; // Average cache miss ratio, transformed vertices per triangle (0.5 - 3.0)
+            float    atvr           = 0.0f; // Average transform to vertex ratio, transformed vertices per vertex (1.0+)
+        };
+
+        // Size of the simulated FIFO post-transform cache
+        static constexpr uint32_t cache_size = 16;
+        // How much worse than the Tipsify order a cluster's ACMR may get to allow finer overdraw sorting
+        static constexpr float overdraw_threshold = 1.05f;
+
+        static void optimize(model::builder &builder);
+        [[nodiscard]] static auto analyze(model::builder const &builder) -> statistics;
+    };
+}
@@ -1,14 +1,20 @@
 ﻿#include "model.h"
 
 // Project includes
+#include "src/core/mesh_cache.h"
+#include "src/core/mesh_optimizer.h"
 #include "src/engine/engine.h"
 #include "src/utility/utils.h"
-#include "src/vulkan/device.h"
 
 // Standard includes
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <ranges>
 #include <unordered_map>
 
 // TOL includes
@@ -46,58 +52,68 @@ namespace std
 
 namespace dae
 {
-    auto model::vertex::get_binding_description() -> std::vector<VkVertexInputBindingDescription>
+    namespace
+    {
+        auto pack_unorm16(float value) -> uint16_t
+        {
+            return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+        }
+
+        auto pack_snorm16(float value) -> int16_t
+        {
+            return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        auto pack_unorm8(float value) -> uint8_t
+        {
+            return static_cast<uint8_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+        }
+
+        // Projects the direction onto an octahedron and unfolds the lower half over the upper one; a zero or broken
+        // direction (the builder's tangent on faces without uvs) packs to +z
+        auto pack_octahedral(glm::vec3 const &direction) -> glm::i16vec2
+        {
+            float const length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+            if (not (length > 0.0f) or std::isinf(length))
+            {
+                return {};
+            }
+
+            glm::vec2 folded = glm::vec2{direction} / length;
+            if (direction.z < 0.0f)
+            {
+                glm::vec2 const sign{folded.x >= 0.0f ? 1.0f : -1.0f, folded.y >= 0.0f ? 1.0f : -1.0f};
+                folded = (1.0f - glm::abs(glm::vec2{folded.y, folded.x})) * sign;
+            }
+            return {pack_snorm16(folded.x), pack_snorm16(folded.y)};
+        }
+    }
+
+    auto model::packed_vertex::get_binding_description() -> std::vector<VkVertexInputBindingDescription>
     {
         std::vector<VkVertexInputBindingDescription> binding_description(1);
         binding_description[0].binding   = 0;
-        binding_description[0].stride    = sizeof(vertex);
+        binding_description[0].stride    = sizeof(packed_vertex);
         binding_description[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
         return binding_description;
     }
 
-    auto model::vertex::get_attribute_descriptions() -> std::vector<VkVertexInputAttributeDescription>
+    auto model::packed_vertex::get_attribute_descriptions(uint32_t attributes) -> std::vector<VkVertexInputAttributeDescription>
     {
         std::vector<VkVertexInputAttributeDescription> attribute_descriptions{};
-        VkVertexInputAttributeDescription position{
-            .location = 0,
-            .binding  = 0,
-            .format   = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset   = offsetof(vertex, position)
-        };
-        attribute_descriptions.push_back(position);
-
-        VkVertexInputAttributeDescription color{
-            .location = 1,
-            .binding  = 0,
-            .format   = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset   = offsetof(vertex, color)
-        };
-        attribute_descriptions.push_back(color);
-        
-        VkVertexInputAttributeDescription normal{
-            .location = 2,
-            .binding  = 0,
-            .format   = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset   = offsetof(vertex, normal)
-        };
-        attribute_descriptions.push_back(normal);
-        
-        VkVertexInputAttributeDescription uv{
-            .location = 3,
-            .binding  = 0,
-            .format   = VK_FORMAT_R32G32_SFLOAT,
-            .offset   = offsetof(vertex, uv)
+        auto const add = [&](attribute bit, uint32_t location, VkFormat format, uint32_t offset)
+        {
+            if (attributes & bit)
+            {
+                attribute_descriptions.push_back({.location = location, .binding = 0, .format = format, .offset = offset});
+            }
         };
-        attribute_descriptions.push_back(uv);
 
-        VkVertexInputAttributeDescription tangent{
-            .location = 4,
-            .binding  = 0,
-            .format   = VK_FORMAT_R32G32B32_SFLOAT,
-            .offset   = offsetof(vertex, tangent)
-        };
-        attribute_descriptions.push_back(tangent);
-        
+        add(position_bit, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(packed_vertex, position));
+        add(color_bit,    1, VK_FORMAT_R8G8B8A8_UNORM,     offsetof(packed_vertex, color));
+        add(normal_bit,   2, VK_FORMAT_R16G16_SNORM,       offsetof(packed_vertex, normal));
+        add(uv_bit,       3, VK_FORMAT_R16G16_UNORM,       offsetof(packed_vertex, uv));
+        add(tangent_bit,  4, VK_FORMAT_R16G16_SNORM,       offsetof(packed_vertex, tangent));
         return attribute_descriptions;
     }
 
@@ -107,13 +123,28 @@ namespace dae
     }
 
     void model::builder::load_model(std::string const &file_path)
+    {
+        std::string const path = ENGINE_DIR + engine::data_path + file_path;
+        if (mesh_cache::load(path, *this))
+        {
+            return;
+        }
+
+        load_obj(path);
+        if (optimize)
+        {
+            mesh_optimizer::optimize(*this);
+        }
+        mesh_cache::save(path, *this);
+    }
+
+    void model::builder::load_obj(std::string const &path)
     {
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
         std::vector<tinyobj::material_t> materials;
         std::string warn, err;
 
-        std::string const path = ENGINE_DIR + engine::data_path + file_path;
         if (not tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str()))
         {
             throw std::runtime_error{warn + err};
@@ -207,14 +238,107 @@ namespace dae
         }
     }
 
+    template<typename index_type>
+    auto model::builder::split() const -> split_mesh<index_type>
+    {
+        // The all-ones index stays unused so primitive restart could be turned on without touching the data
+        constexpr size_t max_vertices = std::numeric_limits<index_type>::max();
+
+        split_mesh<index_type> result{};
+        if (vertices.size() <= max_vertices)
+        {
+            result.vertices = vertices;
+            result.indices.reserve(indices.size());
+            std::ranges::transform(indices, std::back_inserter(result.indices), [](uint32_t index) { return static_cast<index_type>(index); });
+            result.submeshes.push_back({0, static_cast<uint32_t>(indices.size()), 0});
+            return result;
+        }
+
+        // Greedy in triangle order, which the mesh optimizer already made local, so cuts duplicate few vertices
+        constexpr uint32_t unassigned = ~0u;
+        std::vector<uint32_t> local(vertices.size(), unassigned);
+        std::vector<uint32_t> used{};
+        submesh current{};
+
+        auto const close = [&]()
+        {
+            current.index_count = static_cast<uint32_t>(result.indices.size()) - current.first_index;
+            if (current.index_count > 0)
+            {
+                result.submeshes.push_back(current);
+            }
+            for (uint32_t const vertex : used)
+            {
+                local[vertex] = unassigned;
+            }
+            used.clear();
+            current.first_index   = static_cast<uint32_t>(result.indices.size());
+            current.vertex_offset = static_cast<int32_t>(result.vertices.size());
+        };
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            size_t new_vertices = 0;
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                new_vertices += local[indices[i + corner]] == unassigned ? 1 : 0;
+            }
+            if (used.size() + new_vertices > max_vertices)
+            {
+                close();
+            }
+
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                uint32_t const vertex = indices[i + corner];
+                if (local[vertex] == unassigned)
+                {
+                    local[vertex] = static_cast<uint32_t>(used.size());
+                    used.push_back(vertex);
+                    result.vertices.push_back(vertices[vertex]);
+                }
+                result.indices.push_back(static_cast<index_type>(local[vertex]));
+            }
+        }
+        close();
+        return result;
+    }
+
+    template auto model::builder::split<uint16_t>() const -> split_mesh<uint16_t>;
+    template auto model::builder::split<uint32_t>() const -> split_mesh<uint32_t>;
+
     model::model(builder const &builder)
-        : device_ptr_{&device::instance()}
     {
-        create_vertex_buffers(builder.vertices);
-        create_index_buffers(builder.indices);
+        assert(builder.vertices.size() >= 3 and "Vertex count must be at least 3!");
+        compute_bounds(builder.vertices);
+
+        auto &arena = geometry_arena::instance();
+        if (builder.indices.empty())
+        {
+            auto const packed = pack(builder.vertices);
+            vertices_ = arena.allocate_vertices(packed.data(), static_cast<uint32_t>(packed.size()));
+            return;
+        }
+
+        auto const mesh = builder.split<geometry_arena::index_type>();
+        auto const packed = pack(mesh.vertices);
+        vertices_ = arena.allocate_vertices(packed.data(), static_cast<uint32_t>(packed.size()));
+        indices_ = arena.allocate_indices(mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()));
+
+        submeshes_ = mesh.submeshes;
+        for (auto &submesh : submeshes_)
+        {
+            submesh.first_index   += indices_.first;
+            submesh.vertex_offset += static_cast<int32_t>(vertices_.first);
+        }
     }
 
-    model::~model() = default;
+    model::~model()
+    {
+        auto &arena = geometry_arena::instance();
+        arena.free_vertices(vertices_);
+        arena.free_indices(indices_);
+    }
 
     auto model::create_model(std::string const &file_path) -> std::unique_ptr<model>
     {
@@ -236,87 +360,89 @@ namespace dae
         return std::make_unique<model>(builder);
     }
 
-    void model::bind(VkCommandBuffer command_buffer)
+    auto model::draw(VkCommandBuffer command_buffer, uint32_t instance_count, uint32_t first_instance) const -> uint32_t
     {
-        VkBuffer     buffers[] = {vertex_buffer_->get_buffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
-
-        if (has_index_buffer_)
+        if (has_indices())
         {
-            vkCmdBindIndexBuffer(command_buffer, index_buffer_->get_buffer(), 0, VK_INDEX_TYPE_UINT32);
+            for (auto const &submesh : submeshes_)
+            {
+                vkCmdDrawIndexed(command_buffer, submesh.index_count, instance_count, submesh.first_index, submesh.vertex_offset, first_instance);
+            }
+            return static_cast<uint32_t>(submeshes_.size());
         }
+        vkCmdDraw(command_buffer, vertices_.count, instance_count, vertices_.first, first_instance);
+        return 1;
     }
 
-    void model::draw(VkCommandBuffer command_buffer)
+    void model::compute_bounds(std::vector<vertex> const &vertices)
     {
-        if (has_index_buffer_)
+        if (vertices.empty())
         {
-            vkCmdDrawIndexed(command_buffer, index_count_, 1, 0, 0, 0);
+            return;
         }
-        else
+
+        bounds_min_ = vertices.front().position;
+        bounds_max_ = vertices.front().position;
+        glm::vec2 uv_min = vertices.front().uv;
+        glm::vec2 uv_max = vertices.front().uv;
+        for (auto const &v : vertices)
         {
-            vkCmdDraw(command_buffer, vertex_count_, 1, 0, 0);
+            bounds_min_ = glm::min(bounds_min_, v.position);
+            bounds_max_ = glm::max(bounds_max_, v.position);
+            uv_min = glm::min(uv_min, v.uv);
+            uv_max = glm::max(uv_max, v.uv);
         }
-    }
-
-    void model::create_vertex_buffers(std::vector<vertex> const &vertices)
-    {
-        vertex_count_ = static_cast<uint32_t>(vertices.size());
-        assert(vertex_count_ >= 3 and "Vertex count must be at least 3!");
-        VkDeviceSize buffer_size = sizeof(vertices[0]) * vertex_count_;
-        uint32_t vertex_size = sizeof(vertices[0]);
-
-        buffer staging_buffer {
-            vertex_size,
-            vertex_count_,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
 
-        staging_buffer.map();
-        staging_buffer.write_to_buffer(const_cast<vertex*>(vertices.data()));
+        // Centered on the box; not the tightest sphere, but close and a single extra pass
+        bounding_center_ = (bounds_min_ + bounds_max_) * 0.5f;
 
-        vertex_buffer_ = std::make_unique<buffer>(
-            vertex_size,
-            vertex_count_,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
-        device_ptr_->copy_buffer(staging_buffer.get_buffer(), vertex_buffer_->get_buffer(), buffer_size);
+        float radius_squared = 0.0f;
+        for (auto const &v : vertices)
+        {
+            glm::vec3 const offset = v.position - bounding_center_;
+            radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+        }
+        bounding_radius_ = std::sqrt(radius_squared);
+
+        // Flat models have a zero extent on some axis; that column of the matrix then collapses every vertex onto it
+        glm::vec3 const extent = bounds_max_ - bounds_min_;
+        dequantization_ = glm::mat4{
+            glm::vec4{extent.x, 0.0f, 0.0f, 0.0f},
+            glm::vec4{0.0f, extent.y, 0.0f, 0.0f},
+            glm::vec4{0.0f, 0.0f, extent.z, 0.0f},
+            glm::vec4{bounds_min_, 1.0f}
+        };
+        uv_transform_ = glm::vec4{uv_min, uv_max - uv_min};
     }
 
-    void model::create_index_buffers(std::vector<uint32_t> const& indices)
+    auto model::pack(std::vector<vertex> const &vertices) const -> std::vector<packed_vertex>
     {
-        index_count_ = static_cast<uint32_t>(indices.size());
-        has_index_buffer_ = index_count_ > 0;
+        glm::vec3 const extent = bounds_max_ - bounds_min_;
+        glm::vec3 const inverse_extent{
+            extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 1.0f / extent.z : 0.0f
+        };
+        glm::vec2 const uv_min{uv_transform_.x, uv_transform_.y};
+        glm::vec2 const inverse_uv_extent{
+            uv_transform_.z > 0.0f ? 1.0f / uv_transform_.z : 0.0f,
+            uv_transform_.w > 0.0f ? 1.0f / uv_transform_.w : 0.0f
+        };
 
-        if (not has_index_buffer_)
+        std::vector<packed_vertex> packed(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
         {
-            return;
+            auto const &source = vertices[i];
+            auto &target = packed[i];
+
+            glm::vec3 const position = (source.position - bounds_min_) * inverse_extent;
+            glm::vec2 const uv       = (source.uv - uv_min) * inverse_uv_extent;
+            target.position = {pack_unorm16(position.x), pack_unorm16(position.y), pack_unorm16(position.z), 0};
+            target.color    = {pack_unorm8(source.color.r), pack_unorm8(source.color.g), pack_unorm8(source.color.b), 255};
+            target.normal   = pack_octahedral(source.normal);
+            target.uv       = {pack_unorm16(uv.x), pack_unorm16(uv.y)};
+            target.tangent  = pack_octahedral(source.tangent);
         }
-        
-        VkDeviceSize buffer_size = sizeof(indices[0]) * index_count_;
-        uint32_t index_size = sizeof(indices[0]);
-
-        buffer staging_buffer {
-            index_size,
-            index_count_,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        staging_buffer.map();
-        staging_buffer.write_to_buffer((void*) indices.data());
-
-        index_buffer_ = std::make_unique<buffer>(
-            index_size,
-            index_count_,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
-        device_ptr_->copy_buffer(staging_buffer.get_buffer(), index_buffer_->get_buffer(), buffer_size);
+        return packed;
     }
 }
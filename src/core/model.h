@@ -1,7 +1,7 @@
 ﻿#pragma once
 
 // Project includes
-#include "src/vulkan/buffer.h"
+#include "src/vulkan/geometry_arena.h"
 
 // Standard includes
 #include <memory>
@@ -12,15 +12,14 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 namespace dae
 {
-    // Forward declarations
-    class device;
-    
     class model final
     {
     public:
+        // Full precision vertex the builder, mesh optimizer and mesh cache work with
         struct vertex
         {
             glm::vec3 position = {};
@@ -29,10 +28,51 @@ namespace dae
             glm::vec2 uv       = {};
             glm::vec3 tangent  = {};
 
+            bool operator==(vertex const &other) const;
+        };
+
+        // 24 byte vertex as stored in the geometry arena. Positions are unorm16 inside the model's bounds and are
+        // decoded by folding dequantization() into the model matrix; normals and tangents are octahedral snorm16 (the
+        // builder bakes the tangent's handedness into its direction, so no separate sign is needed), uvs are unorm16
+        // inside the model's uv bounds and are decoded with uv_transform()
+        struct packed_vertex
+        {
+            // Attributes a pipeline fetches, locations follow the bit order
+            enum attribute : uint32_t
+            {
+                position_bit = 1u << 0,
+                color_bit    = 1u << 1,
+                normal_bit   = 1u << 2,
+                uv_bit       = 1u << 3,
+                tangent_bit  = 1u << 4,
+                all_bits     = position_bit | color_bit | normal_bit | uv_bit | tangent_bit
+            };
+
+            glm::u16vec4 position = {}; // w unused, keeps the attribute 8 byte aligned
+            glm::u8vec4  color    = {};
+            glm::i16vec2 normal   = {};
+            glm::u16vec2 uv       = {};
+            glm::i16vec2 tangent  = {};
+
             static auto get_binding_description() -> std::vector<VkVertexInputBindingDescription>;
-            static auto get_attribute_descriptions() -> std::vector<VkVertexInputAttributeDescription>;
+            static auto get_attribute_descriptions(uint32_t attributes = all_bits) -> std::vector<VkVertexInputAttributeDescription>;
+        };
 
-            bool operator==(vertex const &other) const;
+        // Index range drawn with its own vertex offset; relative to the model in a split_mesh, absolute arena
+        // elements once uploaded
+        struct submesh
+        {
+            uint32_t first_index   = 0;
+            uint32_t index_count   = 0;
+            int32_t  vertex_offset = 0;
+        };
+
+        template<typename index_type>
+        struct split_mesh
+        {
+            std::vector<vertex>     vertices  = {};
+            std::vector<index_type> indices   = {};
+            std::vector<submesh>    submeshes = {};
         };
 
         struct builder
@@ -40,7 +80,18 @@ namespace dae
             std::vector<vertex> vertices = {};
             std::vector<uint32_t>   indices = {};
 
+            // Run the mesh optimizer on freshly parsed meshes; the result is what gets cached
+            bool optimize = true;
+
             void load_model(std::string const &file_path);
+
+            // Cuts the triangle list into submeshes whose vertices index_type can address, duplicating the vertices
+            // shared across a cut; meshes that already fit come back as a single submesh
+            template<typename index_type>
+            [[nodiscard]] auto split() const -> split_mesh<index_type>;
+
+        private:
+            void load_obj(std::string const &path);
         };
         
         explicit model(builder const &builder);
@@ -54,22 +105,39 @@ namespace dae
         static auto create_model(std::string const &file_path) -> std::unique_ptr<model>;
         static auto create_model(std::vector<vertex> const &vertices) -> std::unique_ptr<model>;
 
-        void bind(VkCommandBuffer command_buffer);
-        void draw(VkCommandBuffer command_buffer);
+        // Object space box and sphere around every vertex
+        [[nodiscard]] auto bounds_min() const -> glm::vec3 const & { return bounds_min_; }
+        [[nodiscard]] auto bounds_max() const -> glm::vec3 const & { return bounds_max_; }
+        [[nodiscard]] auto bounding_center() const -> glm::vec3 const & { return bounding_center_; }
+        [[nodiscard]] auto bounding_radius() const -> float { return bounding_radius_; }
+
+        // Maps packed unorm positions back to object space; right-multiply it onto the model matrix the shaders see
+        [[nodiscard]] auto dequantization() const -> glm::mat4 const & { return dequantization_; }
+        // Maps packed unorm uvs back to the model's own, so tiling uvs survive packing; xy is the offset, zw the scale
+        [[nodiscard]] auto uv_transform() const -> glm::vec4 const & { return uv_transform_; }
+
+        // Ranges in the geometry arena; each submesh is one indexed draw
+        [[nodiscard]] auto has_indices() const -> bool { return indices_.count > 0; }
+        [[nodiscard]] auto vertex_count() const -> uint32_t { return vertices_.count; }
+        [[nodiscard]] auto submeshes() const -> std::vector<submesh> const & { return submeshes_; }
+
+        // Expects the geometry arena to be bound, see geometry_arena::bind(); returns how many draws were recorded
+        auto draw(VkCommandBuffer command_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0) const -> uint32_t;
 
     private:
-        void create_vertex_buffers(std::vector<vertex> const &vertices);
-        void create_index_buffers(std::vector<uint32_t> const &indices);
-        
+        void compute_bounds(std::vector<vertex> const &vertices);
+        [[nodiscard]] auto pack(std::vector<vertex> const &vertices) const -> std::vector<packed_vertex>;
 
     private:
-        device *device_ptr_ = nullptr;
-        
-        std::unique_ptr<buffer> vertex_buffer_ = nullptr;
-        uint32_t                vertex_count_  = 0;
+        geometry_arena::range vertices_{};
+        geometry_arena::range indices_{};
+        std::vector<submesh>  submeshes_{};
 
-        bool                    has_index_buffer_ = false;
-        std::unique_ptr<buffer> index_buffer_     = nullptr;
-        uint32_t                index_count_      = 0;
+        glm::vec3 bounds_min_      = {};
+        glm::vec3 bounds_max_      = {};
+        glm::vec3 bounding_center_ = {};
+        float     bounding_radius_ = 0.0f;
+        glm::mat4 dequantization_  = {1.0f};
+        glm::vec4 uv_transform_    = {0.0f, 0.0f, 1.0f, 1.0f};
     };
 }
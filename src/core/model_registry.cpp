@@ -0,0 +1,26 @@
+﻿#include "model_registry.h"
+
+// Standard includes
+#include <iostream>
+
+namespace dae
+{
+    auto model_registry::load(std::string const &file_path) -> std::shared_ptr<model>
+    {
+        std::lock_guard lock{mutex_};
+        if (auto const it = models_.find(file_path); it != models_.end())
+        {
+            if (auto shared_model = it->second.lock())
+            {
+#ifndef NDEBUG
+                std::cout << "Reusing model: " << file_path << '\n';
+#endif
+                return shared_model;
+            }
+        }
+
+        std::shared_ptr<model> shared_model = model::create_model(file_path);
+        models_[file_path] = shared_model;
+        return shared_model;
+    }
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+// Project includes
+#include "src/core/model.h"
+#include "src/utility/singleton.h"
+
+// Standard includes
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace dae
+{
+    // Hands out shared models keyed by asset path so every OBJ is parsed and uploaded once.
+    // Entries are weak: a model is released as soon as the last game object referencing it goes away.
+    class model_registry final : public singleton<model_registry>
+    {
+    public:
+        ~model_registry() override = default;
+
+        model_registry(model_registry const &other)            = delete;
+        model_registry(model_registry &&other)                 = delete;
+        model_registry &operator=(model_registry const &other) = delete;
+        model_registry &operator=(model_registry &&other)      = delete;
+
+        auto load(std::string const &file_path) -> std::shared_ptr<model>;
+
+    private:
+        friend class singleton<model_registry>;
+        model_registry() = default;
+
+    private:
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::weak_ptr<model>> models_;
+    };
+}
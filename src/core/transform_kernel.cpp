@@ -0,0 +1,330 @@
+﻿#include "transform_kernel.h"
+
+// Project includes
+#include "src/core/game_object.h"
+
+// Standard includes
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DAE_TRANSFORM_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts any intrinsic without a compiler flag, GCC and Clang need the functions that use them marked
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DAE_TARGET_SSE2
+#define DAE_TARGET_AVX2
+#else
+#define DAE_TARGET_SSE2 __attribute__((target("sse2")))
+#define DAE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace dae
+{
+    namespace
+    {
+        void compute_scalar(transform_kernel::input const &in, size_t first, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices)
+        {
+            for (size_t i = first; i < count; ++i)
+            {
+                glm::vec3 const rotation{in.rotation_x[i], in.rotation_y[i], in.rotation_z[i]};
+                glm::vec3 const scale{in.scale_x[i], in.scale_y[i], in.scale_z[i]};
+                if (matrices)
+                {
+                    glm::vec3 const translation{in.translation_x[i], in.translation_y[i], in.translation_z[i]};
+                    matrices[i] = transform_component::make_matrix(translation, rotation, scale);
+                }
+                if (normal_matrices)
+                {
+                    normal_matrices[i] = transform_component::make_normal_matrix(rotation, scale);
+                }
+            }
+        }
+
+#if defined(DAE_TRANSFORM_KERNEL_X86)
+        // Cephes single precision sincos: reduce to [-pi/4, pi/4] by octant, evaluate both minimax polynomials and
+        // pick/negate per lane. Accurate to ~1 ulp for |x| < 8192, far beyond any sane Euler angle.
+        constexpr float four_over_pi = 1.27323954473516f;
+        constexpr float dp1          = -0.78515625f;
+        constexpr float dp2          = -2.4187564849853515625e-4f;
+        constexpr float dp3          = -3.77489497744594108e-8f;
+        constexpr float sin_p0       = -1.9515295891e-4f;
+        constexpr float sin_p1       = 8.3321608736e-3f;
+        constexpr float sin_p2       = -1.6666654611e-1f;
+        constexpr float cos_p0       = 2.443315711809948e-5f;
+        constexpr float cos_p1       = -1.388731625493765e-3f;
+        constexpr float cos_p2       = 4.166664568298827e-2f;
+
+        DAE_TARGET_SSE2 void sincos_sse2(__m128 x, __m128 &out_sin, __m128 &out_cos)
+        {
+            __m128 const sign_mask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+            __m128 sign_sin = _mm_and_ps(x, sign_mask);
+            x = _mm_andnot_ps(sign_mask, x);
+
+            __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(four_over_pi)));
+            j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+            __m128 const y = _mm_cvtepi32_ps(j);
+
+            __m128 const swap_sign_sin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+            __m128 const sign_cos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+            __m128 const poly_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+            sign_sin = _mm_xor_ps(sign_sin, swap_sign_sin);
+
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(dp1)));
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(dp2)));
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(dp3)));
+            __m128 const z = _mm_mul_ps(x, x);
+
+            __m128 cos_poly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cos_p0), z), _mm_set1_ps(cos_p1));
+            cos_poly = _mm_add_ps(_mm_mul_ps(cos_poly, z), _mm_set1_ps(cos_p2));
+            cos_poly = _mm_mul_ps(_mm_mul_ps(cos_poly, z), z);
+            cos_poly = _mm_sub_ps(cos_poly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+            cos_poly = _mm_add_ps(cos_poly, _mm_set1_ps(1.0f));
+
+            __m128 sin_poly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sin_p0), z), _mm_set1_ps(sin_p1));
+            sin_poly = _mm_add_ps(_mm_mul_ps(sin_poly, z), _mm_set1_ps(sin_p2));
+            sin_poly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sin_poly, z), x), x);
+
+            __m128 const s = _mm_or_ps(_mm_and_ps(poly_mask, sin_poly), _mm_andnot_ps(poly_mask, cos_poly));
+            __m128 const c = _mm_or_ps(_mm_and_ps(poly_mask, cos_poly), _mm_andnot_ps(poly_mask, sin_poly));
+            out_sin = _mm_xor_ps(s, sign_sin);
+            out_cos = _mm_xor_ps(c, sign_cos);
+        }
+
+        // Transposes one column of 4 matrices held as 4 row vectors across lanes and stores it
+        DAE_TARGET_SSE2 void store_column_sse2(glm::mat4 *out, int column, __m128 r0, __m128 r1, __m128 r2, __m128 r3)
+        {
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&out[0][column][0], r0);
+            _mm_storeu_ps(&out[1][column][0], r1);
+            _mm_storeu_ps(&out[2][column][0], r2);
+            _mm_storeu_ps(&out[3][column][0], r3);
+        }
+
+        DAE_TARGET_SSE2 auto compute_sse2(transform_kernel::input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices) -> size_t
+        {
+            __m128 const zero = _mm_setzero_ps();
+            __m128 const one  = _mm_set1_ps(1.0f);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 s1, c1, s2, c2, s3, c3;
+                sincos_sse2(_mm_loadu_ps(in.rotation_y + i), s1, c1);
+                sincos_sse2(_mm_loadu_ps(in.rotation_x + i), s2, c2);
+                sincos_sse2(_mm_loadu_ps(in.rotation_z + i), s3, c3);
+
+                // Rotation basis, see transform_component::make_matrix
+                __m128 const s1s2 = _mm_mul_ps(s1, s2);
+                __m128 const c1s2 = _mm_mul_ps(c1, s2);
+                __m128 const r00  = _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3));
+                __m128 const r01  = _mm_mul_ps(c2, s3);
+                __m128 const r02  = _mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1));
+                __m128 const r10  = _mm_sub_ps(_mm_mul_ps(s1s2, c3), _mm_mul_ps(c1, s3));
+                __m128 const r11  = _mm_mul_ps(c2, c3);
+                __m128 const r12  = _mm_add_ps(_mm_mul_ps(c1s2, c3), _mm_mul_ps(s1, s3));
+                __m128 const r20  = _mm_mul_ps(c2, s1);
+                __m128 const r21  = _mm_sub_ps(zero, s2);
+                __m128 const r22  = _mm_mul_ps(c1, c2);
+
+                __m128 const sx = _mm_loadu_ps(in.scale_x + i);
+                __m128 const sy = _mm_loadu_ps(in.scale_y + i);
+                __m128 const sz = _mm_loadu_ps(in.scale_z + i);
+                if (matrices)
+                {
+                    store_column_sse2(matrices + i, 0, _mm_mul_ps(sx, r00), _mm_mul_ps(sx, r01), _mm_mul_ps(sx, r02), zero);
+                    store_column_sse2(matrices + i, 1, _mm_mul_ps(sy, r10), _mm_mul_ps(sy, r11), _mm_mul_ps(sy, r12), zero);
+                    store_column_sse2(matrices + i, 2, _mm_mul_ps(sz, r20), _mm_mul_ps(sz, r21), _mm_mul_ps(sz, r22), zero);
+                    store_column_sse2(matrices + i, 3, _mm_loadu_ps(in.translation_x + i), _mm_loadu_ps(in.translation_y + i), _mm_loadu_ps(in.translation_z + i), one);
+                }
+                if (normal_matrices)
+                {
+                    __m128 const ix = _mm_div_ps(one, sx);
+                    __m128 const iy = _mm_div_ps(one, sy);
+                    __m128 const iz = _mm_div_ps(one, sz);
+                    store_column_sse2(normal_matrices + i, 0, _mm_mul_ps(ix, r00), _mm_mul_ps(ix, r01), _mm_mul_ps(ix, r02), zero);
+                    store_column_sse2(normal_matrices + i, 1, _mm_mul_ps(iy, r10), _mm_mul_ps(iy, r11), _mm_mul_ps(iy, r12), zero);
+                    store_column_sse2(normal_matrices + i, 2, _mm_mul_ps(iz, r20), _mm_mul_ps(iz, r21), _mm_mul_ps(iz, r22), zero);
+                    store_column_sse2(normal_matrices + i, 3, zero, zero, zero, one);
+                }
+            }
+            return i;
+        }
+
+        DAE_TARGET_AVX2 void sincos_avx2(__m256 x, __m256 &out_sin, __m256 &out_cos)
+        {
+            __m256 const sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000)));
+            __m256 sign_sin = _mm256_and_ps(x, sign_mask);
+            x = _mm256_andnot_ps(sign_mask, x);
+
+            __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(four_over_pi)));
+            j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+            __m256 const y = _mm256_cvtepi32_ps(j);
+
+            __m256 const swap_sign_sin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+            __m256 const sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+            __m256 const poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+            sign_sin = _mm256_xor_ps(sign_sin, swap_sign_sin);
+
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(dp1)));
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(dp2)));
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(dp3)));
+            __m256 const z = _mm256_mul_ps(x, x);
+
+            __m256 cos_poly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(cos_p0), z), _mm256_set1_ps(cos_p1));
+            cos_poly = _mm256_add_ps(_mm256_mul_ps(cos_poly, z), _mm256_set1_ps(cos_p2));
+            cos_poly = _mm256_mul_ps(_mm256_mul_ps(cos_poly, z), z);
+            cos_poly = _mm256_sub_ps(cos_poly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+            cos_poly = _mm256_add_ps(cos_poly, _mm256_set1_ps(1.0f));
+
+            __m256 sin_poly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(sin_p0), z), _mm256_set1_ps(sin_p1));
+            sin_poly = _mm256_add_ps(_mm256_mul_ps(sin_poly, z), _mm256_set1_ps(sin_p2));
+            sin_poly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sin_poly, z), x), x);
+
+            __m256 const s = _mm256_blendv_ps(cos_poly, sin_poly, poly_mask);
+            __m256 const c = _mm256_blendv_ps(sin_poly, cos_poly, poly_mask);
+            out_sin = _mm256_xor_ps(s, sign_sin);
+            out_cos = _mm256_xor_ps(c, sign_cos);
+        }
+
+        // Same as store_column_sse2 for 8 matrices, one 4x4 transpose per 128-bit half
+        DAE_TARGET_AVX2 void store_column_avx2(glm::mat4 *out, int column, __m256 r0, __m256 r1, __m256 r2, __m256 r3)
+        {
+            __m128 a0 = _mm256_castps256_ps128(r0);
+            __m128 a1 = _mm256_castps256_ps128(r1);
+            __m128 a2 = _mm256_castps256_ps128(r2);
+            __m128 a3 = _mm256_castps256_ps128(r3);
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _mm_storeu_ps(&out[0][column][0], a0);
+            _mm_storeu_ps(&out[1][column][0], a1);
+            _mm_storeu_ps(&out[2][column][0], a2);
+            _mm_storeu_ps(&out[3][column][0], a3);
+
+            __m128 b0 = _mm256_extractf128_ps(r0, 1);
+            __m128 b1 = _mm256_extractf128_ps(r1, 1);
+            __m128 b2 = _mm256_extractf128_ps(r2, 1);
+            __m128 b3 = _mm256_extractf128_ps(r3, 1);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+            _mm_storeu_ps(&out[4][column][0], b0);
+            _mm_storeu_ps(&out[5][column][0], b1);
+            _mm_storeu_ps(&out[6][column][0], b2);
+            _mm_storeu_ps(&out[7][column][0], b3);
+        }
+
+        DAE_TARGET_AVX2 auto compute_avx2(transform_kernel::input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices) -> size_t
+        {
+            __m256 const zero = _mm256_setzero_ps();
+            __m256 const one  = _mm256_set1_ps(1.0f);
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 s1, c1, s2, c2, s3, c3;
+                sincos_avx2(_mm256_loadu_ps(in.rotation_y + i), s1, c1);
+                sincos_avx2(_mm256_loadu_ps(in.rotation_x + i), s2, c2);
+                sincos_avx2(_mm256_loadu_ps(in.rotation_z + i), s3, c3);
+
+                // Rotation basis, see transform_component::make_matrix
+                __m256 const s1s2 = _mm256_mul_ps(s1, s2);
+                __m256 const c1s2 = _mm256_mul_ps(c1, s2);
+                __m256 const r00  = _mm256_add_ps(_mm256_mul_ps(c1, c3), _mm256_mul_ps(s1s2, s3));
+                __m256 const r01  = _mm256_mul_ps(c2, s3);
+                __m256 const r02  = _mm256_sub_ps(_mm256_mul_ps(c1s2, s3), _mm256_mul_ps(c3, s1));
+                __m256 const r10  = _mm256_sub_ps(_mm256_mul_ps(s1s2, c3), _mm256_mul_ps(c1, s3));
+                __m256 const r11  = _mm256_mul_ps(c2, c3);
+                __m256 const r12  = _mm256_add_ps(_mm256_mul_ps(c1s2, c3), _mm256_mul_ps(s1, s3));
+                __m256 const r20  = _mm256_mul_ps(c2, s1);
+                __m256 const r21  = _mm256_sub_ps(zero, s2);
+                __m256 const r22  = _mm256_mul_ps(c1, c2);
+
+                __m256 const sx = _mm256_loadu_ps(in.scale_x + i);
+                __m256 const sy = _mm256_loadu_ps(in.scale_y + i);
+                __m256 const sz = _mm256_loadu_ps(in.scale_z + i);
+                if (matrices)
+                {
+                    store_column_avx2(matrices + i, 0, _mm256_mul_ps(sx, r00), _mm256_mul_ps(sx, r01), _mm256_mul_ps(sx, r02), zero);
+                    store_column_avx2(matrices + i, 1, _mm256_mul_ps(sy, r10), _mm256_mul_ps(sy, r11), _mm256_mul_ps(sy, r12), zero);
+                    store_column_avx2(matrices + i, 2, _mm256_mul_ps(sz, r20), _mm256_mul_ps(sz, r21), _mm256_mul_ps(sz, r22), zero);
+                    store_column_avx2(matrices + i, 3, _mm256_loadu_ps(in.translation_x + i), _mm256_loadu_ps(in.translation_y + i), _mm256_loadu_ps(in.translation_z + i), one);
+                }
+                if (normal_matrices)
+                {
+                    __m256 const ix = _mm256_div_ps(one, sx);
+                    __m256 const iy = _mm256_div_ps(one, sy);
+                    __m256 const iz = _mm256_div_ps(one, sz);
+                    store_column_avx2(normal_matrices + i, 0, _mm256_mul_ps(ix, r00), _mm256_mul_ps(ix, r01), _mm256_mul_ps(ix, r02), zero);
+                    store_column_avx2(normal_matrices + i, 1, _mm256_mul_ps(iy, r10), _mm256_mul_ps(iy, r11), _mm256_mul_ps(iy, r12), zero);
+                    store_column_avx2(normal_matrices + i, 2, _mm256_mul_ps(iz, r20), _mm256_mul_ps(iz, r21), _mm256_mul_ps(iz, r22), zero);
+                    store_column_avx2(normal_matrices + i, 3, zero, zero, zero, one);
+                }
+            }
+            return i;
+        }
+
+        auto cpu_supports_avx2() -> bool
+        {
+#if defined(_MSC_VER)
+            int info[4]{};
+            __cpuid(info, 0);
+            if (info[0] < 7)
+            {
+                return false;
+            }
+            __cpuid(info, 1);
+            bool const os_saves_ymm = (info[2] & (1 << 27)) and (info[2] & (1 << 28)) and (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            return os_saves_ymm and (info[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+    }
+
+    void transform_kernel::compute(input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices)
+    {
+        static isa const target = best_isa();
+        compute(target, in, count, matrices, normal_matrices);
+    }
+
+    void transform_kernel::compute(isa target, input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices)
+    {
+        size_t done = 0;
+#if defined(DAE_TRANSFORM_KERNEL_X86)
+        switch (target)
+        {
+            case isa::avx2:
+                done = compute_avx2(in, count, matrices, normal_matrices);
+                break;
+            case isa::sse2:
+                done = compute_sse2(in, count, matrices, normal_matrices);
+                break;
+            case isa::scalar:
+                break;
+        }
+#endif
+        compute_scalar(in, done, count, matrices, normal_matrices);
+    }
+
+    auto transform_kernel::best_isa() -> isa
+    {
+#if defined(DAE_TRANSFORM_KERNEL_X86)
+        return cpu_supports_avx2() ? isa::avx2 : isa::sse2;
+#else
+        return isa::scalar;
+#endif
+    }
+
+    auto transform_kernel::isa_name(isa target) -> char const *
+    {
+        switch (target)
+        {
+            case isa::scalar: return "scalar";
+            case isa::sse2:   return "sse2";
+            case isa::avx2:   return "avx2";
+        }
+        return "unknown";
+    }
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+// Standard includes
+#include <cstddef>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+namespace dae
+{
+    // Batch version of transform_component::make_matrix()/make_normal_matrix() over struct-of-arrays input. Objects
+    // are processed 4 (SSE2) or 8 (AVX2) at a time with a vectorized sincos; the instruction set is picked once at
+    // runtime and falls back to the scalar per-object path on other CPUs and for the tail of a batch.
+    struct transform_kernel final
+    {
+        enum class isa
+        {
+            scalar,
+            sse2,
+            avx2
+        };
+
+        // Every array holds count elements, rotations are Tait-Bryan angles in radians
+        struct input
+        {
+            float const *translation_x = nullptr;
+            float const *translation_y = nullptr;
+            float const *translation_z = nullptr;
+            float const *rotation_x    = nullptr;
+            float const *rotation_y    = nullptr;
+            float const *rotation_z    = nullptr;
+            float const *scale_x       = nullptr;
+            float const *scale_y       = nullptr;
+            float const *scale_z       = nullptr;
+        };
+
+        // Writes count world matrices and count normal matrices; either output may be nullptr
+        static void compute(input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices);
+        static void compute(isa target, input const &in, size_t count, glm::mat4 *matrices, glm::mat4 *normal_matrices);
+
+        [[nodiscard]] static auto best_isa() -> isa;
+        [[nodiscard]] static auto isa_name(isa target) -> char const *;
+    };
+}
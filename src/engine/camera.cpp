@@ -1,6 +1,7 @@
 ﻿#include "camera.h"
 
 // Standard includes
+#include <algorithm>
 #include <cassert>
 #include <limits>
 
@@ -30,6 +31,54 @@ namespace dae
         projection_matrix_[3][2] = -(far * near) / (far - near);
     }
 
+    auto camera::screen_coverage(glm::vec3 const &center, float radius) const -> float
+    {
+        float const scale = glm::abs(projection_matrix_[1][1]);
+        if (projection_matrix_[2][3] == 0.0f)
+        {
+            return radius * scale; // orthographic
+        }
+
+        float const depth = (view_matrix_ * glm::vec4{center, 1.0f}).z;
+        if (depth < -radius)
+        {
+            return 0.0f; // entirely behind the camera
+        }
+        if (depth <= radius)
+        {
+            return 1.0f; // around the camera plane
+        }
+        return std::min(radius * scale / depth, 1.0f);
+    }
+
+    auto camera::frustum_planes() const -> std::array<glm::vec4, 6>
+    {
+        // Gribb/Hartmann on the rows of the clip matrix; depth is zero to one, so near is the third row by itself
+        glm::mat4 const clip = glm::transpose(projection_matrix_ * view_matrix_);
+        std::array<glm::vec4, 6> planes{
+            clip[3] + clip[0],
+            clip[3] - clip[0],
+            clip[3] + clip[1],
+            clip[3] - clip[1],
+            clip[2],
+            clip[3] - clip[2]
+        };
+        for (auto &plane : planes)
+        {
+            plane /= glm::length(glm::vec3{plane});
+        }
+        return planes;
+    }
+
+    void camera::screen_ray(glm::vec2 const &ndc, glm::vec3 &origin, glm::vec3 &direction) const
+    {
+        glm::mat4 const inverse_clip = glm::inverse(projection_matrix_ * view_matrix_);
+        glm::vec4 const near_point = inverse_clip * glm::vec4{ndc, 0.0f, 1.0f};
+        glm::vec4 const far_point = inverse_clip * glm::vec4{ndc, 1.0f, 1.0f};
+        origin = glm::vec3{near_point} / near_point.w;
+        direction = glm::vec3{far_point} / far_point.w - origin;
+    }
+
     void camera::set_view_direction(glm::vec3 position, glm::vec3 direction, glm::vec3 up)
     {
           const glm::vec3 w{glm::normalize(direction)};
@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+// Standard includes
+#include <array>
+
 // GLM includes
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -22,6 +25,17 @@ namespace dae
         [[nodiscard]] auto get_inverse_view() const -> glm::mat4 { return inverse_view_matrix_; }
         [[nodiscard]] auto get_position() const -> glm::vec3 { return glm::vec3{inverse_view_matrix_[3]}; }
 
+        // Fraction of the viewport height a world space sphere covers; spheres around the eye count as full screen,
+        // spheres entirely behind it as zero
+        [[nodiscard]] auto screen_coverage(glm::vec3 const &center, float radius) const -> float;
+
+        // Left, right, bottom, top, near and far planes of projection * view in world space, normalized and facing
+        // inwards: a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+        [[nodiscard]] auto frustum_planes() const -> std::array<glm::vec4, 6>;
+
+        // World space ray through a point in normalized device coordinates, from the near plane towards the far one
+        void screen_ray(glm::vec2 const &ndc, glm::vec3 &origin, glm::vec3 &direction) const;
+
     private:
         glm::mat4 projection_matrix_   {1.0f};
         glm::mat4 view_matrix_         {1.0f};
@@ -5,20 +5,32 @@
 #include "src/engine/camera.h"
 #include "src/engine/frame_info.h"
 #include "src/engine/game_time.h"
+#include "src/engine/job_system.h"
 #include "src/engine/scene_manager.h"
 #include "src/input/movement_controller.h"
 #include "src/input/shading_mode_controller.h"
+#include "src/system/gpu_culler.h"
 #include "src/system/point_light_system.h"
 #include "src/system/render_2d_system.h"
 #include "src/system/render_3d_system.h"
 #include "src/system/texture_pbr_system.h"
-#include "src/utility/texture.h"
+#include "src/utility/texture_registry.h"
+#include "src/utility/utils.h"
 #include "src/vulkan/buffer.h"
 #include "src/vulkan/device.h"
+#include "src/vulkan/geometry_arena.h"
 #include "src/vulkan/renderer.h"
+#include "src/vulkan/secondary_command_buffers.h"
+#include "src/vulkan/uniform_ring.h"
+#include "src/vulkan/upload_queue.h"
 
 // Standard includes
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <iomanip>
+#include <iostream>
 #include <thread>
 
 // GLM includes
@@ -33,6 +45,11 @@
 namespace dae
 {
     std::string engine::data_path;
+    bool engine::instancing = true;
+    bool engine::render_stats = false;
+    bool engine::parallel_recording = false;
+    uint32_t engine::benchmark_recording_frames = 0;
+    bool engine::gpu_culling = false;
     
     engine::engine(std::string const &path)
     {
@@ -41,91 +58,96 @@ namespace dae
         window_ptr_= &window::instance();
         window_ptr_->init(width, height, "Graphics Programming 2 | Adam Knapecz");
 
-        device_ptr_   = &device::instance();
-        renderer_ptr_ = &renderer::instance();
+        device_ptr_       = &device::instance();
+        renderer_ptr_     = &renderer::instance();
+        job_system_ptr_   = &job_system::instance();
+        upload_queue_ptr_ = &upload_queue::instance();
+
+        // before anything that owns models, so it outlives them; models free their ranges on destruction
+        geometry_arena_ptr_ = &geometry_arena::instance();
         
         global_pool_ = descriptor_pool::builder()
                        .set_max_sets(swap_chain::MAX_FRAMES_IN_FLIGHT)
-                       .add_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, swap_chain::MAX_FRAMES_IN_FLIGHT)
-                       .add_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, swap_chain::MAX_FRAMES_IN_FLIGHT)
+                       .add_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, swap_chain::MAX_FRAMES_IN_FLIGHT)
+                       .add_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, swap_chain::MAX_FRAMES_IN_FLIGHT)
                        .build();
     }
 
     void engine::run(std::function<void()> const &load)
     {
-        std::vector<std::unique_ptr<buffer>> ubo_buffers(swap_chain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < ubo_buffers.size(); ++i)
-        {
-            ubo_buffers[i] = std::make_unique<buffer>(
-                sizeof(global_ubo),
-                1,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-            );
-            ubo_buffers[i]->map();
-        }
+        // per-frame uniform blocks: the global ubo plus whatever systems push while recording
+        uniform_ring uniforms{64 * 1024};
 
         auto global_set_layout = descriptor_set_layout::builder()
-                                 .add_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-                                 .add_binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                                 .add_binding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                                 .add_binding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                                 .add_binding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                                 .add_binding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                                 .add_binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+                                 .add_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT)
                                  .build();
 
-        // scenes
+        if (gpu_culling and not gpu_culler::is_supported())
+        {
+            gpu_culling = false;
+            std::cout << YELLOW_TEXT("[Startup] ") << "GPU culling needs drawIndirectCount and multiDrawIndirect, culling on the CPU\n";
+        }
+
+        // scenes; every system builds its pipeline here, which is what the pipeline cache speeds up
+        auto const pipelines_start = std::chrono::high_resolution_clock::now();
         auto &scene_manager = scene_manager::instance();
         scene_manager.create_scene("2d", std::make_unique<render_2d_system>(global_set_layout->get_descriptor_set_layout()));
         scene_manager.create_scene("3d", std::make_unique<render_3d_system>(global_set_layout->get_descriptor_set_layout()));
         scene_manager.create_scene("material_pbr", std::make_unique<material_pbr_system>(global_set_layout->get_descriptor_set_layout()));
         scene_manager.create_scene("texture_pbr", std::make_unique<texture_pbr_system>(global_set_layout->get_descriptor_set_layout()));
         scene_manager.create_scene("light", std::make_unique<point_light_system>(global_set_layout->get_descriptor_set_layout()));
-        load();
-
-        // textures
-        texture diffuse_texture{scene_loader::instance().diffuse_texture_path(), VK_FORMAT_R8G8B8A8_SRGB};
-        texture normal_texture{scene_loader::instance().normal_texture_path(), VK_FORMAT_R8G8B8A8_UNORM};
-        texture specular_texture{scene_loader::instance().specular_texture_path(), VK_FORMAT_R8G8B8A8_SRGB};
-        texture gloss_texture{scene_loader::instance().glossiness_texture_path(), VK_FORMAT_R8G8B8A8_SRGB};
-        texture texture{scene_loader::instance().texture_path(), VK_FORMAT_R8G8B8A8_SRGB};
-
-        VkDescriptorImageInfo diffuse_image_info{};
-        diffuse_image_info.sampler     = diffuse_texture.sampler();
-        diffuse_image_info.imageView   = diffuse_texture.image_view();
-        diffuse_image_info.imageLayout = diffuse_texture.image_layout();
-
-        VkDescriptorImageInfo normal_image_info{};
-        normal_image_info.sampler     = normal_texture.sampler();
-        normal_image_info.imageView   = normal_texture.image_view();
-        normal_image_info.imageLayout = normal_texture.image_layout();
-
-        VkDescriptorImageInfo specular_image_info{};
-        specular_image_info.sampler     = specular_texture.sampler();
-        specular_image_info.imageView   = specular_texture.image_view();
-        specular_image_info.imageLayout = specular_texture.image_layout();
-
-        VkDescriptorImageInfo emission_image_info{};
-        emission_image_info.sampler     = gloss_texture.sampler();
-        emission_image_info.imageView   = gloss_texture.image_view();
-        emission_image_info.imageLayout = gloss_texture.image_layout();
-
-        VkDescriptorImageInfo texture_image_info{};
-        texture_image_info.sampler     = texture.sampler();
-        texture_image_info.imageView   = texture.image_view();
-        texture_image_info.imageLayout = texture.image_layout();
+        scene_manager.create_scene("stress", std::make_unique<material_pbr_system>(global_set_layout->get_descriptor_set_layout()));
+#ifndef NDEBUG
+        std::cout << YELLOW_TEXT("[Startup] ") << "pipelines: "
+                  << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - pipelines_start).count() << " ms"
+                  << ONE_TAB << "pipeline cache: " << (device_ptr_->is_pipeline_cache_warm() ? "warm" : "cold") << '\n';
+#endif
+        auto const load_start = std::chrono::high_resolution_clock::now();
+        load(); // textures are registered in the bindless table as scenes load them and decode on the job system meanwhile
+        auto &textures = texture_registry::instance();
+        textures.flush();
+        upload_queue_ptr_->flush();
+#ifndef NDEBUG
+        std::cout << YELLOW_TEXT("[Startup] ") << "load: "
+                  << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - load_start).count() << " ms"
+                  << ONE_TAB << "upload submits: " << upload_queue_ptr_->submit_count()
+                  << ONE_TAB << "transfer queue: " << (device_ptr_->find_physical_queue_families().has_dedicated_transfer() ? "dedicated" : "shared") << '\n';
+#endif
+        device_ptr_->allocator().print_stats();
+        geometry_arena_ptr_->print_stats();
+        textures.print_stats();
+
+        // object records, one storage buffer per frame in flight; grown on demand. GPU culling compacts every object's
+        // record into a second one
+        auto required_objects = [&scene_manager] { return scene_manager.object_count() * (gpu_culling ? 2 : 1); };
+        auto create_object_buffer = [](uint32_t object_count)
+        {
+            auto object_buffer = std::make_unique<buffer>(
+                sizeof(object_data),
+                std::bit_ceil(std::max(object_count, 1024u)),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            );
+            object_buffer->map();
+            return object_buffer;
+        };
+        std::vector<std::unique_ptr<buffer>> object_buffers(swap_chain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &object_buffer : object_buffers)
+        {
+            object_buffer = create_object_buffer(required_objects());
+        }
+        // most records any frame has asked for; systems may claim more than the scene's object count
+        uint32_t object_demand = 0;
 
         std::vector<VkDescriptorSet> global_descriptor_sets(swap_chain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < global_descriptor_sets.size(); ++i)
         {
-            auto buffer_info = ubo_buffers[i]->descriptor_info();
+            auto buffer_info = uniforms.descriptor_info(sizeof(global_ubo));
+            auto object_buffer_info = object_buffers[i]->descriptor_info();
             descriptor_writer(global_set_layout.get(), global_pool_.get())
                 .write_buffer(0, &buffer_info)
-                .write_image(1, &diffuse_image_info)
-                .write_image(2, &normal_image_info)
-                .write_image(3, &specular_image_info)
-                .write_image(4, &emission_image_info)
-                .write_image(5, &texture_image_info)
+                .write_buffer(1, &object_buffer_info)
                 .build(global_descriptor_sets[i]);
         }
         
@@ -133,9 +155,9 @@ namespace dae
         // camera.set_view_direction(glm::vec3{0.0f}, glm::vec3{2.5f, 0.0f, 1.0f});
         // camera.set_view_target(glm::vec3{0.0f, -1.5f, -5.0f}, glm::vec3{0.0f, 0.0f, 0.0f});
 
-        auto viewer_object = game_object("viewer");
-        viewer_object.transform.translation = {0.0f, -1.5f, -5.0f};
-        viewer_object.transform.rotation = {-0.2f, 0.0f, 0.0f};
+        transform_component viewer_transform{};
+        viewer_transform.set_translation({0.0f, -1.5f, -5.0f});
+        viewer_transform.set_rotation({-0.2f, 0.0f, 0.0f});
         movement_controller camera_controller = {};
 
         // register input callbacks
@@ -145,16 +167,43 @@ namespace dae
         global_ubo ubo{};
         auto &frame_info = frame_info::instance();
 
+        // recording benchmark: the same scene recorded with every thread count in turn
+        constexpr std::array<uint32_t, 4> benchmark_thread_counts{1, 2, 4, 8};
+        size_t   benchmark_step        = 0;
+        uint32_t benchmark_frame       = 0;
+        float    benchmark_record_time = 0.0f;
+        float    benchmark_baseline    = 0.0f;
+        bool     benchmark_done        = false;
+        if (benchmark_recording_frames > 0)
+        {
+            job_system_ptr_->restart(benchmark_thread_counts[0]);
+            std::cout << '\n' << YELLOW_TEXT("[Recording Benchmark]") << '\n';
+            std::cout << ONE_TAB << "objects: " << scene_manager.object_count() << ", frames per thread count: " << benchmark_recording_frames << '\n';
+        }
+
+        // per-thread command pools for parallel recording
+        std::unique_ptr<secondary_command_buffers> secondary_buffers{};
+        if (parallel_recording)
+        {
+            secondary_buffers = std::make_unique<secondary_command_buffers>(job_system_ptr_->thread_count());
+        }
+
         // time
         using namespace std::chrono;
         using namespace std::chrono_literals;
         auto last_time = high_resolution_clock::now();
         float lag         = 0.0f;
 
+        // render statistics
+        float    stats_time        = 0.0f;
+        float    record_time       = 0.0f;
+        float    cpu_time          = 0.0f;
+        uint32_t stats_frame_count = 0;
+
         //---------------------------------------------------------
         // Game Loop
         //---------------------------------------------------------
-        while (not window_ptr_->should_close())
+        while (not window_ptr_->should_close() and not benchmark_done)
         {
             // input
             glfwPollEvents();
@@ -167,8 +216,8 @@ namespace dae
             lag += game_time::instance().delta_time();
 
             // camera
-            camera_controller.move(window_ptr_->get_glfw_window(), viewer_object);
-            camera.set_view_yxz(viewer_object.transform.translation, viewer_object.transform.rotation);
+            camera_controller.move(window_ptr_->get_glfw_window(), viewer_transform);
+            camera.set_view_yxz(viewer_transform.translation(), viewer_transform.rotation());
             
             float aspect = renderer_ptr_->aspect_ratio();
             camera.set_orthographic_projection(-aspect, aspect, -1, 1, -1, 1);
@@ -183,7 +232,24 @@ namespace dae
                 frame_info.command_buffer = command_buffer;
                 frame_info.camera_ptr = &camera;
                 frame_info.global_descriptor_set = global_descriptor_sets[frame_index];
+                frame_info.uniforms_ptr = &uniforms;
                 frame_info.ubo_ptr = &ubo;
+                uniforms.begin_frame(frame_index);
+                textures.update();
+                geometry_arena_ptr_->update();
+
+                // object buffer; this frame's previous submission has completed, so its set can be rewritten
+                if (auto const object_count = std::max(required_objects(), object_demand); object_buffers[frame_index]->instance_count() < object_count)
+                {
+                    object_buffers[frame_index] = create_object_buffer(object_count);
+                    auto object_buffer_info = object_buffers[frame_index]->descriptor_info();
+                    descriptor_writer(global_set_layout.get(), global_pool_.get())
+                        .write_buffer(1, &object_buffer_info)
+                        .overwrite(global_descriptor_sets[frame_index]);
+                }
+                frame_info.objects = static_cast<object_data*>(object_buffers[frame_index]->mapped_memory());
+                frame_info.object_count = 0;
+                frame_info.object_capacity = object_buffers[frame_index]->instance_count();
 
                 // ubo
                 ubo.projection = camera.get_projection();
@@ -192,14 +258,87 @@ namespace dae
                 
                 // update
                 scene_manager.update();
-                ubo_buffers[frame_index]->write_to_buffer(&ubo);
-                ubo_buffers[frame_index]->flush();
+                frame_info.global_ubo_offset = uniforms.push(ubo);
                 
                 // render
-                renderer_ptr_->begin_swap_chain_render_pass(command_buffer);
-                scene_manager.render();
+                frame_info.draw_calls = 0;
+                frame_info.instance_count = 0;
+                frame_info.objects_tested = 0;
+                frame_info.objects_culled = 0;
+                auto const record_start = high_resolution_clock::now();
+                scene_manager.prepare(command_buffer);
+                if (parallel_recording)
+                {
+                    renderer_ptr_->begin_swap_chain_render_pass(command_buffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    scene_manager.render_parallel(command_buffer, *secondary_buffers);
+                }
+                else
+                {
+                    renderer_ptr_->begin_swap_chain_render_pass(command_buffer);
+                    scene_manager.render(command_buffer);
+                }
                 renderer_ptr_->end_swap_chain_render_pass(command_buffer);
+                float const frame_record_time = duration<float, std::milli>(high_resolution_clock::now() - record_start).count();
+                record_time += frame_record_time;
+                uniforms.flush();
+                upload_queue_ptr_->submit(); // anything uploaded this frame executes before the frame itself
                 renderer_ptr_->end_frame();
+                auto const frame_demand = frame_info.object_count.load(std::memory_order_relaxed);
+#ifndef NDEBUG
+                if (frame_demand > frame_info.object_capacity)
+                {
+                    std::cout << RED_TEXT("[Object Buffer] ") << "Needed " << frame_demand << " records but held "
+                              << frame_info.object_capacity << ", some systems skipped their objects this frame\n";
+                }
+#endif
+                object_demand = std::max(object_demand, frame_demand);
+                cpu_time += duration<float, std::milli>(high_resolution_clock::now() - current_time).count();
+
+                ++stats_frame_count;
+                stats_time += game_time::instance().delta_time();
+                if (stats_time >= 1.0f)
+                {
+                    if (render_stats)
+                    {
+                        std::cout << YELLOW_TEXT("[Render Stats] ")
+                                  << "instances: " << frame_info.instance_count
+                                  << ONE_TAB << "draw calls: " << frame_info.draw_calls
+                                  << ONE_TAB << "culled: " << frame_info.objects_culled << " of " << frame_info.objects_tested
+                                  << ONE_TAB << "record: " << record_time / static_cast<float>(stats_frame_count) << " ms"
+                                  << ONE_TAB << "cpu: " << cpu_time / static_cast<float>(stats_frame_count) << " ms"
+                                  << ONE_TAB << "threads: " << job_system_ptr_->thread_count()
+                                  << (parallel_recording ? " (parallel recording)" : "")
+                                  << ONE_TAB << "instancing: " << (instancing ? "on" : "off") << '\n';
+                    }
+                    stats_time = 0.0f;
+                    record_time = 0.0f;
+                    cpu_time = 0.0f;
+                    stats_frame_count = 0;
+                }
+
+                if (benchmark_recording_frames > 0)
+                {
+                    benchmark_record_time += frame_record_time;
+                    if (++benchmark_frame == benchmark_recording_frames)
+                    {
+                        float const average = benchmark_record_time / static_cast<float>(benchmark_recording_frames);
+                        benchmark_baseline = benchmark_step == 0 ? average : benchmark_baseline;
+                        std::cout << ONE_TAB << "threads " << std::left << std::setw(4) << job_system_ptr_->thread_count()
+                                  << std::fixed << std::setprecision(3) << average << " ms"
+                                  << ONE_TAB << "speedup: " << benchmark_baseline / std::max(average, 0.001f) << "x\n";
+                        benchmark_frame = 0;
+                        benchmark_record_time = 0.0f;
+                        benchmark_done = ++benchmark_step == benchmark_thread_counts.size();
+                        if (not benchmark_done)
+                        {
+                            // the pools of frames still in flight belong to the old threads
+                            vkDeviceWaitIdle(device_ptr_->logical_device());
+                            secondary_buffers.reset();
+                            job_system_ptr_->restart(benchmark_thread_counts[benchmark_step]);
+                            secondary_buffers = std::make_unique<secondary_command_buffers>(job_system_ptr_->thread_count());
+                        }
+                    }
+                }
                 
                 auto const sleep_time = current_time + milliseconds(static_cast<long long>(game_time::instance().ms_per_frame())) - high_resolution_clock::now();
                 std::this_thread::sleep_for(sleep_time);
@@ -14,7 +14,10 @@ namespace dae
     // Forward declarations
     class window;
     class device;
+    class geometry_arena;
+    class job_system;
     class renderer;
+    class upload_queue;
     
     class engine final
     {
@@ -30,9 +33,12 @@ namespace dae
         void run(std::function<void()> const &load);
 
     private:
-        window   *window_ptr_   = nullptr;
-        device   *device_ptr_   = nullptr;
-        renderer *renderer_ptr_ = nullptr;
+        window         *window_ptr_         = nullptr;
+        device         *device_ptr_         = nullptr;
+        renderer       *renderer_ptr_       = nullptr;
+        job_system     *job_system_ptr_     = nullptr;
+        upload_queue   *upload_queue_ptr_   = nullptr;
+        geometry_arena *geometry_arena_ptr_ = nullptr;
         
         std::unique_ptr<descriptor_pool> global_pool_{};
 
@@ -40,5 +46,17 @@ namespace dae
         static constexpr int width  = 800;
         static constexpr int height = 600;
         static std::string data_path;
+
+        // Off records one draw per object instead of one per model, to compare recording times against instancing
+        static bool instancing;
+        // Prints the render statistics once a second; --stress-test and --render-stats turn it on
+        static bool render_stats;
+        // Record each scene into a secondary command buffer on the job system instead of inline on the main thread
+        static bool parallel_recording;
+        // Frames to record at each of 1, 2, 4 and 8 threads before printing the scaling and exiting; 0 runs normally
+        static uint32_t benchmark_recording_frames;
+
+        // Cull instanced systems in a compute pass and draw them through indirect commands; see gpu_culler
+        static bool gpu_culling;
     };
 }
@@ -4,6 +4,10 @@
 #include "src/core/game_object.h"
 #include "src/engine/camera.h"
 
+// Standard includes
+#include <atomic>
+#include <vector>
+
 // Vulkan includes
 #include <vulkan/vulkan.h>
 
@@ -11,6 +15,9 @@
 
 namespace dae
 {
+    // Forward declarations
+    class uniform_ring;
+
     constexpr int MAX_LIGHTS = 10;
     
     struct point_light
@@ -28,6 +35,17 @@ namespace dae
         point_light point_lights[MAX_LIGHTS];
         int num_lights;
     };
+
+    // Per-object record in the frame's object storage buffer (std430), indexed by gl_InstanceIndex
+    struct object_data
+    {
+        glm::mat4   model_matrix    {1.0f};
+        glm::mat3x4 normal_matrix   {1.0f}; // std430 mat3: three vec4-aligned columns
+        glm::vec4   base_color      {1.0f}; // w is metallic
+        glm::vec4   material        {1.0f}; // x is roughness
+        glm::ivec4  texture_indices {0};    // diffuse, normal, specular, glossiness
+        glm::vec4   uv_transform    {0.0f, 0.0f, 1.0f, 1.0f}; // xy offset, zw scale of the packed uvs
+    };
     
     class frame_info final : public singleton<frame_info>
     {
@@ -43,10 +61,20 @@ namespace dae
         VkCommandBuffer           command_buffer;
         camera                    *camera_ptr;
         VkDescriptorSet           global_descriptor_set;
-        std::vector<game_object*> game_objects;
+        uint32_t                  global_ubo_offset;      // Dynamic offset of the frame's global_ubo in the uniform ring
+        uniform_ring              *uniforms_ptr;          // For per-pass and per-draw blocks, bound with dynamic offsets
         global_ubo                *ubo_ptr;
+        object_data               *objects;
+        std::atomic<uint32_t>     object_count;
+        uint32_t                  object_capacity;
         bool use_normal   = true;
         int  shading_mode = 3;
+
+        // Render statistics, reset at the start of every frame; systems may record on several threads
+        std::atomic<uint32_t> draw_calls     = 0;
+        std::atomic<uint32_t> instance_count = 0;
+        std::atomic<uint32_t> objects_tested = 0; // against the view frustum, see scene::render()
+        std::atomic<uint32_t> objects_culled = 0;
         
     private:
         friend class singleton<frame_info>;
@@ -0,0 +1,224 @@
+﻿#include "job_system.h"
+
+// Standard includes
+#include <algorithm>
+#include <cassert>
+
+namespace dae
+{
+    namespace
+    {
+        // Queue owned by the current thread; 0 for the main thread and any other non-worker thread
+        thread_local uint32_t queue_index = 0;
+    }
+
+    uint32_t job_system::requested_thread_count = 0;
+
+    job_system::job_system()
+    {
+        start(requested_thread_count > 0 ? requested_thread_count : std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    job_system::~job_system()
+    {
+        stop();
+    }
+
+    void job_system::restart(uint32_t thread_count)
+    {
+        assert(pending_.load(std::memory_order_acquire) == 0 and "Cannot restart the job system while jobs are queued");
+        stop();
+        start(std::max(thread_count, 1u));
+    }
+
+    void job_system::start(uint32_t thread_count)
+    {
+        queues_.clear();
+        queues_.reserve(thread_count);
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            queues_.push_back(std::make_unique<worker_queue>());
+        }
+        stopping_ = false;
+        threads_.reserve(thread_count - 1);
+        for (uint32_t i = 1; i < thread_count; ++i)
+        {
+            threads_.emplace_back(&job_system::worker_loop, this, i);
+        }
+    }
+
+    void job_system::stop()
+    {
+        {
+            std::lock_guard lock{sleep_mutex_};
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+        threads_.clear();
+    }
+
+    void job_system::run(std::function<void()> fn, job_counter *counter)
+    {
+        if (counter)
+        {
+            counter->value_.fetch_add(1, std::memory_order_relaxed);
+        }
+        push({std::move(fn), counter});
+    }
+
+    void job_system::run_after(job_counter &dependency, std::function<void()> fn, job_counter *counter)
+    {
+        if (counter)
+        {
+            counter->value_.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard lock{dependency.mutex_};
+            if (not dependency.done())
+            {
+                dependency.continuations_.push_back({std::move(fn), counter});
+                return;
+            }
+        }
+        push({std::move(fn), counter});
+    }
+
+    void job_system::wait(job_counter const &counter)
+    {
+        while (not counter.done())
+        {
+            job job{};
+            if (try_pop(job))
+            {
+                execute(job);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        std::lock_guard lock{counter.mutex_};
+    }
+
+    void job_system::parallel_for(size_t count, size_t grain_size, std::function<void(size_t, size_t)> const &fn)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        grain_size = std::max<size_t>(grain_size, 1);
+        size_t const chunk_count = (count + grain_size - 1) / grain_size;
+        if (chunk_count == 1 or threads_.empty())
+        {
+            fn(0, count);
+            return;
+        }
+
+        job_counter counter{};
+        for (size_t chunk = 1; chunk < chunk_count; ++chunk)
+        {
+            size_t const begin = chunk * grain_size;
+            size_t const end   = std::min(begin + grain_size, count);
+            run([&fn, begin, end] { fn(begin, end); }, &counter);
+        }
+        fn(0, grain_size);
+        wait(counter);
+    }
+
+    auto job_system::thread_index() -> uint32_t
+    {
+        return queue_index;
+    }
+
+    void job_system::push(job job)
+    {
+        {
+            auto &queue = *queues_[queue_index];
+            std::lock_guard lock{queue.mutex};
+            queue.jobs.push_back(std::move(job));
+        }
+        {
+            // Taking the lock orders the increment against a worker that is about to sleep, so the wake is not lost
+            std::lock_guard lock{sleep_mutex_};
+            pending_.fetch_add(1, std::memory_order_release);
+        }
+        wake_.notify_one();
+    }
+
+    auto job_system::try_pop(job &out) -> bool
+    {
+        {
+            auto &own = *queues_[queue_index];
+            std::lock_guard lock{own.mutex};
+            if (not own.jobs.empty())
+            {
+                out = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues_.size(); ++i)
+        {
+            auto &victim = *queues_[(queue_index + i) % queues_.size()];
+            std::lock_guard lock{victim.mutex};
+            if (not victim.jobs.empty())
+            {
+                out = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void job_system::execute(job &job)
+    {
+        job.fn();
+        if (not job.counter)
+        {
+            return;
+        }
+
+        // Decrementing under the lock pairs with the lock in wait(): the counter may be destroyed as soon as a
+        // waiter sees zero, so it must not be touched after the unlock
+        std::vector<job_counter::continuation> ready{};
+        {
+            std::lock_guard lock{job.counter->mutex_};
+            if (job.counter->value_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                ready.swap(job.counter->continuations_);
+            }
+        }
+        for (auto &continuation : ready)
+        {
+            push({std::move(continuation.fn), continuation.counter});
+        }
+    }
+
+    void job_system::worker_loop(uint32_t index)
+    {
+        queue_index = index;
+        while (true)
+        {
+            job job{};
+            if (try_pop(job))
+            {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock lock{sleep_mutex_};
+            wake_.wait(lock, [this] { return stopping_ or pending_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ and pending_.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+﻿#pragma once
+
+// Project includes
+#include "src/utility/singleton.h"
+
+// Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+    // Counts outstanding jobs. Incremented when a job is queued against it, decremented when that job finishes;
+    // jobs queued with job_system::run_after() start once it reaches zero.
+    class job_counter final
+    {
+    public:
+        job_counter() = default;
+        ~job_counter() = default;
+
+        job_counter(job_counter const &other)            = delete;
+        job_counter(job_counter &&other)                 = delete;
+        job_counter &operator=(job_counter const &other) = delete;
+        job_counter &operator=(job_counter &&other)      = delete;
+
+        [[nodiscard]] auto value() const -> uint32_t { return value_.load(std::memory_order_acquire); }
+        [[nodiscard]] auto done() const -> bool { return value() == 0; }
+
+    private:
+        friend class job_system;
+
+        struct continuation
+        {
+            std::function<void()> fn;
+            job_counter           *counter;
+        };
+
+        std::atomic<uint32_t>     value_{0};
+        mutable std::mutex        mutex_;
+        std::vector<continuation> continuations_;
+    };
+
+    // Work-stealing thread pool. Every worker owns a deque: it pushes and pops at the back (LIFO, cache warm) while
+    // idle workers steal from the front of the others. Threads that are not workers, like the main thread, share
+    // queue 0 and help out while they wait on a counter.
+    class job_system final : public singleton<job_system>
+    {
+    public:
+        ~job_system() override;
+
+        job_system(job_system const &other)            = delete;
+        job_system(job_system &&other)                 = delete;
+        job_system &operator=(job_system const &other) = delete;
+        job_system &operator=(job_system &&other)      = delete;
+
+        void run(std::function<void()> fn, job_counter *counter = nullptr);
+        void run_after(job_counter &dependency, std::function<void()> fn, job_counter *counter = nullptr);
+
+        // Blocks until the counter reaches zero, executing queued jobs in the meantime
+        void wait(job_counter const &counter);
+
+        // Calls fn(begin, end) over [0, count) in chunks of at most grain_size, spread across all workers, and
+        // returns once every chunk ran. The calling thread takes part, so this is safe to nest inside jobs.
+        void parallel_for(size_t count, size_t grain_size, std::function<void(size_t, size_t)> const &fn);
+
+        // Joins the workers and starts thread_count - 1 new ones; only call while no job is queued or running
+        void restart(uint32_t thread_count);
+
+        // Worker threads plus the calling thread
+        [[nodiscard]] auto thread_count() const -> uint32_t { return static_cast<uint32_t>(threads_.size()) + 1; }
+
+        // In [0, thread_count()): 0 for non-worker threads, for per-thread resources like command pools
+        [[nodiscard]] static auto thread_index() -> uint32_t;
+
+        // Threads to use including the main thread, 0 for one per hardware thread; read once on first instance()
+        static uint32_t requested_thread_count;
+
+    private:
+        friend class singleton<job_system>;
+        job_system();
+
+        struct job
+        {
+            std::function<void()> fn;
+            job_counter           *counter;
+        };
+
+        struct worker_queue
+        {
+            std::mutex      mutex;
+            std::deque<job> jobs;
+        };
+
+        void start(uint32_t thread_count);
+        void stop();
+
+        void push(job job);
+        auto try_pop(job &out) -> bool;
+        void execute(job &job);
+        void worker_loop(uint32_t queue_index);
+
+    private:
+        std::vector<std::unique_ptr<worker_queue>> queues_;
+        std::vector<std::thread>                   threads_;
+
+        std::mutex              sleep_mutex_;
+        std::condition_variable wake_;
+        std::atomic<uint32_t>   pending_{0};
+        std::atomic<bool>       stopping_{false};
+    };
+}
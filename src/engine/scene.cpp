@@ -1,14 +1,11 @@
 ﻿#include "scene.h"
 
 // Project includes
-#include "src/core/game_object.h"
+#include "src/core/frustum_culler.h"
+#include "src/core/model.h"
 #include "src/engine/frame_info.h"
 #include "src/system/i_system.h"
 
-// Standard includes
-#include <algorithm>
-#include <ranges>
-
 namespace dae
 {
     scene::scene() = default;
@@ -23,32 +20,131 @@ namespace dae
 
     void scene::update()
     {
-        auto &frame = frame_info::instance();
-        frame.game_objects = objects();
-        system_->update();
+        system_->update(storage_);
+    }
+
+    void scene::prepare(VkCommandBuffer command_buffer)
+    {
+        system_->prepare(command_buffer, storage_);
+    }
+
+    void scene::render(VkCommandBuffer command_buffer)
+    {
+#ifdef NDEBUG
+        // Nothing reads the CPU result when the system culls on the GPU, but picking still needs the tree's boxes
+        if (system_->culls_on_gpu())
+        {
+            update_bounds();
+            system_->render(command_buffer, storage_);
+            return;
+        }
+#endif
+        // Debug builds cull regardless, the GPU's result is checked against this one
+        cull();
+        system_->render(command_buffer, storage_);
+    }
+
+    void scene::update_bounds()
+    {
+        auto const &entities = storage_.entities();
+        auto const &transforms = storage_.transforms();
+        auto const &models = storage_.models();
+        size_t const count = storage_.size();
+
+        // Creating or destroying objects moves dense indices around, so the tree is rebuilt; otherwise only the boxes
+        // that changed refit it
+        bool rebuild = count != boxes_.size();
+        boxes_.resize(count);
+        box_sources_.resize(count);
+        moved_.clear();
+        unbounded_.clear();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (not models[i])
+            {
+                unbounded_.push_back(i);
+            }
+            bounds_source const source{entities[i], transforms[i].version(), models[i].get()};
+            if (not rebuild and source == box_sources_[i])
+            {
+                continue;
+            }
+            box_sources_[i] = source;
+            moved_.push_back(i);
+            if (models[i])
+            {
+                glm::vec3 center;
+                glm::vec3 extent;
+                frustum_culler::transform_box(transforms[i].mat4(), models[i]->bounds_min(), models[i]->bounds_max(), center, extent);
+                boxes_[i] = {center - extent, center + extent};
+            }
+            else
+            {
+                boxes_[i] = {transforms[i].translation(), transforms[i].translation()};
+            }
+        }
+
+        // Refits loosen the tree as objects wander off; check every so often whether a rebuild pays off again
+        if (not rebuild and not moved_.empty())
+        {
+            bvh_.refit(boxes_, moved_);
+            rebuild = ++refit_count_ % 64 == 0 and bvh_.sah_cost() > built_cost_ * 1.5f;
+        }
+        if (rebuild)
+        {
+            bvh_.build(boxes_);
+            built_cost_ = bvh_.sah_cost();
+            refit_count_ = 0;
+        }
     }
 
-    void scene::render() const
+    void scene::cull()
     {
-        auto &frame = frame_info::instance();
-        frame.game_objects = objects();
-        system_->render();
+        update_bounds();
+
+        auto &frame_info = frame_info::instance();
+        auto &visibility = storage_.visibility();
+        uint32_t boxes_tested = 0;
+        auto visible = bvh_.cull(frame_info.camera_ptr->frustum_planes(), visibility.data(), boxes_tested);
+        for (auto const index : unbounded_)
+        {
+            visible += visibility[index] ? 0 : 1;
+            visibility[index] = 1;
+        }
+        frame_info.objects_tested += boxes_tested;
+        frame_info.objects_culled += static_cast<uint32_t>(storage_.size() - visible);
     }
 
-    auto scene::create_game_object(std::string const &name) -> game_object *
+    auto scene::pick(glm::vec3 const &origin, glm::vec3 const &direction) const -> std::optional<game_object::id_t>
     {
-        objects_.emplace_back(std::make_unique<game_object>(name));
-        return objects_.back().get();
+        auto const hit = bvh_.raycast(origin, direction);
+        if (hit.item == bvh::invalid_item or hit.item >= storage_.size() or not storage_.models()[hit.item])
+        {
+            return std::nullopt;
+        }
+        return storage_.entities()[hit.item];
     }
-    
-    auto scene::objects() const -> std::vector<game_object*>
+
+    void scene::objects_in_radius(glm::vec3 const &center, float radius, std::vector<game_object::id_t> &objects) const
     {
-        std::vector<game_object*> objects;
-        objects.reserve(objects_.size());
-        for (auto const &object : objects_)
+        std::vector<uint32_t> items;
+        bvh_.overlap_sphere(center, radius, items);
+        for (auto const item : items)
         {
-            objects.push_back(object.get());
+            if (item < storage_.size() and storage_.models()[item])
+            {
+                objects.push_back(storage_.entities()[item]);
+            }
         }
-        return objects;
+    }
+
+    auto scene::create_game_object(std::string const &name) -> game_object
+    {
+        return game_object{&storage_, storage_.create(name)};
+    }
+
+    void scene::destroy_game_object(game_object const &object)
+    {
+        storage_.destroy(object.id());
     }
 }
@@ -1,17 +1,22 @@
 ﻿#pragma once
 
 // Project includes
+#include "src/core/bvh.h"
+#include "src/core/component_storage.h"
 #include "src/core/game_object.h"
 
 // Standard includes
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
 namespace dae
 {
     // Forward declarations
-    class game_object;
     class scene_manager;
     class i_system;
 
@@ -30,19 +35,50 @@ namespace dae
         scene &operator=(scene &&other)      = delete;
 
         void update();
-        void render() const;
+        void prepare(VkCommandBuffer command_buffer);
+        void render(VkCommandBuffer command_buffer);
 
         [[nodiscard]] auto name() const -> std::string const & { return name_; }
 
-        auto create_game_object(std::string const &name = "new_game_object") -> game_object *;
-        [[nodiscard]] auto objects() const -> std::vector<game_object*>;
+        auto create_game_object(std::string const &name = "new_game_object") -> game_object;
+        void destroy_game_object(game_object const &object);
+        [[nodiscard]] auto storage() -> component_storage & { return storage_; }
+        [[nodiscard]] auto object_count() const -> size_t { return storage_.size(); }
+
+        // Queries on the world space boxes of objects with a model, as of the last rendered frame. Direction does not
+        // need to be normalized; see camera::screen_ray() for picking with the cursor.
+        [[nodiscard]] auto pick(glm::vec3 const &origin, glm::vec3 const &direction) const -> std::optional<game_object::id_t>;
+        void objects_in_radius(glm::vec3 const &center, float radius, std::vector<game_object::id_t> &objects) const;
 
     private:
         scene();
         explicit scene(std::string name, std::unique_ptr<i_system> system);
 
+        // What a world box was computed from; any change means the box is stale
+        struct bounds_source
+        {
+            game_object::id_t entity  = 0;
+            uint32_t          version = 0;
+            model const      *model_ptr = nullptr;
+
+            bool operator==(bounds_source const &other) const = default;
+        };
+
+        // Keeps bvh_ in step with the objects, then writes storage_.visibility() for the frame's camera
+        void update_bounds();
+        void cull();
+
         std::string name_;
-        std::vector<std::unique_ptr<game_object>> objects_{};
+        component_storage storage_{};
         std::unique_ptr<i_system> system_{};
+
+        // By dense index. Objects without a model get an empty box at their position and are never culled.
+        bvh                        bvh_;
+        std::vector<bvh::box>      boxes_;
+        std::vector<bounds_source> box_sources_;
+        std::vector<uint32_t>      moved_;
+        std::vector<uint32_t>      unbounded_;
+        float                      built_cost_ = 0.0f;
+        uint32_t                   refit_count_ = 0;
     };
 }
@@ -2,9 +2,11 @@
 
 // Project includes
 #include "src/core/factory.h"
+#include "src/core/model_registry.h"
 #include "src/engine/scene.h"
 #include "src/engine/scene_config_manager.h"
 #include "src/engine/scene_manager.h"
+#include "src/utility/texture_registry.h"
 
 namespace dae
 {
@@ -20,27 +22,27 @@ namespace dae
     void scene_loader::load_2d_scene()
     {
         auto scene_ptr = scene_manager::instance().find("2d");
-        auto go_ptr = scene_ptr->create_game_object("oval");
-        go_ptr->model = factory::create_oval({}, 0.5f, 0.5f, 50);
-        go_ptr->transform.translation = {2.0f, -1.0f, 0.0f};
+        auto go = scene_ptr->create_game_object("oval");
+        go.set_model(factory::create_oval({}, 0.5f, 0.5f, 50));
+        go.transform().set_translation({2.0f, -1.0f, 0.0f});
         
         scene_ptr = scene_manager::instance().find("2d");
         auto const &scene_config = scene_config_manager::instance().scene_config();
         
-        go_ptr = scene_ptr->create_game_object("oval");
-        go_ptr->model = factory::create_oval({}, 0.5f, 0.5f, 30);
-        go_ptr->transform.translation = {2.0f, -1.0f, 2.0f};
-        go_ptr->transform.rotation = {0.0f, 0.0f, glm::pi<float>() / 2.0f};
+        go = scene_ptr->create_game_object("oval");
+        go.set_model(factory::create_oval({}, 0.5f, 0.5f, 30));
+        go.transform().set_translation({2.0f, -1.0f, 2.0f});
+        go.transform().set_rotation({0.0f, 0.0f, glm::pi<float>() / 2.0f});
 
-        go_ptr = scene_ptr->create_game_object("ngon");
-        go_ptr->model = factory::create_n_gon({}, 0.5f, 3);
-        go_ptr->transform.translation = {-2.0f, -1.0f, 0.0f};
+        go = scene_ptr->create_game_object("ngon");
+        go.set_model(factory::create_n_gon({}, 0.5f, 3));
+        go.transform().set_translation({-2.0f, -1.0f, 0.0f});
         
         
         for (auto const &object : scene_config["2d"])
         {
             std::string name = object.contains("name") ? object["name"] : "game_object";
-            auto go_ptr = scene_ptr->create_game_object(name);
+            auto go = scene_ptr->create_game_object(name);
             if (object.contains("transform"))
             {
                 auto transform = object["transform"];
@@ -58,18 +60,19 @@ namespace dae
                         scale = glm::vec3{transform["scale"][0], transform["scale"][1], transform["scale"][2]};
                     }
                 }
-                go_ptr->transform.translation = position;
-                go_ptr->transform.rotation = rotation;
-                go_ptr->transform.scale = scale;
+                go.transform().set_translation(position);
+                go.transform().set_rotation(rotation);
+                go.transform().set_scale(scale);
             }
             if (object.contains("model"))
             {
-                go_ptr->model = model::create_model(object["model"]);
+                go.set_model(model_registry::instance().load(object["model"]));
             }
             if (object.contains("texture"))
             {
-                texture_path_ = object["texture"];
-                go_ptr->use_texture = true;
+                auto const index = texture_registry::instance().load(object["texture"], VK_FORMAT_R8G8B8A8_SRGB);
+                go.set_texture_indices(glm::ivec4{static_cast<int>(index)});
+                go.set_use_texture(true);
             }
         }
     }
@@ -82,7 +85,7 @@ namespace dae
         for (auto const &object : scene_config["3d"])
         {
             std::string name = object.contains("name") ? object["name"] : "game_object";
-            auto go_ptr = scene_ptr->create_game_object(name);
+            auto go = scene_ptr->create_game_object(name);
             if (object.contains("transform"))
             {
                 auto transform = object["transform"];
@@ -100,13 +103,13 @@ namespace dae
                         scale = glm::vec3{transform["scale"][0], transform["scale"][1], transform["scale"][2]};
                     }
                 }
-                go_ptr->transform.translation = position;
-                go_ptr->transform.rotation = rotation;
-                go_ptr->transform.scale = scale;
+                go.transform().set_translation(position);
+                go.transform().set_rotation(rotation);
+                go.transform().set_scale(scale);
             }
             if (object.contains("model"))
             {
-                go_ptr->model = model::create_model(object["model"]);
+                go.set_model(model_registry::instance().load(object["model"]));
             }
         }
     }
@@ -126,17 +129,16 @@ namespace dae
 
         for (int i = 0; i < light_colors.size(); ++i)
         {
-            auto go_ptr = scene_ptr->create_game_object("point_light");
-            go_ptr->color = light_colors[i];
-            go_ptr->point_light = std::make_unique<point_light_component>();
-            go_ptr->point_light->light_intensity = 0.2f;
+            auto go = scene_ptr->create_game_object("point_light");
+            go.set_color(light_colors[i]);
+            go.add_point_light(0.2f);
             auto rotate_light = glm::rotate(
                 glm::mat4{1.0f},
                 (i * glm::two_pi<float>()) / light_colors.size(),
                 {0.0f, -1.0f, 0.0f}
             );
-            go_ptr->transform.translation = glm::vec3{rotate_light * glm::vec4{-1.0f, -1.0f, 0.0f, 1.0f}};
-            go_ptr->transform.scale = glm::vec3{0.1f};
+            go.transform().set_translation(glm::vec3{rotate_light * glm::vec4{-1.0f, -1.0f, 0.0f, 1.0f}});
+            go.transform().set_scale(glm::vec3{0.1f});
         }
     }
 
@@ -148,7 +150,7 @@ namespace dae
         for (auto const &object : scene_config["material_pbr"])
         {
             std::string name = object.contains("name") ? object["name"] : "game_object";
-            auto go_ptr = scene_ptr->create_game_object(name);
+            auto go = scene_ptr->create_game_object(name);
             if (object.contains("transform"))
             {
                 auto transform = object["transform"];
@@ -166,13 +168,13 @@ namespace dae
                         scale = glm::vec3{transform["scale"][0], transform["scale"][1], transform["scale"][2]};
                     }
                 }
-                go_ptr->transform.translation = position;
-                go_ptr->transform.rotation = rotation;
-                go_ptr->transform.scale = scale;
+                go.transform().set_translation(position);
+                go.transform().set_rotation(rotation);
+                go.transform().set_scale(scale);
             }
             if (object.contains("model"))
             {
-                go_ptr->model = model::create_model(object["model"]);
+                go.set_model(model_registry::instance().load(object["model"]));
             }
 
             float r, g, b;
@@ -192,7 +194,7 @@ namespace dae
             }
             float metallic = object.contains("metallic") ? static_cast<float>(object["metallic"]) : 0.0f;
             float roughness = object.contains("roughness") ? static_cast<float>(object["roughness"]) : 0.0f;
-            go_ptr->set_material(r, g, b, metallic, roughness);
+            go.set_material(r, g, b, metallic, roughness);
         }
     }
 
@@ -204,7 +206,7 @@ namespace dae
         for (auto const &object : scene_config["texture_pbr"])
         {
             std::string name = object.contains("name") ? object["name"] : "game_object";
-            auto go_ptr = scene_ptr->create_game_object(name);
+            auto go = scene_ptr->create_game_object(name);
             if (object.contains("transform"))
             {
                 auto transform = object["transform"];
@@ -222,34 +224,67 @@ namespace dae
                         scale = glm::vec3{transform["scale"][0], transform["scale"][1], transform["scale"][2]};
                     }
                 }
-                go_ptr->transform.translation = position;
-                go_ptr->transform.rotation = rotation;
-                go_ptr->transform.scale = scale;
+                go.transform().set_translation(position);
+                go.transform().set_rotation(rotation);
+                go.transform().set_scale(scale);
             }
             if (object.contains("model"))
             {
-                go_ptr->model = model::create_model(object["model"]);
+                go.set_model(model_registry::instance().load(object["model"]));
             }
             if (object.contains("textures"))
             {
                 auto textures = object["textures"];
+                auto &registry = texture_registry::instance();
+                glm::ivec4 texture_indices{static_cast<int>(texture_registry::debug_texture)};
                 if (textures.contains("diffuse"))
                 {
-                    diffuse_texture_path_ = textures["diffuse"];
+                    texture_indices.x = static_cast<int>(registry.load(textures["diffuse"], VK_FORMAT_R8G8B8A8_SRGB));
                 }
                 if (textures.contains("normal"))
                 {
-                    normal_texture_path_ = textures["normal"];
+                    texture_indices.y = static_cast<int>(registry.load(textures["normal"], VK_FORMAT_R8G8B8A8_UNORM));
                 }
                 if (textures.contains("specular"))
                 {
-                    specular_texture_path_ = textures["specular"];
+                    texture_indices.z = static_cast<int>(registry.load(textures["specular"], VK_FORMAT_R8G8B8A8_SRGB));
                 }
                 if (textures.contains("glossiness"))
                 {
-                    glossiness_texture_path_ = textures["glossiness"];
+                    texture_indices.w = static_cast<int>(registry.load(textures["glossiness"], VK_FORMAT_R8G8B8A8_SRGB));
                 }
+                go.set_texture_indices(texture_indices);
             }
         }
     }
+
+    void scene_loader::load_stress_scene(int object_count)
+    {
+        auto scene_ptr = scene_manager::instance().find("stress");
+
+        std::vector<std::string> const model_paths{
+            "assets/models/cube.obj",
+            "assets/models/sphere.obj",
+            "assets/models/suzanne.obj"
+        };
+
+        // Square grid on the ground plane in front of the default camera
+        int const   side    = static_cast<int>(glm::ceil(glm::sqrt(static_cast<float>(object_count))));
+        float const spacing = 6.0f / static_cast<float>(side);
+        for (int i = 0; i < object_count; ++i)
+        {
+            int const x = i % side;
+            int const z = i / side;
+            auto go = scene_ptr->create_game_object("stress_object");
+            go.set_model(model_registry::instance().load(model_paths[i % model_paths.size()]));
+            go.transform().set_translation({-3.0f + spacing * static_cast<float>(x), 0.5f, spacing * static_cast<float>(z)});
+            go.transform().set_scale(glm::vec3{spacing * 0.3f});
+            go.set_material(
+                static_cast<float>(x) / static_cast<float>(side),
+                0.5f,
+                static_cast<float>(z) / static_cast<float>(side),
+                static_cast<float>(i % 2),
+                0.3f);
+        }
+    }
 }
@@ -1,7 +1,10 @@
 ﻿#include "scene_manager.h"
 
 // Project includes
+#include "src/engine/frame_info.h"
+#include "src/engine/job_system.h"
 #include "src/engine/scene.h"
+#include "src/vulkan/secondary_command_buffers.h"
 
 // Standard includes
 #include <ranges>
@@ -20,14 +23,41 @@ namespace dae
         }
     }
 
-    void scene_manager::render()
+    void scene_manager::prepare(VkCommandBuffer command_buffer)
     {
         for (auto const &scene : scenes_)
         {
-            scene->render();
+            scene->prepare(command_buffer);
         }
     }
 
+    void scene_manager::render(VkCommandBuffer command_buffer)
+    {
+        for (auto const &scene : scenes_)
+        {
+            scene->render(command_buffer);
+        }
+    }
+
+    void scene_manager::render_parallel(VkCommandBuffer command_buffer, secondary_command_buffers &secondary_buffers)
+    {
+        int const frame_index = frame_info::instance().frame_index;
+        secondary_buffers.reset(frame_index);
+
+        std::vector<VkCommandBuffer> command_buffers(scenes_.size(), VK_NULL_HANDLE);
+        job_system::instance().parallel_for(scenes_.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto secondary = secondary_buffers.begin(frame_index, job_system::thread_index());
+                scenes_[i]->render(secondary);
+                secondary_buffers.end(secondary);
+                command_buffers[i] = secondary;
+            }
+        });
+        vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(command_buffers.size()), command_buffers.data());
+    }
+
     auto scene_manager::find(std::string const &name) -> scene *
     {
         auto const it = std::ranges::find_if(scenes_, [&name](auto const &scene)
@@ -37,6 +67,16 @@ namespace dae
         return it != scenes_.end() ? it->get() : nullptr;
     }
 
+    auto scene_manager::object_count() const -> uint32_t
+    {
+        size_t count = 0;
+        for (auto const &scene : scenes_)
+        {
+            count += scene->object_count();
+        }
+        return static_cast<uint32_t>(count);
+    }
+
     auto scene_manager::create_scene(std::string const &name, std::unique_ptr<i_system> system) -> scene *
     {
         scenes_.emplace_back(std::unique_ptr<scene>(new scene(name, std::move(system))));
@@ -12,8 +12,8 @@
 namespace dae
 {
     // Forward declarations
-    class game_object;
     class scene;
+    class secondary_command_buffers;
     
     class descriptor_set_layout;
     
@@ -28,9 +28,17 @@ namespace dae
         scene_manager &operator=(scene_manager &&other)      = delete;
 
         void update();
-        void render();
+
+        // Outside the render pass, before render() or render_parallel()
+        void prepare(VkCommandBuffer command_buffer);
+        void render(VkCommandBuffer command_buffer);
+        
+        // Records every scene into its own secondary command buffer on the job system and executes them, in scene
+        // order, from the primary; the render pass must have been begun with secondary command buffer contents
+        void render_parallel(VkCommandBuffer command_buffer, secondary_command_buffers &secondary_buffers);
 
         [[nodiscard]] auto find(std::string const &name) -> scene *;
+        [[nodiscard]] auto object_count() const -> uint32_t;
 
         auto create_scene(std::string const &name, std::unique_ptr<i_system> system) -> scene *;
 
@@ -5,7 +5,7 @@
 
 namespace dae
 {
-    void movement_controller::move(GLFWwindow* window_ptr, game_object& game_object)
+    void movement_controller::move(GLFWwindow* window_ptr, transform_component& transform)
     {
         float dt = game_time::instance().delta_time();
         double mouse_x, mouse_y;
@@ -40,16 +40,21 @@ namespace dae
             rotate.x -= 1.0f;
         }
 
+        glm::vec3 rotation = transform.rotation();
         if (glm::dot(rotate, rotate) > glm::epsilon<float>())
         {
-            game_object.transform.rotation += look_speed * dt * glm::normalize(rotate);
+            rotation += look_speed * dt * glm::normalize(rotate);
         }
 
-        game_object.transform.rotation.x = glm::clamp(game_object.transform.rotation.x, -1.5f, 1.5f);
-        game_object.transform.rotation.y = glm::mod(game_object.transform.rotation.y, glm::two_pi<float>());
+        rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+        rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+        if (rotation != transform.rotation())
+        {
+            transform.set_rotation(rotation);
+        }
 
-        float yaw = game_object.transform.rotation.y;
-        float pitch = game_object.transform.rotation.x;
+        float yaw = rotation.y;
+        float pitch = rotation.x;
 
         glm::vec3 forward_dir = {
             glm::cos(pitch) * glm::sin(yaw),
@@ -88,7 +93,7 @@ namespace dae
 
         if (glm::dot(move_dir, move_dir) > glm::epsilon<float>())
         {
-            game_object.transform.translation += move_speed * dt * glm::normalize(move_dir);
+            transform.set_translation(transform.translation() + move_speed * dt * glm::normalize(move_dir));
         }
         
     }
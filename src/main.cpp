@@ -1,13 +1,17 @@
-
+﻿
 // Project includes
+#include "benchmark/benchmarks.h"
+#include "engine/job_system.h"
 #include "engine/scene_config_manager.h"
 #include "engine/scene_loader.h"
 #include "src/engine/engine.h"
 #include "src/utility/utils.h"
 
 // Standard includes
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <string_view>
 
 void print_debug()
 {
@@ -17,19 +21,66 @@ void print_debug()
     std::cout << ONE_TAB << YELLOW_TEXT("[2]") << ONE_TAB << GREEN_TEXT("Toggle NormalMap") << TWO_TABS << on_off << '\n';
 }
 
-void load()
+void load(int stress_object_count)
 {
     dae::scene_config_manager::instance().load_scene_config("configs/scene_config.json");
     dae::scene_loader::instance().load_scenes();
+    if (stress_object_count > 0)
+    {
+        dae::scene_loader::instance().load_stress_scene(stress_object_count);
+    }
     print_debug();
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     try
     {
+        if (dae::benchmarks::run(argc, argv))
+        {
+            return EXIT_SUCCESS;
+        }
+
+        int stress_object_count = 0;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view const arg{argv[i]};
+            bool const has_value = i + 1 < argc and argv[i + 1][0] != '-';
+            if (arg == "--stress-test")
+            {
+                stress_object_count = has_value ? std::atoi(argv[++i]) : 10000;
+                dae::engine::render_stats = true;
+            }
+            else if (arg == "--render-stats")
+            {
+                dae::engine::render_stats = true;
+            }
+            else if (arg == "--no-instancing")
+            {
+                dae::engine::instancing = false;
+            }
+            else if (arg == "--threads" and has_value)
+            {
+                dae::job_system::requested_thread_count = static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1));
+            }
+            else if (arg == "--parallel-recording")
+            {
+                dae::engine::parallel_recording = true;
+            }
+            else if (arg == "--benchmark-recording")
+            {
+                dae::engine::benchmark_recording_frames = has_value ? static_cast<uint32_t>(std::max(std::atoi(argv[++i]), 1)) : 300;
+                dae::engine::parallel_recording = true;
+                stress_object_count = stress_object_count > 0 ? stress_object_count : 10000;
+            }
+            else if (arg == "--gpu-culling")
+            {
+                dae::engine::gpu_culling = true;
+            }
+        }
+        
         dae::engine engine{"data/"};
-        engine.run(load);
+        engine.run([stress_object_count] { load(stress_object_count); });
     }
     catch (const std::exception &e)
     {
@@ -0,0 +1,280 @@
+﻿#include "gpu_culler.h"
+
+// Project includes
+#include "src/core/model.h"
+#include "src/engine/frame_info.h"
+#include "src/system/instance_batcher.h"
+#include "src/utility/utils.h"
+#include "src/vulkan/device.h"
+#include "src/vulkan/swap_chain.h"
+
+// Standard includes
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace dae
+{
+    gpu_culler::gpu_culler(VkDescriptorSetLayout global_set_layout)
+        : device_ptr_{&device::instance()}
+    {
+        assert(is_supported() and "GPU culling needs drawIndirectCount and multiDrawIndirect");
+
+        set_layout_ = descriptor_set_layout::builder()
+                      .add_binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .add_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .add_binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .add_binding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                      .build();
+        pool_ = descriptor_pool::builder()
+                .set_max_sets(swap_chain::MAX_FRAMES_IN_FLIGHT)
+                .add_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * swap_chain::MAX_FRAMES_IN_FLIGHT)
+                .build();
+
+        create_pipeline_layout(global_set_layout);
+        pipeline_ = std::make_unique<pipeline>("shaders/gpu_cull.comp.spv", pipeline_layout_);
+
+        frames_.resize(swap_chain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame : frames_)
+        {
+            reserve(frame, 1, 1);
+        }
+    }
+
+    gpu_culler::~gpu_culler()
+    {
+        vkDestroyPipelineLayout(device_ptr_->logical_device(), pipeline_layout_, nullptr);
+    }
+
+    void gpu_culler::dispatch(VkCommandBuffer command_buffer, std::vector<instance_batch> const &batches, uint32_t first_object)
+    {
+        auto &frame_info = frame_info::instance();
+        auto &frame = frames_[frame_info.frame_index];
+        read_back(frame);
+
+        uint32_t object_count = 0;
+        uint32_t draw_count = 0;
+        for (auto const &batch : batches)
+        {
+            assert(batch.model_ptr->has_indices() and "GPU culling only draws indexed models");
+            object_count += batch.instance_count;
+            draw_count += static_cast<uint32_t>(batch.model_ptr->submeshes().size());
+        }
+        reserve(frame, draw_count, object_count);
+        frame.batch_count = static_cast<uint32_t>(batches.size());
+        frame.draw_count = draw_count;
+        frame.pending = draw_count > 0;
+        if (draw_count == 0)
+        {
+            return;
+        }
+
+        auto *draws = static_cast<cull_draw*>(frame.draws->mapped_memory());
+        auto *batch_of = static_cast<uint32_t*>(frame.batch_of->mapped_memory());
+        uint32_t draw_index = 0;
+        for (auto const &batch : batches)
+        {
+            uint32_t const leader = draw_index;
+            for (auto const &submesh : batch.model_ptr->submeshes())
+            {
+                // Object records already fold model::dequantization() into their matrix, so the box is in packed space
+                cull_draw draw{};
+                draw.bounds_min    = glm::vec4{0.0f};
+                draw.bounds_max    = glm::vec4{1.0f, 1.0f, 1.0f, 0.0f};
+                draw.index_count   = submesh.index_count;
+                draw.first_index   = submesh.first_index;
+                draw.vertex_offset = submesh.vertex_offset;
+                draw.first_object  = first_object + batch.first_instance;
+                draw.first_visible = first_object + object_count + batch.first_instance;
+                draw.leader        = leader;
+                draws[draw_index++] = draw;
+            }
+            std::fill_n(batch_of + batch.first_instance, batch.instance_count, leader);
+        }
+
+        // The count starts at zero every frame; the host writes above are visible to the device once submitted
+        vkCmdFillBuffer(command_buffer, frame.count->get_buffer(), 0, sizeof(uint32_t), 0);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        pipeline_->bind(command_buffer);
+        std::array<VkDescriptorSet, 2> const sets{frame_info.global_descriptor_set, frame.set};
+        vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipeline_layout_,
+            0,
+            static_cast<uint32_t>(sets.size()),
+            sets.data(),
+            1,
+            &frame_info.global_ubo_offset
+        );
+
+        cull_push_constant push{};
+        push.planes = frame_info.camera_ptr->frustum_planes();
+        push.first_object = first_object;
+        push.count = object_count;
+        push.pass = 0;
+        vkCmdPushConstants(command_buffer, pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(cull_push_constant), &push);
+        vkCmdDispatch(command_buffer, (object_count + group_size - 1) / group_size, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        push.count = draw_count;
+        push.pass = 1;
+        vkCmdPushConstants(command_buffer, pipeline_layout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(cull_push_constant), &push);
+        vkCmdDispatch(command_buffer, (draw_count + group_size - 1) / group_size, 1, 1);
+
+        // Commands and counts feed the indirect draws, compacted records the vertex shaders, visible counts the host
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    void gpu_culler::draw(VkCommandBuffer command_buffer, std::vector<instance_batch> const &batches)
+    {
+        auto &frame_info = frame_info::instance();
+        auto const &frame = frames_[frame_info.frame_index];
+        assert(frame.batch_count == batches.size() and "Drawing batches that were not dispatched this frame");
+
+        // The device decides how many of the commands run
+        geometry_arena::instance().bind(command_buffer);
+        vkCmdDrawIndexedIndirectCount(
+            command_buffer,
+            frame.commands->get_buffer(),
+            0,
+            frame.count->get_buffer(),
+            0,
+            frame.draw_count,
+            sizeof(VkDrawIndexedIndirectCommand));
+        ++frame_info.draw_calls;
+    }
+
+    void gpu_culler::expect_visible(uint32_t visible_count)
+    {
+        frames_[frame_info::instance().frame_index].expected_visible = visible_count;
+    }
+
+    auto gpu_culler::is_supported() -> bool
+    {
+        return device::instance().supports_draw_indirect_count();
+    }
+
+    void gpu_culler::create_pipeline_layout(VkDescriptorSetLayout global_set_layout)
+    {
+        VkPushConstantRange push_constant_range{};
+        push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant_range.offset     = 0;
+        push_constant_range.size       = sizeof(cull_push_constant);
+
+        std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout, set_layout_->get_descriptor_set_layout()};
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount         = static_cast<uint32_t>(descriptor_set_layouts.size());
+        pipeline_layout_info.pSetLayouts            = descriptor_set_layouts.data();
+        pipeline_layout_info.pushConstantRangeCount = 1;
+        pipeline_layout_info.pPushConstantRanges    = &push_constant_range;
+
+        if (vkCreatePipelineLayout(device_ptr_->logical_device(), &pipeline_layout_info, nullptr, &pipeline_layout_) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to create pipeline layout!"};
+        }
+    }
+
+    void gpu_culler::reserve(frame_resources &frame, uint32_t draw_count, uint32_t object_count)
+    {
+        // Only once the frame's fence signaled, so the buffers and set are no longer in use
+        bool const grow_draws = not frame.draws or frame.draws->instance_count() < draw_count;
+        bool const grow_objects = not frame.batch_of or frame.batch_of->instance_count() < object_count;
+        if (not grow_draws and not grow_objects)
+        {
+            return;
+        }
+
+        if (grow_draws)
+        {
+            uint32_t const capacity = std::bit_ceil(std::max(draw_count, 64u));
+            frame.draws = std::make_unique<buffer>(
+                sizeof(cull_draw), capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            frame.draws->map();
+            frame.commands = std::make_unique<buffer>(
+                sizeof(VkDrawIndexedIndirectCommand), capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+        if (not frame.count)
+        {
+            frame.count = std::make_unique<buffer>(
+                sizeof(uint32_t), 1,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+        if (grow_objects)
+        {
+            frame.batch_of = std::make_unique<buffer>(
+                sizeof(uint32_t), std::bit_ceil(std::max(object_count, 1024u)),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            frame.batch_of->map();
+        }
+
+        auto draws_info = frame.draws->descriptor_info();
+        auto batch_of_info = frame.batch_of->descriptor_info();
+        auto commands_info = frame.commands->descriptor_info();
+        auto count_info = frame.count->descriptor_info();
+        descriptor_writer writer{set_layout_.get(), pool_.get()};
+        writer.write_buffer(0, &draws_info)
+              .write_buffer(1, &batch_of_info)
+              .write_buffer(2, &commands_info)
+              .write_buffer(3, &count_info);
+        if (frame.set == VK_NULL_HANDLE)
+        {
+            writer.build(frame.set);
+        }
+        else
+        {
+            writer.overwrite(frame.set);
+        }
+    }
+
+    void gpu_culler::read_back(frame_resources &frame)
+    {
+        if (not frame.pending)
+        {
+            return;
+        }
+        frame.pending = false;
+
+        uint32_t visible_count = 0;
+        auto const *draws = static_cast<cull_draw const*>(frame.draws->mapped_memory());
+        for (uint32_t i = 0; i < frame.draw_count; ++i)
+        {
+            visible_count += draws[i].visible_count; // only leaders count
+        }
+        frame_info::instance().instance_count += visible_count;
+
+#ifndef NDEBUG
+        // Boxes right on a plane may land either way with the GPU's rounding, anything more is a bug
+        uint32_t const difference = visible_count > frame.expected_visible ? visible_count - frame.expected_visible : frame.expected_visible - visible_count;
+        if (difference > frame.expected_visible / 1000)
+        {
+            std::cout << RED_TEXT("[GPU Culling] ") << "kept " << visible_count << " objects where the CPU kept " << frame.expected_visible << '\n';
+        }
+#endif
+    }
+}
@@ -0,0 +1,109 @@
+﻿#pragma once
+
+// Project includes
+#include "src/vulkan/buffer.h"
+#include "src/vulkan/descriptors.h"
+#include "src/vulkan/pipeline.h"
+
+// Standard includes
+#include <array>
+#include <memory>
+#include <vector>
+
+// GLM includes
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class device;
+    struct instance_batch;
+
+    // Frustum culling of a system's instance batches in a compute pass. The batches' source records sit in the frame's
+    // object buffer followed by as many free records; a thread per object tests the model's box under its record's
+    // model matrix and copies survivors into the batch's compacted range, then a thread per batch submesh writes one
+    // VkDrawIndexedIndirectCommand for every submesh of a batch with survivors. Every model lives in the geometry arena, so draw()
+    // issues a single vkCmdDrawIndexedIndirectCount and visible counts never reach the CPU while recording. They are
+    // read back once the frame's fence signaled, for the render statistics and, in debug builds, to check the result
+    // against the CPU culler.
+    class gpu_culler final
+    {
+    public:
+        explicit gpu_culler(VkDescriptorSetLayout global_set_layout);
+        ~gpu_culler();
+
+        gpu_culler(gpu_culler const &other)            = delete;
+        gpu_culler(gpu_culler &&other)                 = delete;
+        gpu_culler &operator=(gpu_culler const &other) = delete;
+        gpu_culler &operator=(gpu_culler &&other)      = delete;
+
+        // Records both passes over batches whose source records start at first_object; outside a render pass, once
+        // the records are written and the frame's global ubo offset is known
+        void dispatch(VkCommandBuffer command_buffer, std::vector<instance_batch> const &batches, uint32_t first_object);
+        void draw(VkCommandBuffer command_buffer, std::vector<instance_batch> const &batches);
+
+        // How many of the batches' objects the CPU culler kept this frame, compared with the GPU's once read back
+        void expect_visible(uint32_t visible_count);
+
+        // Needs drawIndirectCount and multiDrawIndirect
+        [[nodiscard]] static auto is_supported() -> bool;
+
+        static constexpr uint32_t group_size = 64;
+
+    private:
+        // std430 layout shared with gpu_cull.comp
+        struct cull_draw
+        {
+            glm::vec4 bounds_min    {};
+            glm::vec4 bounds_max    {};
+            uint32_t  index_count   = 0;
+            uint32_t  first_index   = 0;
+            int32_t   vertex_offset = 0;
+            uint32_t  first_object  = 0;
+            uint32_t  visible_count = 0; // written by the cull pass
+            uint32_t  first_visible = 0;
+            uint32_t  leader        = 0; // draw of the batch's first submesh, which counts the batch's survivors
+            uint32_t  padding       = 0;
+        };
+
+        struct cull_push_constant
+        {
+            std::array<glm::vec4, 6> planes;
+            uint32_t first_object;
+            uint32_t count;
+            uint32_t pass; // 0 culls objects, 1 writes commands
+        };
+
+        struct frame_resources
+        {
+            std::unique_ptr<buffer> draws;    // cull_draw per batch submesh
+            std::unique_ptr<buffer> batch_of; // leader draw index per object
+            std::unique_ptr<buffer> commands; // VkDrawIndexedIndirectCommand per submesh of a batch with survivors
+            std::unique_ptr<buffer> count;    // how many commands were written
+            VkDescriptorSet         set = VK_NULL_HANDLE;
+
+            uint32_t batch_count      = 0;
+            uint32_t draw_count       = 0;
+            uint32_t expected_visible = 0;
+            bool     pending          = false;
+        };
+
+        void create_pipeline_layout(VkDescriptorSetLayout global_set_layout);
+        void reserve(frame_resources &frame, uint32_t draw_count, uint32_t object_count);
+        void read_back(frame_resources &frame);
+
+        device *device_ptr_ = nullptr;
+
+        std::unique_ptr<descriptor_set_layout> set_layout_;
+        std::unique_ptr<descriptor_pool>       pool_;
+        VkPipelineLayout                       pipeline_layout_ = VK_NULL_HANDLE;
+        std::unique_ptr<pipeline>              pipeline_;
+
+        std::vector<frame_resources> frames_;
+    };
+}
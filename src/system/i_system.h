@@ -9,6 +9,7 @@
 namespace dae
 {
     // Forward declarations
+    class component_storage;
     class device;
     
     class i_system
@@ -22,8 +23,17 @@ namespace dae
         i_system &operator=(i_system const &other) = delete;
         i_system &operator=(i_system &&other)      = delete;
 
-        virtual void update() { }
-        virtual void render() { }
+        // Renders the scene's storage into command_buffer; may run on a worker thread with a secondary command buffer,
+        // so implementations only read shared frame state and record into the buffer they are given
+        virtual void update(component_storage &) { }
+        virtual void render(VkCommandBuffer, component_storage const &) { }
+
+        // Records work that cannot happen inside the render pass, such as compute, into the frame's primary command
+        // buffer; called on the main thread for every scene before any of them renders
+        virtual void prepare(VkCommandBuffer, component_storage const &) { }
+
+        // Whether the system culls its objects on the GPU, so the scene's CPU visibility goes unused
+        [[nodiscard]] virtual auto culls_on_gpu() const -> bool { return false; }
 
     protected:
         virtual void create_pipeline_layout(VkDescriptorSetLayout global_set_layout) = 0;
@@ -0,0 +1,136 @@
+﻿#include "instance_batcher.h"
+
+// Project includes
+#include "src/core/component_storage.h"
+#include "src/core/model.h"
+#include "src/engine/engine.h"
+#include "src/engine/frame_info.h"
+
+// Standard includes
+#include <cassert>
+
+namespace dae
+{
+    instance_batcher::instance_batcher() = default;
+
+    instance_batcher::~instance_batcher() = default;
+
+    auto instance_batcher::build(component_storage const &storage) -> std::vector<instance_batch> const &
+    {
+        batches_.clear();
+        batch_lookup_.clear();
+        storage_ptr_ = &storage;
+
+        // Counting sort by model keeps the first-seen order of models and of entities within a model; culled entities
+        // are left out unless the GPU culls them
+        auto const &models = storage.models();
+        auto const &visibility = storage.visibility();
+        auto const include = [&](uint32_t index) { return models[index] and (gpu_culling() or visibility[index]); };
+        for (uint32_t index = 0; index < models.size(); ++index)
+        {
+            if (not include(index))
+            {
+                continue;
+            }
+            auto const [it, inserted] = batch_lookup_.try_emplace(models[index].get(), static_cast<uint32_t>(batches_.size()));
+            if (inserted)
+            {
+                batches_.push_back({models[index].get(), 0, 0});
+            }
+            ++batches_[it->second].instance_count;
+        }
+
+        uint32_t instance_count = 0;
+        cursors_.resize(batches_.size());
+        for (size_t i = 0; i < batches_.size(); ++i)
+        {
+            batches_[i].first_instance = instance_count;
+            cursors_[i] = instance_count;
+            instance_count += batches_[i].instance_count;
+        }
+
+        sorted_indices_.resize(instance_count);
+        for (uint32_t index = 0; index < models.size(); ++index)
+        {
+            if (include(index))
+            {
+                sorted_indices_[cursors_[batch_lookup_[models[index].get()]]++] = index;
+            }
+        }
+        return batches_;
+    }
+
+    auto instance_batcher::allocate_objects() -> object_data *
+    {
+        auto &frame_info = frame_info::instance();
+        auto const object_count = static_cast<uint32_t>(sorted_indices_.size());
+        auto const claimed = gpu_culling() ? 2 * object_count : object_count;
+        
+        // object_count keeps counting past the capacity, so the engine knows how far to grow the buffer
+        first_object_ = frame_info.object_count.fetch_add(claimed, std::memory_order_relaxed);
+        overflowed_ = first_object_ + claimed > frame_info.object_capacity;
+        if (overflowed_)
+        {
+            // Records go to scratch memory and the batches are skipped this frame instead of writing past the buffer;
+            // the engine reports it and grows the buffer
+            overflow_objects_.resize(claimed);
+            return overflow_objects_.data();
+        }
+        return frame_info.objects + first_object_;
+    }
+
+    void instance_batcher::draw(VkCommandBuffer command_buffer) const
+    {
+        if (overflowed_)
+        {
+            return;
+        }
+        
+        auto &frame_info = frame_info::instance();
+        if (gpu_culling())
+        {
+#ifndef NDEBUG
+            // By now the scene culled on the CPU as well, which the GPU's result is checked against
+            uint32_t visible_count = 0;
+            for (auto const index : sorted_indices_)
+            {
+                visible_count += storage_ptr_->visibility()[index];
+            }
+            gpu_culler_->expect_visible(visible_count);
+#endif
+            gpu_culler_->draw(command_buffer, batches_);
+            return;
+        }
+
+        geometry_arena::instance().bind(command_buffer);
+        for (auto const &batch : batches_)
+        {
+            if (not engine::instancing)
+            {
+                // One draw per object, as every object was recorded before instancing
+                for (uint32_t i = 0; i < batch.instance_count; ++i)
+                {
+                    frame_info.draw_calls += batch.model_ptr->draw(command_buffer, 1, first_object_ + batch.first_instance + i);
+                }
+                frame_info.instance_count += batch.instance_count;
+                continue;
+            }
+            frame_info.draw_calls += batch.model_ptr->draw(command_buffer, batch.instance_count, first_object_ + batch.first_instance);
+            frame_info.instance_count += batch.instance_count;
+        }
+    }
+
+    void instance_batcher::enable_gpu_culling(VkDescriptorSetLayout global_set_layout)
+    {
+        gpu_culler_ = std::make_unique<gpu_culler>(global_set_layout);
+    }
+
+    void instance_batcher::dispatch(VkCommandBuffer command_buffer)
+    {
+        assert(gpu_culling() and "Dispatching without GPU culling enabled");
+        if (not overflowed_)
+        {
+            gpu_culler_->dispatch(command_buffer, batches_, first_object_);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+
+// Project includes
+#include "src/engine/frame_info.h"
+#include "src/system/gpu_culler.h"
+
+// Standard includes
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class component_storage;
+    class model;
+
+    struct instance_batch
+    {
+        model    *model_ptr      = nullptr;
+        uint32_t first_instance = 0;
+        uint32_t instance_count = 0;
+    };
+
+    // Groups a scene's entities by model so each group is a single instanced draw. The per-instance records live in
+    // the frame's object storage buffer and are looked up with gl_InstanceIndex. With GPU culling enabled the batches
+    // hold every entity with a model; dispatch() culls them in a compute pass and draw() goes through indirect commands.
+    class instance_batcher final
+    {
+    public:
+        instance_batcher();
+        ~instance_batcher();
+
+        instance_batcher(instance_batcher const &other)            = delete;
+        instance_batcher(instance_batcher &&other)                 = delete;
+        instance_batcher &operator=(instance_batcher const &other) = delete;
+        instance_batcher &operator=(instance_batcher &&other)      = delete;
+
+        // Groups the entities that survived culling by model; indices() holds dense storage indices ordered so that each batch is a contiguous
+        // instance range
+        auto build(component_storage const &storage) -> std::vector<instance_batch> const &;
+        [[nodiscard]] auto indices() const -> std::vector<uint32_t> const & { return sorted_indices_; }
+
+        // Claims indices().size() records in the frame's object buffer, in indices() order, plus as many for the GPU
+        // culler to compact survivors into. When the buffer is full the records go to scratch memory and draw()
+        // records nothing for this frame
+        auto allocate_objects() -> object_data *;
+        void draw(VkCommandBuffer command_buffer) const;
+
+        // From then on build() ignores CPU culling and the batches are culled on the GPU; see gpu_culler
+        void enable_gpu_culling(VkDescriptorSetLayout global_set_layout);
+        [[nodiscard]] auto gpu_culling() const -> bool { return gpu_culler_ != nullptr; }
+
+        // Outside the render pass, once the records are written
+        void dispatch(VkCommandBuffer command_buffer);
+
+    private:
+        uint32_t first_object_ = 0;
+        bool     overflowed_   = false;
+
+        component_storage const     *storage_ptr_ = nullptr;
+        std::unique_ptr<gpu_culler> gpu_culler_;
+        
+        std::vector<object_data>             overflow_objects_;
+        std::vector<instance_batch>          batches_;
+        std::vector<uint32_t>                sorted_indices_;
+        std::vector<uint32_t>                cursors_;
+        std::unordered_map<model*, uint32_t> batch_lookup_;
+    };
+}
@@ -1,7 +1,10 @@
 ﻿#include "material_pbr_system.h"
 
 // Project includes
+#include "src/core/component_storage.h"
+#include "src/engine/engine.h"
 #include "src/engine/frame_info.h"
+#include "src/engine/job_system.h"
 #include "src/vulkan/device.h"
 #include "src/vulkan/renderer.h"
 
@@ -11,78 +14,82 @@
 
 namespace dae
 {
-    struct material_pbr_push_constant
-    {
-        glm::mat4 model_matrix{1.0f};
-        glm::mat4 normal_matrix{1.0f};
-        float r;
-        float g;
-        float b;
-        float metallic;
-        float roughness;
-    };
-    
     material_pbr_system::material_pbr_system(VkDescriptorSetLayout global_set_layout)
     {
         create_pipeline_layout(global_set_layout);
         create_pipeline(renderer::instance().swap_chain_render_pass());
+        if (engine::gpu_culling)
+        {
+            instance_batcher_.enable_gpu_culling(global_set_layout);
+        }
+    }
+
+    void material_pbr_system::prepare(VkCommandBuffer command_buffer, component_storage const &storage)
+    {
+        if (instance_batcher_.gpu_culling())
+        {
+            write_records(storage);
+            instance_batcher_.dispatch(command_buffer);
+        }
     }
 
-    void material_pbr_system::render()
+    void material_pbr_system::render(VkCommandBuffer command_buffer, component_storage const &storage)
     {
         auto &frame_info = frame_info::instance();
-        pipeline_->bind(frame_info.command_buffer);
+        pipeline_->bind(command_buffer);
 
         vkCmdBindDescriptorSets(
-            frame_info.command_buffer,
+            command_buffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipeline_layout_,
             0,
             1,
             &frame_info.global_descriptor_set,
-            0,
-            nullptr
+            1,
+            &frame_info.global_ubo_offset
         );
 
-        for (auto const &obj : frame_info.game_objects)
+        if (not instance_batcher_.gpu_culling())
         {
-            material_pbr_push_constant push{};
-            push.model_matrix = obj->transform.mat4();
-            push.normal_matrix = obj->transform.normal_matrix();
-            push.r = obj->material().base_color.r;
-            push.g = obj->material().base_color.g;
-            push.b = obj->material().base_color.b;
-            push.metallic = obj->material().metallic;
-            push.roughness = obj->material().roughness;
-
-            vkCmdPushConstants(
-                frame_info.command_buffer,
-                pipeline_layout_,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(material_pbr_push_constant),
-                &push);
-            
-            obj->model->bind(frame_info.command_buffer);
-            obj->model->draw(frame_info.command_buffer);
+            write_records(storage);
         }
+        instance_batcher_.draw(command_buffer);
+    }
+
+    void material_pbr_system::write_records(component_storage const &storage)
+    {
+        auto const &transforms = storage.transforms();
+        auto const &models = storage.models();
+        auto const &materials = storage.materials();
+        instance_batcher_.build(storage);
+        auto *records = instance_batcher_.allocate_objects();
+        auto const &indices = instance_batcher_.indices();
+        job_system::instance().parallel_for(indices.size(), 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto const index = indices[i];
+                object_data record{};
+                record.model_matrix = transforms[index].mat4() * models[index]->dequantization();
+                record.normal_matrix = glm::mat3x4{transforms[index].normal_matrix()};
+                record.uv_transform = models[index]->uv_transform();
+                record.base_color = glm::vec4{materials[index].base_color, materials[index].metallic};
+                record.material.x = materials[index].roughness;
+                records[i] = record;
+            }
+        });
     }
 
     void material_pbr_system::create_pipeline_layout(VkDescriptorSetLayout global_set_layout)
     {
-        VkPushConstantRange push_constant_range{};
-        push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        push_constant_range.offset     = 0;
-        push_constant_range.size       = sizeof(material_pbr_push_constant);
-        
         std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout};
         
         VkPipelineLayoutCreateInfo pipeline_layout_info{};
         pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipeline_layout_info.setLayoutCount         = static_cast<uint32_t>(descriptor_set_layouts.size());
         pipeline_layout_info.pSetLayouts            = descriptor_set_layouts.data();
-        pipeline_layout_info.pushConstantRangeCount = 1;
-        pipeline_layout_info.pPushConstantRanges    = &push_constant_range;
+        pipeline_layout_info.pushConstantRangeCount = 0;
+        pipeline_layout_info.pPushConstantRanges    = nullptr;
 
         if (vkCreatePipelineLayout(device_ptr_->logical_device(), &pipeline_layout_info, nullptr, &pipeline_layout_) != VK_SUCCESS)
         {
@@ -2,6 +2,7 @@
 
 // Project includes
 #include "src/system/i_system.h"
+#include "src/system/instance_batcher.h"
 
 namespace dae
 {
@@ -16,11 +17,18 @@ namespace dae
         material_pbr_system &operator=(material_pbr_system const &other) = delete;
         material_pbr_system &operator=(material_pbr_system &&other)      = delete;
 
-        void render() override;
+        void prepare(VkCommandBuffer command_buffer, component_storage const &storage) override;
+        void render(VkCommandBuffer command_buffer, component_storage const &storage) override;
+        [[nodiscard]] auto culls_on_gpu() const -> bool override { return instance_batcher_.gpu_culling(); }
 
     protected:
         void create_pipeline_layout(VkDescriptorSetLayout global_set_layout) override;
         void create_pipeline(VkRenderPass render_pass) override;
-        
+
+    private:
+        // Batches the storage and fills the batches' object records
+        void write_records(component_storage const &storage);
+
+        instance_batcher instance_batcher_;
     };
 }
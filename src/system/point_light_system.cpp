@@ -1,6 +1,7 @@
 ﻿#include "point_light_system.h"
 
 // Project includes
+#include "src/core/component_storage.h"
 #include "src/engine/frame_info.h"
 #include "src/engine/game_time.h"
 #include "src/vulkan/device.h"
@@ -32,7 +33,7 @@ namespace dae
         create_pipeline(renderer::instance().swap_chain_render_pass());
     }
 
-    void point_light_system::update()
+    void point_light_system::update(component_storage &storage)
     {
         auto &frame_info = frame_info::instance();
         auto rotate_light = glm::rotate(
@@ -41,71 +42,81 @@ namespace dae
             {0.0f, -1.0f, 0.0f}
         );
         
+        auto &transforms = storage.transforms();
+        auto const &colors = storage.colors();
+        auto const &lights = storage.point_lights();
+        auto const &light_entities = storage.light_entities();
+        
         int light_index = 0;
-        for (auto &obj : frame_info.game_objects)
+        for (size_t i = 0; i < lights.size(); ++i)
         {
             assert(light_index < MAX_LIGHTS and "Point lights exceed maximum specified");
+            auto const index = storage.index_of(light_entities[i]);
+            auto &transform = transforms[index];
 
             // update light position
-            obj->transform.translation = glm::vec3{rotate_light * glm::vec4{obj->transform.translation, 1.0f}};
+            transform.set_translation(glm::vec3{rotate_light * glm::vec4{transform.translation(), 1.0f}});
 
             // copy light to ubo
-            frame_info.ubo_ptr->point_lights[light_index].position = glm::vec4{obj->transform.translation, 1.0f};
-            frame_info.ubo_ptr->point_lights[light_index].color    = glm::vec4{obj->color, obj->point_light->light_intensity};
+            frame_info.ubo_ptr->point_lights[light_index].position = glm::vec4{transform.translation(), 1.0f};
+            frame_info.ubo_ptr->point_lights[light_index].color    = glm::vec4{colors[index], lights[i].light_intensity};
 
             ++light_index;
         }
         frame_info.ubo_ptr->num_lights = light_index;
     }
 
-void point_light_system::render()
+void point_light_system::render(VkCommandBuffer command_buffer, component_storage const &storage)
     {
         auto &frame_info = frame_info::instance();
-        std::map<float, game_object::id_t> sorted;
-        for (auto &go : frame_info.game_objects)
+        auto const &transforms = storage.transforms();
+        auto const &colors = storage.colors();
+        auto const &lights = storage.point_lights();
+        auto const &light_entities = storage.light_entities();
+
+        // distance -> light slot
+        std::map<float, size_t> sorted;
+        for (size_t i = 0; i < lights.size(); ++i)
         {
-            auto offset = frame_info.camera_ptr->get_position() - go->transform.translation;
+            auto offset = frame_info.camera_ptr->get_position() - transforms[storage.index_of(light_entities[i])].translation();
             float dis_squared = glm::dot(offset, offset);
-            sorted[dis_squared] = go->id();
+            sorted[dis_squared] = i;
         }
         
-        pipeline_->bind(frame_info.command_buffer);
+        pipeline_->bind(command_buffer);
 
         vkCmdBindDescriptorSets(
-            frame_info.command_buffer,
+            command_buffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipeline_layout_,
             0,
             1,
             &frame_info.global_descriptor_set,
-            0,
-            nullptr
+            1,
+            &frame_info.global_ubo_offset
         );
 
-        std::map<game_object::id_t, game_object*> game_objects;
-        for (auto &go : frame_info.game_objects)
-        {
-            game_objects[go->id()] = go;
-        }
-        
         for (auto it = sorted.rbegin(); it != sorted.rend(); ++it)
         {
-            auto &go = game_objects.at(it->second);
+            auto const light = it->second;
+            auto const index = storage.index_of(light_entities[light]);
 
             point_light_push_constants push{};
-            push.position = glm::vec4{go->transform.translation, 1.0f};
-            push.color    = glm::vec4{go->color, go->point_light->light_intensity};
-            push.radius   = go->transform.scale.x;
+            push.position = glm::vec4{transforms[index].translation(), 1.0f};
+            push.color    = glm::vec4{colors[index], lights[light].light_intensity};
+            push.radius   = transforms[index].scale().x;
 
             vkCmdPushConstants(
-                frame_info.command_buffer,
+                command_buffer,
                 pipeline_layout_,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(point_light_push_constants),
                 &push
             );
-            vkCmdDraw(frame_info.command_buffer, 6, 1, 0, 0);
+            vkCmdDraw(command_buffer, 6, 1, 0, 0);
+            ++frame_info.draw_calls;
+            ++frame_info.instance_count;
         }
     }
 
@@ -16,8 +16,8 @@ namespace dae
         point_light_system &operator=(point_light_system const &other) = delete;
         point_light_system &operator=(point_light_system &&other)      = delete;
 
-        void update() override;
-        void render() override;
+        void update(component_storage &storage) override;
+        void render(VkCommandBuffer command_buffer, component_storage const &storage) override;
 
     protected:
         void create_pipeline_layout(VkDescriptorSetLayout global_set_layout) override;
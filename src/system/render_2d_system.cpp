@@ -1,7 +1,9 @@
 ﻿#include "render_2d_system.h"
 
 // Project includes
+#include "src/core/component_storage.h"
 #include "src/engine/frame_info.h"
+#include "src/utility/texture_registry.h"
 #include "src/vulkan/device.h"
 #include "src/vulkan/renderer.h"
 
@@ -19,7 +21,9 @@ namespace dae
     struct push_constant_data_2d
     {
         glm::mat4 transform{1.0f};
+        glm::vec4 uv_transform{0.0f, 0.0f, 1.0f, 1.0f};
         bool use_texture;
+        int texture_index;
     };
     
     render_2d_system::render_2d_system(VkDescriptorSetLayout global_set_layout)
@@ -28,38 +32,71 @@ namespace dae
         create_pipeline(renderer::instance().swap_chain_render_pass());
     }
 
-    void render_2d_system::render()
+    void render_2d_system::render(VkCommandBuffer command_buffer, component_storage const &storage)
     {
         auto &frame_info = frame_info::instance();
-        pipeline_->bind(frame_info.command_buffer);
+        pipeline_->bind(command_buffer);
 
         vkCmdBindDescriptorSets(
-            frame_info.command_buffer,
+            command_buffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipeline_layout_,
             0,
             1,
             &frame_info.global_descriptor_set,
+            1,
+            &frame_info.global_ubo_offset
+        );
+
+        vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline_layout_,
+            1,
+            1,
+            &texture_registry::instance().descriptor_set(),
             0,
             nullptr
         );
         
-        for (auto const &obj : frame_info.game_objects)
+        auto const &transforms = storage.transforms();
+        auto const &models = storage.models();
+        auto const &use_textures = storage.use_textures();
+        auto const &texture_indices = storage.texture_indices();
+        auto &textures = texture_registry::instance();
+        auto const &camera = *frame_info.camera_ptr;
+        auto const viewport_height = static_cast<float>(renderer::instance().extent().height);
+        auto const &visibility = storage.visibility();
+        geometry_arena::instance().bind(command_buffer);
+        for (component_storage::index_t index = 0; index < storage.size(); ++index)
         {
+            if (not visibility[index])
+            {
+                continue;
+            }
+
             push_constant_data_2d push{};
-            push.transform = obj->transform.mat4();
-            push.use_texture = obj->use_texture;
+            glm::mat4 const &model_matrix = transforms[index].mat4();
+            push.transform = model_matrix * models[index]->dequantization();
+            push.uv_transform = models[index]->uv_transform();
+            push.use_texture = use_textures[index];
+            push.texture_index = textures.resolve(texture_indices[index].x);
+
+            auto const &scale = transforms[index].scale();
+            glm::vec3 const center{model_matrix * glm::vec4{models[index]->bounding_center(), 1.0f}};
+            float const radius = models[index]->bounding_radius() * glm::max(glm::abs(scale.x), glm::abs(scale.y));
+            textures.request(texture_indices[index].x, camera.screen_coverage(center, radius) * viewport_height);
 
             vkCmdPushConstants(
-                frame_info.command_buffer,
+                command_buffer,
                 pipeline_layout_,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(push_constant_data_2d),
                 &push);
             
-            obj->model->bind(frame_info.command_buffer);
-            obj->model->draw(frame_info.command_buffer);
+            frame_info.draw_calls += models[index]->draw(command_buffer);
+            ++frame_info.instance_count;
         }
     }
 
@@ -70,7 +107,7 @@ namespace dae
         push_constant_range.offset     = 0;
         push_constant_range.size       = sizeof(push_constant_data_2d);
 
-        std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout};
+        std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout, texture_registry::instance().set_layout()};
         
         VkPipelineLayoutCreateInfo pipeline_layout_info{};
         pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -93,6 +130,8 @@ namespace dae
         pipeline::default_pipeline_config_info(pipeline_config);
         pipeline_config.render_pass = render_pass;
         pipeline_config.pipeline_layout = pipeline_layout_;
+        pipeline_config.attribute_descriptions = model::packed_vertex::get_attribute_descriptions(
+            model::packed_vertex::position_bit | model::packed_vertex::color_bit | model::packed_vertex::uv_bit);
         pipeline_ = std::make_unique<pipeline>(
             "shaders/2d.vert.spv",
             "shaders/2d.frag.spv",
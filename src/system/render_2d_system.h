@@ -16,7 +16,7 @@ namespace dae
         render_2d_system &operator=(render_2d_system const &other) = delete;
         render_2d_system &operator=(render_2d_system &&other)      = delete;
         
-        void render() override;
+        void render(VkCommandBuffer command_buffer, component_storage const &storage) override;
 
     protected:
         void create_pipeline_layout(VkDescriptorSetLayout global_set_layout) override;
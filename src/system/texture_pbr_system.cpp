@@ -1,7 +1,11 @@
 ﻿#include "texture_pbr_system.h"
 
 // Project includes
+#include "src/core/component_storage.h"
+#include "src/engine/engine.h"
 #include "src/engine/frame_info.h"
+#include "src/engine/job_system.h"
+#include "src/utility/texture_registry.h"
 #include "src/vulkan/device.h"
 #include "src/vulkan/renderer.h"
 
@@ -13,8 +17,6 @@ namespace dae
 {
     struct texture_pbr_push_constant
     {
-        glm::mat4 model_matrix{1.0f};
-        glm::mat4 normal_matrix{1.0f};
         int shading_mode;
         bool use_normal;
     };
@@ -23,53 +25,109 @@ namespace dae
     {
         create_pipeline_layout(global_set_layout);
         create_pipeline(renderer::instance().swap_chain_render_pass());
+        if (engine::gpu_culling)
+        {
+            instance_batcher_.enable_gpu_culling(global_set_layout);
+        }
+    }
+
+    void texture_pbr_system::prepare(VkCommandBuffer command_buffer, component_storage const &storage)
+    {
+        if (instance_batcher_.gpu_culling())
+        {
+            write_records(storage);
+            instance_batcher_.dispatch(command_buffer);
+        }
     }
 
-    void texture_pbr_system::render()
+    void texture_pbr_system::render(VkCommandBuffer command_buffer, component_storage const &storage)
     {
         auto &frame_info = frame_info::instance();
-        pipeline_->bind(frame_info.command_buffer);
+        pipeline_->bind(command_buffer);
 
         vkCmdBindDescriptorSets(
-            frame_info.command_buffer,
+            command_buffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipeline_layout_,
             0,
             1,
             &frame_info.global_descriptor_set,
+            1,
+            &frame_info.global_ubo_offset
+        );
+
+        vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline_layout_,
+            1,
+            1,
+            &texture_registry::instance().descriptor_set(),
             0,
             nullptr
         );
 
-        for (auto const &obj : frame_info.game_objects)
-        {
-            texture_pbr_push_constant push{};
-            push.model_matrix = obj->transform.mat4();
-            push.normal_matrix = obj->transform.normal_matrix();
-            push.use_normal = frame_info.use_normal;
-            push.shading_mode = frame_info.shading_mode;
+        texture_pbr_push_constant push{};
+        push.use_normal = frame_info.use_normal;
+        push.shading_mode = frame_info.shading_mode;
 
-            vkCmdPushConstants(
-                frame_info.command_buffer,
-                pipeline_layout_,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(texture_pbr_push_constant),
-                &push);
-            
-            obj->model->bind(frame_info.command_buffer);
-            obj->model->draw(frame_info.command_buffer);
+        vkCmdPushConstants(
+            command_buffer,
+            pipeline_layout_,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(texture_pbr_push_constant),
+            &push);
+
+        if (not instance_batcher_.gpu_culling())
+        {
+            write_records(storage);
         }
+        instance_batcher_.draw(command_buffer);
+    }
+
+    void texture_pbr_system::write_records(component_storage const &storage)
+    {
+        auto &frame_info = frame_info::instance();
+        auto const &transforms = storage.transforms();
+        auto const &models = storage.models();
+        auto const &texture_indices = storage.texture_indices();
+        auto &textures = texture_registry::instance();
+        auto const &camera = *frame_info.camera_ptr;
+        auto const viewport_height = static_cast<float>(renderer::instance().extent().height);
+        instance_batcher_.build(storage);
+        auto *records = instance_batcher_.allocate_objects();
+        auto const &indices = instance_batcher_.indices();
+        job_system::instance().parallel_for(indices.size(), 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto const index = indices[i];
+                glm::mat4 const &model_matrix = transforms[index].mat4();
+                object_data record{};
+                record.model_matrix = model_matrix * models[index]->dequantization();
+                record.normal_matrix = glm::mat3x4{transforms[index].normal_matrix()};
+                record.uv_transform = models[index]->uv_transform();
+                record.texture_indices = textures.resolve(texture_indices[index]);
+                records[i] = record;
+
+                // Drives which mip levels of the textures stay resident
+                auto const &scale = transforms[index].scale();
+                glm::vec3 const center{model_matrix * glm::vec4{models[index]->bounding_center(), 1.0f}};
+                float const radius = models[index]->bounding_radius() * glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+                textures.request(texture_indices[index], camera.screen_coverage(center, radius) * viewport_height);
+            }
+        });
     }
 
     void texture_pbr_system::create_pipeline_layout(VkDescriptorSetLayout global_set_layout)
     {
         VkPushConstantRange push_constant_range{};
-        push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         push_constant_range.offset     = 0;
         push_constant_range.size       = sizeof(texture_pbr_push_constant);
         
-        std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout};
+        std::vector<VkDescriptorSetLayout> descriptor_set_layouts{global_set_layout, texture_registry::instance().set_layout()};
         
         VkPipelineLayoutCreateInfo pipeline_layout_info{};
         pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
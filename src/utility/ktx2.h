@@ -0,0 +1,46 @@
+﻿#pragma once
+
+// Standard includes
+#include <array>
+#include <cstdint>
+
+namespace dae
+{
+    // On-disk layout of KTX2 files as written by the texture cooker (tools/texture_cooker) and read by texture.
+    // Only what block-compressed 2D textures need: no supercompression, no key/value data, one layer and one face.
+    // See https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+    namespace ktx2
+    {
+        inline constexpr std::array<uint8_t, 12> identifier{0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+        struct header
+        {
+            uint8_t  identifier[12];
+            uint32_t vk_format;
+            uint32_t type_size;
+            uint32_t pixel_width;
+            uint32_t pixel_height;
+            uint32_t pixel_depth;
+            uint32_t layer_count;
+            uint32_t face_count;
+            uint32_t level_count;
+            uint32_t supercompression_scheme;
+            uint32_t dfd_byte_offset;
+            uint32_t dfd_byte_length;
+            uint32_t kvd_byte_offset;
+            uint32_t kvd_byte_length;
+            uint64_t sgd_byte_offset;
+            uint64_t sgd_byte_length;
+        };
+        static_assert(sizeof(header) == 80);
+
+        // One per mip level, level 0 first; the data itself is stored smallest level first
+        struct level_index
+        {
+            uint64_t byte_offset;
+            uint64_t byte_length;
+            uint64_t uncompressed_byte_length;
+        };
+        static_assert(sizeof(level_index) == 24);
+    }
+}
@@ -2,11 +2,18 @@
 
 // Project includes
 #include "src/engine/engine.h"
-#include "src/vulkan/buffer.h"
+#include "src/utility/ktx2.h"
 #include "src/vulkan/device.h"
+#include "src/vulkan/upload_queue.h"
 
 // Standard includes
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
 #include <stdexcept>
 
 // STB includes
@@ -25,44 +32,153 @@
 
 namespace dae
 {
-    texture::texture(std::string const &file_path, VkFormat format)
-        : device_ptr_{&device::instance()}
-        , image_format_{format}
+    namespace
     {
-        int text_channels;
+        // Empty when the file is missing or uses anything the cooker does not write
+        auto read_ktx2(std::filesystem::path const &path) -> image_data
+        {
+            image_data image{};
+            std::ifstream file{path, std::ios::binary | std::ios::ate};
+            if (not file)
+            {
+                return image;
+            }
+            std::vector<unsigned char> data(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+
+            ktx2::header header{};
+            if (data.size() < sizeof(header))
+            {
+                return image;
+            }
+            std::memcpy(&header, data.data(), sizeof(header));
+            if (not std::equal(ktx2::identifier.begin(), ktx2::identifier.end(), header.identifier) or
+                header.supercompression_scheme != 0 or header.level_count == 0 or header.face_count != 1 or
+                header.layer_count > 1 or header.pixel_depth > 1 or
+                data.size() < sizeof(header) + header.level_count * sizeof(ktx2::level_index))
+            {
+                std::cerr << "Unsupported KTX2 file: " << path.string() << '\n';
+                return image;
+            }
+
+            for (uint32_t i = 0; i < header.level_count; ++i)
+            {
+                ktx2::level_index level{};
+                std::memcpy(&level, data.data() + sizeof(header) + i * sizeof(level), sizeof(level));
+                if (level.byte_offset + level.byte_length > data.size())
+                {
+                    std::cerr << "Truncated KTX2 file: " << path.string() << '\n';
+                    image.cooked_levels.clear();
+                    return image;
+                }
+                image.cooked_levels.push_back({static_cast<size_t>(level.byte_offset), static_cast<size_t>(level.byte_length)});
+            }
+
+            image.cooked        = std::move(data);
+            image.cooked_format = static_cast<VkFormat>(header.vk_format);
+            image.width         = static_cast<int>(header.pixel_width);
+            image.height        = static_cast<int>(header.pixel_height);
+            return image;
+        }
+    }
+
+    void image_data::pixel_deleter::operator()(unsigned char *pixels) const
+    {
+        stbi_image_free(pixels);
+    }
 
-        std::string const path = ENGINE_DIR + engine::data_path + file_path;
-        stbi_uc *pixels = stbi_load(path.c_str(), &width_, &height_, &text_channels, STBI_rgb_alpha);
-        mip_levels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(width_, height_)))) + 1;
+    auto texture::decode(std::string const &file_path) -> image_data
+    {
+        std::filesystem::path const path = ENGINE_DIR + engine::data_path + file_path;
 
-        buffer staging_buffer{
-            4,
-            static_cast<uint32_t>(width_ * height_),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+        // Cooked by the Textures build target; sources without one fall back to RGBA8 with mips blitted at load time
+        if (device::instance().enabled_features().textureCompressionBC)
+        {
+            if (auto image = read_ktx2(std::filesystem::path{path}.replace_extension(".ktx2")); not image.empty())
+            {
+                return image;
+            }
+        }
+
+        image_data image{};
+        int text_channels;
+        image.pixels.reset(stbi_load(path.string().c_str(), &image.width, &image.height, &text_channels, STBI_rgb_alpha));
+        return image;
+    }
 
-        staging_buffer.map();
-        staging_buffer.write_to_buffer(pixels);
+    texture::texture(std::string const &file_path, VkFormat format)
+        : texture{[&file_path]
+        {
+            auto image = decode(file_path);
+            if (image.empty())
+            {
+                throw std::runtime_error{"Failed to load texture image: " + file_path};
+            }
+            return image;
+        }(), format}
+    {
+    }
+
+    texture::texture(image_data const &image, VkFormat format, uint32_t base_level, uint32_t resident_level)
+        : device_ptr_{&device::instance()}
+        , image_format_{image.cooked.empty() ? format : image.cooked_format}
+        , width_{image.width}
+        , height_{image.height}
+        , base_level_{base_level}
+        , resident_level_{resident_level}
+    {
+        bool const cooked = not image.cooked.empty();
+        assert((cooked or (base_level == 0 and resident_level == 0)) and "Only cooked textures can be partly resident");
+        assert(base_level <= resident_level and (not cooked or resident_level < image.cooked_levels.size()) and "Invalid mip range");
+        mip_levels_ = cooked ? static_cast<uint32_t>(image.cooked_levels.size()) - base_level_ : static_cast<uint32_t>(std::floor(std::log2(std::max(width_, height_)))) + 1;
+        image_views_.resize(mip_levels_, VK_NULL_HANDLE);
 
         VkImageCreateInfo image_info{};
         image_info.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         image_info.imageType     = VK_IMAGE_TYPE_2D;
         image_info.format        = image_format_;
-        image_info.extent.width  = static_cast<uint32_t>(width_);
-        image_info.extent.height = static_cast<uint32_t>(height_);
+        image_info.extent.width  = std::max(static_cast<uint32_t>(width_) >> base_level_, 1u);
+        image_info.extent.height = std::max(static_cast<uint32_t>(height_) >> base_level_, 1u);
         image_info.extent.depth  = 1;
         image_info.mipLevels     = mip_levels_;
         image_info.arrayLayers   = 1;
         image_info.samples       = VK_SAMPLE_COUNT_1_BIT;
         image_info.tiling        = VK_IMAGE_TILING_OPTIMAL;
-        image_info.usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_info.usage         = cooked ? VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT : VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
         image_info.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
         image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
         device_ptr_->create_image_with_info(image_info,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, image_memory_);
-        transition_image_layout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        device_ptr_->copy_buffer_to_image(staging_buffer.get_buffer(), image_, static_cast<uint32_t>(width_), static_cast<uint32_t>(height_), 1);
-        generate_mipmaps();
+
+        VkFormatProperties format_properties;
+        vkGetPhysicalDeviceFormatProperties(device_ptr_->physical_device(), image_format_, &format_properties);
+        if (not cooked and not (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+        {
+            throw std::runtime_error("texture image format does not support linear blitting!");
+        }
+
+        // The copies run on the transfer queue. Cooked images bring their mip levels and only change layout on the
+        // graphics queue; the others get their mip chain blitted there, since blits need the graphics queue.
+        // The batch's final barrier orders all of it before any later sampling.
+        if (cooked)
+        {
+            upload_levels(image, resident_level_ - base_level_, mip_levels_ - (resident_level_ - base_level_));
+        }
+        else
+        {
+            auto &uploads = upload_queue::instance();
+            uploads.record([this](VkCommandBuffer command_buffer)
+            {
+                transition_image_layout(command_buffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, mip_levels_);
+            });
+            uploads.upload_to_image(image_, image.pixels.get(), static_cast<VkDeviceSize>(width_) * height_ * 4, static_cast<uint32_t>(width_), static_cast<uint32_t>(height_), 1);
+            uploads.transfer_ownership(image_, {VK_IMAGE_ASPECT_COLOR_BIT, 0, mip_levels_, 0, 1}, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            uploads.record_graphics([this](VkCommandBuffer command_buffer)
+            {
+                generate_mipmaps(command_buffer);
+            });
+        }
 
         image_layout_ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
@@ -81,12 +197,74 @@ namespace dae
         sampler_info.compareOp               = VK_COMPARE_OP_NEVER;
         sampler_info.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         sampler_info.minLod                  = 0.0f;
-        sampler_info.maxLod                  = static_cast<float>(mip_levels_);
+        sampler_info.maxLod                  = VK_LOD_CLAMP_NONE; // the view limits the mips, so one sampler fits every texture
         sampler_info.mipLodBias              = 0.0f;
         sampler_info.anisotropyEnable        = VK_TRUE;
         sampler_info.maxAnisotropy           = 4.0f;
 
-        vkCreateSampler(device_ptr_->logical_device(), &sampler_info, nullptr, &sampler_);
+        sampler_ = device_ptr_->samplers().get(sampler_info);
+
+        create_image_view();
+    }
+
+    texture::~texture()
+    {
+        for (auto const view : image_views_)
+        {
+            vkDestroyImageView(device_ptr_->logical_device(), view, nullptr);
+        }
+        vkDestroyImage(device_ptr_->logical_device(), image_, nullptr);
+        device_ptr_->allocator().free(image_memory_);
+    }
+
+    void texture::upload_next_level(image_data const &image)
+    {
+        assert(resident_level_ > base_level_ and "Every level of the image is resident already");
+        upload_levels(image, resident_level_ - base_level_ - 1, 1);
+    }
+
+    void texture::commit_next_level()
+    {
+        assert(resident_level_ > base_level_ and "Every level of the image is resident already");
+        --resident_level_;
+        create_image_view();
+    }
+
+    void texture::upload_levels(image_data const &image, uint32_t first_level, uint32_t level_count)
+    {
+        // Levels that were never written are still undefined and owned by no queue family, so the transfer queue
+        // takes them as they are while frames keep sampling the resident ones through a view that excludes them
+        auto &uploads = upload_queue::instance();
+        uploads.record([this, first_level, level_count](VkCommandBuffer command_buffer)
+        {
+            transition_image_layout(command_buffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, first_level, level_count);
+        });
+
+        // Smallest first, like the file stores them
+        for (uint32_t level = first_level + level_count; level-- > first_level;)
+        {
+            uint32_t const chain_level = base_level_ + level;
+            auto const &[offset, size] = image.cooked_levels[chain_level];
+            uploads.upload_to_image(
+                image_,
+                image.cooked.data() + offset,
+                size,
+                std::max(static_cast<uint32_t>(width_) >> chain_level, 1u),
+                std::max(static_cast<uint32_t>(height_) >> chain_level, 1u),
+                1,
+                level);
+        }
+        uploads.transfer_ownership(image_, {VK_IMAGE_ASPECT_COLOR_BIT, first_level, level_count, 0, 1}, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        uploads.record_graphics([this, first_level, level_count](VkCommandBuffer command_buffer)
+        {
+            transition_image_layout(command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, first_level, level_count);
+        });
+    }
+
+    void texture::create_image_view()
+    {
+        auto &view = image_views_[resident_level_ - base_level_];
+        assert(view == VK_NULL_HANDLE and "Image view exists already");
 
         VkImageViewCreateInfo view_info{};
         view_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -94,8 +272,8 @@ namespace dae
         view_info.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
         view_info.format                          = image_format_;
         view_info.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        view_info.subresourceRange.baseMipLevel   = 0;
-        view_info.subresourceRange.levelCount     = mip_levels_;
+        view_info.subresourceRange.baseMipLevel   = resident_level_ - base_level_;
+        view_info.subresourceRange.levelCount     = mip_levels_ - (resident_level_ - base_level_);
         view_info.subresourceRange.baseArrayLayer = 0;
         view_info.subresourceRange.layerCount     = 1;
         view_info.components.r                    = VK_COMPONENT_SWIZZLE_R;
@@ -103,23 +281,21 @@ namespace dae
         view_info.components.b                    = VK_COMPONENT_SWIZZLE_B;
         view_info.components.a                    = VK_COMPONENT_SWIZZLE_A;
 
-        vkCreateImageView(device_ptr_->logical_device(), &view_info, nullptr, &image_view_);
-
-        stbi_image_free(pixels);
+        vkCreateImageView(device_ptr_->logical_device(), &view_info, nullptr, &view);
     }
 
-    texture::~texture()
+    auto texture::rgba8_size() const -> VkDeviceSize
     {
-        vkDestroyImage(device_ptr_->logical_device(), image_, nullptr);
-        vkFreeMemory(device_ptr_->logical_device(), image_memory_, nullptr);
-        vkDestroyImageView(device_ptr_->logical_device(), image_view_, nullptr);
-        vkDestroySampler(device_ptr_->logical_device(), sampler_, nullptr);
+        VkDeviceSize size = 0;
+        for (uint32_t level = base_level_; level < base_level_ + mip_levels_; ++level)
+        {
+            size += static_cast<VkDeviceSize>(std::max(width_ >> level, 1)) * std::max(height_ >> level, 1) * 4;
+        }
+        return size;
     }
 
-    void texture::transition_image_layout(VkImageLayout old_layout, VkImageLayout new_layout)
+    void texture::transition_image_layout(VkCommandBuffer command_buffer, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t first_level, uint32_t level_count)
     {
-        VkCommandBuffer command_buffer = device_ptr_->begin_single_time_commands();
-        
         VkImageMemoryBarrier barrier{};
         barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.oldLayout                       = old_layout;
@@ -128,8 +304,8 @@ namespace dae
         barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
         barrier.image                           = image_;
         barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel   = 0;
-        barrier.subresourceRange.levelCount     = mip_levels_;
+        barrier.subresourceRange.baseMipLevel   = first_level;
+        barrier.subresourceRange.levelCount     = level_count;
         barrier.subresourceRange.baseArrayLayer = 0;
         barrier.subresourceRange.layerCount     = 1;
 
@@ -168,22 +344,11 @@ namespace dae
             nullptr,
             1,
             &barrier);
-
-        device_ptr_->end_single_time_commands(command_buffer);
     }
 
-    void texture::generate_mipmaps()
+    // Format support for linear blits is checked by the constructor before this gets queued
+    void texture::generate_mipmaps(VkCommandBuffer command_buffer)
     {
-        VkFormatProperties format_properties;
-        vkGetPhysicalDeviceFormatProperties(device_ptr_->physical_device(), image_format_, &format_properties);
-
-        if (not (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
-        {
-            throw std::runtime_error("texture image format does not support linear blitting!");
-        }
-
-        VkCommandBuffer command_buffer = device_ptr_->begin_single_time_commands();
-
         VkImageMemoryBarrier barrier{};
         barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image                           = image_;
@@ -279,7 +444,5 @@ namespace dae
             nullptr,
             1,
             &barrier);
-
-        device_ptr_->end_single_time_commands(command_buffer);
     }
 }
@@ -1,7 +1,12 @@
 ﻿#pragma once
 
+// Project includes
+#include "src/vulkan/memory_allocator.h"
+
 // Standard includes
+#include <memory>
 #include <string>
+#include <vector>
 
 // Vulkan includes
 #include <vulkan/vulkan.h>
@@ -10,37 +15,90 @@ namespace dae
 {
     // Forward declarations
     class device;
+
+    // Contents of an image file, see texture::decode(): either RGBA8 pixels for mip 0, or the block-compressed mip
+    // chain of the cooked KTX2 file next to it
+    struct image_data
+    {
+        struct pixel_deleter
+        {
+            void operator()(unsigned char *pixels) const;
+        };
+
+        struct level
+        {
+            size_t offset;
+            size_t size;
+        };
+
+        std::unique_ptr<unsigned char[], pixel_deleter> pixels;
+        std::vector<unsigned char> cooked;
+        std::vector<level>         cooked_levels; // level 0 first, ranges of cooked
+        VkFormat                   cooked_format = VK_FORMAT_UNDEFINED;
+        int width  = 0;
+        int height = 0;
+
+        [[nodiscard]] auto empty() const -> bool { return not pixels and cooked.empty(); }
+    };
     
+    // A cooked texture can be partly resident: its image only has the levels from base_level() down to the smallest,
+    // and only those from resident_level() down are uploaded so far. Finer levels are streamed in one at a time with
+    // upload_next_level(), smallest first; the view that gets sampled covers the uploaded levels only, so the LOD
+    // clamp rises as they arrive while every texture keeps sharing one sampler.
     class texture
     {
     public:
         texture(std::string const &file_path, VkFormat format);
+        // Cooked images keep the format they were cooked to, format only applies to RGBA8 pixels. Levels are counted
+        // on the full chain; anything but 0 needs a cooked image.
+        texture(image_data const &image, VkFormat format, uint32_t base_level = 0, uint32_t resident_level = 0);
         ~texture();
 
+        // CPU only and thread safe, meant for worker threads. Prefers a cooked .ktx2 with the same name when the device
+        // can sample it; the result is empty when neither file could be read.
+        [[nodiscard]] static auto decode(std::string const &file_path) -> image_data;
+
         texture(texture const &)            = delete;
         texture(texture &&)                 = delete;
         texture &operator=(texture const &) = delete;
         texture &operator=(texture &&)      = delete;
 
+        // Queues the upload of level resident_level() - 1; once its batch completed, commit_next_level() makes it
+        // part of image_view(). Views handed out before stay valid for the texture's lifetime.
+        void upload_next_level(image_data const &image);
+        void commit_next_level();
+
         [[nodiscard]] auto sampler() const -> VkSampler { return sampler_; }
-        [[nodiscard]] auto image_view() const -> VkImageView { return image_view_; }
+        [[nodiscard]] auto image_view() const -> VkImageView { return image_views_[resident_level_ - base_level_]; }
         [[nodiscard]] auto image_layout() const -> VkImageLayout { return image_layout_; }
+        [[nodiscard]] auto memory_size() const -> VkDeviceSize { return image_memory_.size; }
+        [[nodiscard]] auto base_level() const -> uint32_t { return base_level_; }
+        [[nodiscard]] auto resident_level() const -> uint32_t { return resident_level_; }
+        [[nodiscard]] auto level_count() const -> uint32_t { return base_level_ + mip_levels_; }
+
+        // What the mip chain takes as uncompressed RGBA8, to compare cooked textures against
+        [[nodiscard]] auto rgba8_size() const -> VkDeviceSize;
 
     private:
-        void transition_image_layout(VkImageLayout old_layout, VkImageLayout new_layout);
-        void generate_mipmaps();
+        // Levels are image levels here, relative to base_level_
+        void upload_levels(image_data const &image, uint32_t first_level, uint32_t level_count);
+        void transition_image_layout(VkCommandBuffer command_buffer, VkImageLayout old_layout, VkImageLayout new_layout, uint32_t first_level, uint32_t level_count);
+        void generate_mipmaps(VkCommandBuffer command_buffer);
+        void create_image_view();
 
     private:
-        device         *device_ptr_;
-        VkImage        image_        = VK_NULL_HANDLE;
-        VkDeviceMemory image_memory_ = VK_NULL_HANDLE;
-        VkImageView    image_view_   = VK_NULL_HANDLE;
-        VkSampler      sampler_      = VK_NULL_HANDLE;
-        VkFormat       image_format_ = VK_FORMAT_UNDEFINED;
-        VkImageLayout  image_layout_ = VK_IMAGE_LAYOUT_UNDEFINED;
-
-        int      width_      = 0;
-        int      height_     = 0;
-        uint32_t mip_levels_ = 0;
+        device            *device_ptr_;
+        VkImage           image_        = VK_NULL_HANDLE;
+        memory_allocation image_memory_ = {};
+        std::vector<VkImageView> image_views_; // indexed by resident_level_ - base_level_, created as levels arrive
+        VkSampler         sampler_      = VK_NULL_HANDLE;
+        VkFormat          image_format_ = VK_FORMAT_UNDEFINED;
+        VkImageLayout     image_layout_ = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        int      width_          = 0; // of the full chain's level 0
+        int      height_         = 0;
+        uint32_t mip_levels_     = 0; // in the image
+        uint32_t base_level_     = 0;
+        uint32_t resident_level_ = 0;
     };
 }
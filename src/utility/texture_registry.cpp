@@ -0,0 +1,377 @@
+﻿#include "texture_registry.h"
+
+// Project includes
+#include "src/utility/utils.h"
+#include "src/vulkan/device.h"
+#include "src/vulkan/swap_chain.h"
+
+// Standard includes
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace dae
+{
+    VkDeviceSize texture_registry::memory_budget = 256 * 1024 * 1024;
+
+    texture_registry::texture_registry()
+        : slots_(max_textures, static_cast<int>(debug_texture))
+        , wanted_pixels_{std::make_unique<std::atomic<uint32_t>[]>(max_textures)}
+    {
+        set_layout_ = descriptor_set_layout::builder()
+                      .add_binding(
+                          0,
+                          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                          VK_SHADER_STAGE_FRAGMENT_BIT,
+                          max_textures,
+                          VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT)
+                      .build();
+
+        pool_ = descriptor_pool::builder()
+                .set_max_sets(1)
+                .set_pool_flags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+                .add_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, max_textures)
+                .build();
+
+        if (not pool_->allocate_descriptor(set_layout_->get_descriptor_set_layout(), descriptor_set_))
+        {
+            throw std::runtime_error{"Failed to allocate bindless texture set!"};
+        }
+
+        // Handed out lowest first; slot 0 belongs to the placeholder
+        free_slots_.reserve(max_textures - 1);
+        for (uint32_t slot = max_textures - 1; slot > debug_texture; --slot)
+        {
+            free_slots_.push_back(slot);
+        }
+        textures_.reserve(max_textures);
+
+        // The placeholder is loaded synchronously and fully resident; everything resolves to it while its own
+        // texture is in flight
+        std::string const debug_texture_path = "assets/textures/debug.png";
+        textures_.emplace_back().current = std::make_unique<texture>(debug_texture_path, VK_FORMAT_R8G8B8A8_SRGB);
+        handles_.emplace(debug_texture_path + '#' + std::to_string(VK_FORMAT_R8G8B8A8_SRGB), debug_texture);
+
+        VkDescriptorImageInfo image_info{};
+        image_info.sampler     = textures_[debug_texture].current->sampler();
+        image_info.imageView   = textures_[debug_texture].current->image_view();
+        image_info.imageLayout = textures_[debug_texture].current->image_layout();
+        descriptor_writer(set_layout_.get(), pool_.get())
+            .write_image(0, &image_info, debug_texture)
+            .overwrite(descriptor_set_);
+    }
+
+    texture_registry::~texture_registry()
+    {
+        // decode jobs write into decoded_, they have to be done before it goes away
+        job_system::instance().wait(decode_counter_);
+    }
+
+    auto texture_registry::load(std::string const &file_path, VkFormat format) -> uint32_t
+    {
+        std::lock_guard lock{mutex_};
+        auto const key = file_path + '#' + std::to_string(format);
+        if (auto const it = handles_.find(key); it != handles_.end())
+        {
+#ifndef NDEBUG
+            std::cout << "Reusing texture: " << file_path << '\n';
+#endif
+            return it->second;
+        }
+
+        if (textures_.size() == max_textures)
+        {
+            throw std::runtime_error{"Bindless texture table is full!"};
+        }
+
+        auto const handle = static_cast<uint32_t>(textures_.size());
+        textures_.emplace_back();
+        handles_.emplace(key, handle);
+
+        job_system::instance().run([this, handle, format, file_path]
+        {
+            auto image = texture::decode(file_path);
+            if (image.empty())
+            {
+                // the handle keeps resolving to the placeholder
+                std::cerr << "Failed to load texture: " << file_path << '\n';
+                return;
+            }
+            std::lock_guard lock{mutex_};
+            decoded_.push_back({handle, format, std::move(image)});
+        }, &decode_counter_);
+        return handle;
+    }
+
+    void texture_registry::request(int handle, float pixels)
+    {
+        auto const wanted = static_cast<uint32_t>(std::max(pixels, 0.0f));
+        auto &slot = wanted_pixels_[handle];
+        uint32_t current = slot.load(std::memory_order_relaxed);
+        while (wanted > current and not slot.compare_exchange_weak(current, wanted, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void texture_registry::update()
+    {
+        // Called once per frame after the renderer waited for the frame that used this frame's resources last time,
+        // so slots retired MAX_FRAMES_IN_FLIGHT updates ago are no longer sampled
+        ++frame_;
+        while (not retired_.empty() and retired_.front().frame + swap_chain::MAX_FRAMES_IN_FLIGHT <= frame_)
+        {
+            free_slots_.push_back(retired_.front().slot);
+            retired_.pop_front();
+        }
+
+        process();
+        stream();
+    }
+
+    void texture_registry::flush()
+    {
+        job_system::instance().wait(decode_counter_);
+        process();
+        upload_queue::instance().flush();
+        process();
+    }
+
+    void texture_registry::process()
+    {
+        std::vector<decoded_texture> decoded;
+        {
+            std::lock_guard lock{mutex_};
+            decoded.swap(decoded_);
+        }
+
+        // Image creation and upload recording stay on the main thread; pixels are copied into staging right away
+        auto &uploads = upload_queue::instance();
+        for (auto &[handle, format, image] : decoded)
+        {
+            auto &entry = textures_[handle];
+            entry.format = format;
+            if (image.cooked_levels.size() > 1)
+            {
+                auto const level_count = static_cast<uint32_t>(image.cooked_levels.size());
+                entry.tail_level = 0;
+                while (entry.tail_level + 1 < level_count and
+                       static_cast<uint32_t>(std::max(image.width, image.height)) >> entry.tail_level > stream_tail_size)
+                {
+                    ++entry.tail_level;
+                }
+                entry.wanted_level = entry.tail_level;
+                entry.next         = std::make_unique<texture>(image, format, entry.tail_level, entry.tail_level);
+                entry.source       = std::move(image);
+            }
+            else
+            {
+                entry.next = std::make_unique<texture>(image, format);
+            }
+            entry.ticket    = uploads.current_ticket();
+            entry.uploading = true;
+        }
+
+        complete_uploads();
+    }
+
+    void texture_registry::complete_uploads()
+    {
+        auto &uploads = upload_queue::instance();
+        for (uint32_t handle = 0; handle < textures_.size(); ++handle)
+        {
+            auto &entry = textures_[handle];
+            if (not entry.uploading or not uploads.is_complete(entry.ticket))
+            {
+                continue;
+            }
+
+            entry.uploading = false;
+            std::unique_ptr<texture> replaced;
+            if (entry.next)
+            {
+                replaced      = std::move(entry.current);
+                entry.current = std::move(entry.next);
+            }
+            else
+            {
+                entry.current->commit_next_level();
+            }
+            publish(handle, std::move(replaced));
+        }
+    }
+
+    void texture_registry::stream()
+    {
+        // What the last frame asked for; textures nobody asked for only need their tail
+        VkDeviceSize fixed_bytes    = 0;
+        VkDeviceSize wanted_bytes   = 0;
+        VkDeviceSize resident_bytes = 0;
+        for (uint32_t handle = 0; handle < textures_.size(); ++handle)
+        {
+            auto &entry = textures_[handle];
+            auto const pixels = wanted_pixels_[handle].exchange(0, std::memory_order_relaxed);
+            if (not entry.current)
+            {
+                continue;
+            }
+            resident_bytes += entry.current->memory_size();
+            if (entry.source.empty())
+            {
+                fixed_bytes += entry.current->memory_size();
+                continue;
+            }
+            entry.wanted_level = wanted_level(entry, pixels);
+            wanted_bytes += level_bytes(entry.source, entry.wanted_level);
+        }
+
+        // Over budget, the textures wanted at the finest level drop a level first, then the next finest and so on
+        for (uint32_t level = 0; fixed_bytes + wanted_bytes > memory_budget; ++level)
+        {
+            bool coarser_left = false;
+            for (auto &entry : textures_)
+            {
+                if (not entry.current or entry.source.empty() or entry.wanted_level >= entry.tail_level)
+                {
+                    continue;
+                }
+                coarser_left = true;
+                if (entry.wanted_level == level and fixed_bytes + wanted_bytes > memory_budget)
+                {
+                    wanted_bytes -= level_bytes(entry.source, level) - level_bytes(entry.source, level + 1);
+                    ++entry.wanted_level;
+                }
+            }
+            if (not coarser_left)
+            {
+                break;
+            }
+        }
+
+        // One step per texture: a bigger image, the next finer level, or a smaller image. Whatever is resident keeps
+        // being sampled until the step completed. The cursor rotates so a capped update does not starve the rest.
+        bool const   over_budget = resident_bytes > memory_budget;
+        VkDeviceSize staged      = 0;
+        auto &uploads = upload_queue::instance();
+        for (size_t i = 0; i < textures_.size() and staged < stream_bytes_per_update; ++i)
+        {
+            auto &entry = textures_[(stream_cursor_ + i) % textures_.size()];
+            if (not entry.current or entry.source.empty() or entry.uploading)
+            {
+                continue;
+            }
+
+            auto const base     = entry.current->base_level();
+            auto const resident = entry.current->resident_level();
+            auto const wanted   = entry.wanted_level;
+            entry.coarse_updates = wanted > base ? entry.coarse_updates + 1 : 0;
+            if (wanted < base)
+            {
+                // The resident levels go again into the bigger image, finer ones follow from there
+                entry.next = std::make_unique<texture>(entry.source, entry.format, wanted, resident);
+                staged += level_bytes(entry.source, resident);
+            }
+            else if (resident > wanted)
+            {
+                entry.current->upload_next_level(entry.source);
+                staged += entry.source.cooked_levels[resident - 1].size;
+            }
+            else if (wanted > base and (over_budget or entry.coarse_updates > eviction_delay))
+            {
+                entry.next = std::make_unique<texture>(entry.source, entry.format, wanted, wanted);
+                staged += level_bytes(entry.source, wanted);
+                entry.coarse_updates = 0;
+            }
+            else
+            {
+                continue;
+            }
+            entry.ticket    = uploads.current_ticket();
+            entry.uploading = true;
+        }
+        stream_cursor_ = textures_.empty() ? 0 : (stream_cursor_ + 1) % textures_.size();
+    }
+
+    void texture_registry::print_stats() const
+    {
+#ifndef NDEBUG
+        constexpr float mib = 1024.0f * 1024.0f;
+
+        VkDeviceSize memory_size = 0;
+        VkDeviceSize rgba8_size  = 0;
+        uint32_t     streamed    = 0;
+        uint32_t     complete    = 0;
+        for (auto const &entry : textures_)
+        {
+            if (entry.current)
+            {
+                memory_size += entry.current->memory_size();
+                rgba8_size += entry.current->rgba8_size();
+                if (not entry.source.empty())
+                {
+                    ++streamed;
+                    complete += entry.current->resident_level() == 0 ? 1 : 0;
+                }
+            }
+        }
+        std::cout << YELLOW_TEXT("[Textures] ")
+                  << "count: " << textures_.size()
+                  << ONE_TAB << "memory: " << static_cast<float>(memory_size) / mib << " MiB"
+                  << " of " << static_cast<float>(memory_budget) / mib << " MiB"
+                  << ONE_TAB << "as rgba8: " << static_cast<float>(rgba8_size) / mib << " MiB"
+                  << ONE_TAB << "streamed: " << streamed << " (" << complete << " at full resolution)"
+                  << ONE_TAB << "samplers: " << device::instance().samplers().size() << '\n';
+#endif
+    }
+
+    void texture_registry::publish(uint32_t handle, std::unique_ptr<texture> replaced)
+    {
+        if (free_slots_.empty())
+        {
+            throw std::runtime_error{"Bindless texture table has no free slot!"};
+        }
+
+        // A slot off the free list is sampled by no frame in flight, so it can be written while they execute
+        auto const slot = free_slots_.back();
+        free_slots_.pop_back();
+
+        auto const &published = textures_[handle].current;
+        VkDescriptorImageInfo image_info{};
+        image_info.sampler     = published->sampler();
+        image_info.imageView   = published->image_view();
+        image_info.imageLayout = published->image_layout();
+        descriptor_writer(set_layout_.get(), pool_.get())
+            .write_image(0, &image_info, slot)
+            .overwrite(descriptor_set_);
+
+        if (auto const previous = static_cast<uint32_t>(slots_[handle]); previous != debug_texture)
+        {
+            retired_.push_back({previous, frame_, std::move(replaced)});
+        }
+        slots_[handle] = static_cast<int>(slot);
+    }
+
+    auto texture_registry::wanted_level(texture_entry const &entry, uint32_t pixels) const -> uint32_t
+    {
+        // Textures are assumed to span their objects once, so the finest level needed is the coarsest one that
+        // still has as many texels as the objects cover pixels
+        auto const size  = static_cast<uint32_t>(std::max(entry.source.width, entry.source.height));
+        uint32_t   level = 0;
+        while (level < entry.tail_level and (size >> (level + 1)) >= std::max(pixels, 1u))
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    auto texture_registry::level_bytes(image_data const &image, uint32_t level) -> VkDeviceSize
+    {
+        VkDeviceSize size = 0;
+        for (; level < image.cooked_levels.size(); ++level)
+        {
+            size += image.cooked_levels[level].size;
+        }
+        return size;
+    }
+}
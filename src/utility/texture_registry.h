@@ -0,0 +1,159 @@
+﻿#pragma once
+
+// Project includes
+#include "src/engine/job_system.h"
+#include "src/utility/singleton.h"
+#include "src/utility/texture.h"
+#include "src/vulkan/descriptors.h"
+#include "src/vulkan/upload_queue.h"
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GLM includes
+#include <glm/glm.hpp>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Bindless texture table: every texture is loaded once, keyed by asset path and format, and written into one large
+    // sampler2D array that shaders index with the per-object texture indices. The set is bound once per pipeline and
+    // never rewritten for a draw; new textures land in unused slots through update-after-bind.
+    //
+    // load() only reserves a handle; the file is decoded on the job system and turned into an image by update() on
+    // the main thread. resolve() maps handles to slots: the debug texture until the first upload completed, then a
+    // slot of the texture's own. Whenever what a handle samples changes, it moves to a fresh slot and the old one is
+    // reused only after the frames that could still sample it completed, so no slot is written while in use.
+    //
+    // Cooked textures stream: only their smallest levels, up to stream_tail_size, are uploaded with them. Systems
+    // report how many pixels the objects using a texture cover with request(), and update() streams finer levels in,
+    // one per texture and update, until the level that matches is resident. When that level would push the textures
+    // over memory_budget, the largest ones get coarser levels first; images shrink when they are over budget or
+    // have not needed their finest levels for eviction_delay updates.
+    class texture_registry final : public singleton<texture_registry>
+    {
+    public:
+        static constexpr uint32_t max_textures  = 4096;
+        static constexpr uint32_t debug_texture = 0; // slot 0, placeholder and fallback for objects without a texture
+
+        static constexpr uint32_t     stream_tail_size        = 64;
+        static constexpr uint32_t     eviction_delay          = 120;
+        static constexpr VkDeviceSize stream_bytes_per_update = 8 * 1024 * 1024;
+
+        // Device memory for all textures, set before first use
+        static VkDeviceSize memory_budget;
+
+    public:
+        ~texture_registry() override;
+
+        texture_registry(texture_registry const &other)            = delete;
+        texture_registry(texture_registry &&other)                 = delete;
+        texture_registry &operator=(texture_registry const &other) = delete;
+        texture_registry &operator=(texture_registry &&other)      = delete;
+
+        // Returns the handle of the texture, queuing its decode on first use
+        auto load(std::string const &file_path, VkFormat format) -> uint32_t;
+
+        // Thread safe: the objects sampling these handles cover that many pixels on screen this frame
+        void request(int handle, float pixels);
+        void request(glm::ivec4 const &handles, float pixels)
+        {
+            request(handles.x, pixels);
+            request(handles.y, pixels);
+            request(handles.z, pixels);
+            request(handles.w, pixels);
+        }
+
+        // Main thread, once per frame: creates images for decoded files, publishes the uploads that completed and
+        // streams levels in or out for what was requested since the last call
+        void update();
+
+        // Main thread: blocks until every texture loaded so far is decoded and its first levels are published
+        void flush();
+
+        // Texture memory against what the same mip chains would take as uncompressed RGBA8
+        void print_stats() const;
+
+        // Slot to sample for a handle, the placeholder until its texture is ready
+        [[nodiscard]] auto resolve(int handle) const -> int { return slots_[handle]; }
+        [[nodiscard]] auto resolve(glm::ivec4 const &handles) const -> glm::ivec4
+        {
+            return {resolve(handles.x), resolve(handles.y), resolve(handles.z), resolve(handles.w)};
+        }
+
+        [[nodiscard]] auto set_layout() const -> VkDescriptorSetLayout { return set_layout_->get_descriptor_set_layout(); }
+        [[nodiscard]] auto descriptor_set() const -> VkDescriptorSet const & { return descriptor_set_; }
+        [[nodiscard]] auto size() const -> uint32_t { return static_cast<uint32_t>(textures_.size()); }
+
+    private:
+        friend class singleton<texture_registry>;
+        texture_registry();
+
+        struct decoded_texture
+        {
+            uint32_t   handle;
+            VkFormat   format;
+            image_data image;
+        };
+
+        struct texture_entry
+        {
+            std::unique_ptr<texture> current;                       // what the handle's slot samples
+            std::unique_ptr<texture> next;                          // image being uploaded to replace current
+            image_data               source;                        // cooked chain to stream from, empty when fully resident
+            VkFormat                 format         = VK_FORMAT_UNDEFINED;
+            upload_queue::ticket     ticket         = 0;
+            bool                     uploading      = false;        // next, or a level of current
+            uint32_t                 tail_level     = 0;            // finest level uploaded with the texture
+            uint32_t                 wanted_level   = 0;
+            uint32_t                 coarse_updates = 0;            // consecutive updates that wanted a coarser base
+        };
+
+        struct retired_slot
+        {
+            uint32_t                 slot;
+            uint64_t                 frame;
+            std::unique_ptr<texture> replaced; // image the slot sampled, if nothing samples it anymore
+        };
+
+        void process();
+        void complete_uploads();
+        void stream();
+        void publish(uint32_t handle, std::unique_ptr<texture> replaced = nullptr);
+
+        [[nodiscard]] auto wanted_level(texture_entry const &entry, uint32_t pixels) const -> uint32_t;
+
+        // Device memory of the levels from level down to the smallest
+        [[nodiscard]] static auto level_bytes(image_data const &image, uint32_t level) -> VkDeviceSize;
+
+    private:
+        std::mutex mutex_;
+
+        std::unique_ptr<descriptor_set_layout> set_layout_{};
+        std::unique_ptr<descriptor_pool>       pool_{};
+        VkDescriptorSet                        descriptor_set_ = VK_NULL_HANDLE;
+
+        // Indexed by handle and sized or reserved once up front, so systems can read them while recording
+        std::vector<texture_entry>                textures_;
+        std::vector<int>                          slots_;
+        std::unique_ptr<std::atomic<uint32_t>[]>  wanted_pixels_;
+        std::unordered_map<std::string, uint32_t> handles_;
+
+        std::vector<uint32_t>    free_slots_;
+        std::deque<retired_slot> retired_;
+        uint64_t                 frame_         = 0;
+        size_t                   stream_cursor_ = 0;
+
+        job_counter                  decode_counter_;
+        std::vector<decoded_texture> decoded_;
+    };
+}
@@ -54,12 +54,15 @@ namespace dae
     {
         unmap();
         vkDestroyBuffer(device_ptr_->logical_device(), buffer_, nullptr);
-        vkFreeMemory(device_ptr_->logical_device(), memory_, nullptr);
+        device_ptr_->allocator().free(memory_);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible memory blocks stay mapped for as long as the allocator owns them, so this only hands out
+     * the address of the range; it fails for buffers that are not host visible and for ranges outside the buffer.
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -68,29 +71,32 @@ namespace dae
      */
     auto buffer::map(VkDeviceSize size, VkDeviceSize offset) -> VkResult
     {
-        assert(buffer_ and memory_ and "Called map on buffer before create");
-        return vkMapMemory(device_ptr_->logical_device(), memory_, offset, size, 0, &mapped_);
+        assert(buffer_ and memory_.memory and "Called map on buffer before create");
+        if (memory_.mapped == nullptr or offset > buffer_size_ or (size != VK_WHOLE_SIZE and size > buffer_size_ - offset))
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped_      = static_cast<char*>(memory_.mapped) + offset;
+        mapped_size_ = size == VK_WHOLE_SIZE ? buffer_size_ - offset : size;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The underlying block stays mapped, this only forgets the address
      */
     void buffer::unmap()
     {
-        if (mapped_)
-        {
-            vkUnmapMemory(device_ptr_->logical_device(), memory_);
-            mapped_ = nullptr;
-        }
+        mapped_      = nullptr;
+        mapped_size_ = 0;
     }
 
     /**
      * Copies the specified data to the mapped buffer. Default value writes whole buffer range
      *
      * @param data Pointer to the data to copy
-     * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to flush the complete buffer
+     * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to fill the complete mapped
      * range.
      * @param offset (Optional) Byte offset from beginning of mapped region
      *
@@ -101,10 +107,11 @@ namespace dae
 
         if (size == VK_WHOLE_SIZE)
         {
-            memcpy(mapped_, data, buffer_size_);
+            memcpy(mapped_, data, mapped_size_);
         }
         else
         {
+            assert(offset + size <= mapped_size_ and "Write exceeds the mapped range");
             char *mem_offset = (char*)mapped_;
             mem_offset += offset;
             memcpy(mem_offset, data, size);
@@ -124,11 +131,7 @@ namespace dae
      */
     auto buffer::flush(VkDeviceSize size, VkDeviceSize offset) -> VkResult
     {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = memory_;
-        mapped_range.offset = offset;
-        mapped_range.size   = size;
+        VkMappedMemoryRange const mapped_range = device_ptr_->allocator().mapped_range(memory_, size, offset);
         return vkFlushMappedMemoryRanges(device_ptr_->logical_device(), 1, &mapped_range);
     }
 
@@ -145,11 +148,7 @@ namespace dae
      */
     auto buffer::invalidate(VkDeviceSize size, VkDeviceSize offset) -> VkResult
     {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = memory_;
-        mapped_range.offset = offset;
-        mapped_range.size   = size;
+        VkMappedMemoryRange const mapped_range = device_ptr_->allocator().mapped_range(memory_, size, offset);
         return vkInvalidateMappedMemoryRanges(device_ptr_->logical_device(), 1, &mapped_range);
     }
 
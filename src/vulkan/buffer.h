@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+// Project includes
+#include "src/vulkan/memory_allocator.h"
+
 // Vulkan includes
 #include <vulkan/vulkan.h>
 
@@ -47,10 +50,11 @@ namespace dae
     private:
         static auto get_alignment(VkDeviceSize instance_size, VkDeviceSize min_offset_alignment) -> VkDeviceSize;
 
-        device         *device_ptr_ = nullptr;
-        void           *mapped_      = nullptr;
-        VkBuffer       buffer_       = VK_NULL_HANDLE;
-        VkDeviceMemory memory_       = VK_NULL_HANDLE;
+        device            *device_ptr_ = nullptr;
+        void              *mapped_     = nullptr;
+        VkDeviceSize      mapped_size_ = 0;
+        VkBuffer          buffer_      = VK_NULL_HANDLE;
+        memory_allocation memory_      = {};
 
         VkDeviceSize          buffer_size_           = 0;
         uint32_t              instance_count_        = 0;
@@ -21,7 +21,8 @@ namespace dae
         uint32_t binding,
         VkDescriptorType descriptor_type,
         VkShaderStageFlags stage_flags,
-        uint32_t count)
+        uint32_t count,
+        VkDescriptorBindingFlags binding_flags)
     {
         assert(bindings_.count(binding) == 0 and "Binding already in use");
         VkDescriptorSetLayoutBinding layout_binding{};
@@ -30,32 +31,58 @@ namespace dae
         layout_binding.descriptorCount = count;
         layout_binding.stageFlags      = stage_flags;
         bindings_[binding]            = layout_binding;
+        if (binding_flags != 0)
+        {
+            binding_flags_[binding] = binding_flags;
+        }
         return *this;
     }
 
     auto descriptor_set_layout::builder::build() const -> std::unique_ptr<descriptor_set_layout>
     {
-        return std::make_unique<descriptor_set_layout>(bindings_);
+        return std::make_unique<descriptor_set_layout>(bindings_, binding_flags_);
     }
 
     //--------------------------------------------------------------------------------------------------
     // Descriptor Set Layout
     //--------------------------------------------------------------------------------------------------
-    descriptor_set_layout::descriptor_set_layout(std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+    descriptor_set_layout::descriptor_set_layout(
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        std::unordered_map<uint32_t, VkDescriptorBindingFlags> binding_flags)
         : device_ptr_{&device::instance()}
         , bindings_{bindings}
     {
         std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings{};
+        std::vector<VkDescriptorBindingFlags> set_layout_binding_flags{};
         set_layout_bindings.reserve(bindings.size());
+        set_layout_binding_flags.reserve(bindings.size());
+        bool update_after_bind = false;
         for (auto const &[fst, snd] : bindings)
         {
             set_layout_bindings.push_back(snd);
+            auto const flags = binding_flags.contains(fst) ? binding_flags[fst] : 0;
+            set_layout_binding_flags.push_back(flags);
+            update_after_bind = update_after_bind or (flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
         }
 
+        // flags are parallel to pBindings, so they are only chained when at least one binding uses them
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+        binding_flags_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.bindingCount  = static_cast<uint32_t>(set_layout_binding_flags.size());
+        binding_flags_info.pBindingFlags = set_layout_binding_flags.data();
+
         VkDescriptorSetLayoutCreateInfo descriptor_set_layout_info{};
         descriptor_set_layout_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
         descriptor_set_layout_info.bindingCount = static_cast<uint32_t>(set_layout_bindings.size());
         descriptor_set_layout_info.pBindings    = set_layout_bindings.data();
+        if (not binding_flags.empty())
+        {
+            descriptor_set_layout_info.pNext = &binding_flags_info;
+        }
+        if (update_after_bind)
+        {
+            descriptor_set_layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        }
 
         if (vkCreateDescriptorSetLayout(
             device_ptr_->logical_device(),
@@ -187,18 +214,19 @@ namespace dae
         return *this;
     }
 
-    auto descriptor_writer::write_image(uint32_t binding, VkDescriptorImageInfo *image_info) -> descriptor_writer &
+    auto descriptor_writer::write_image(uint32_t binding, VkDescriptorImageInfo *image_info, uint32_t array_element) -> descriptor_writer &
     {
         assert(set_layout_ptr_->bindings_.count(binding) == 1 and "Layout does not contain specified binding");
 
         auto &binding_description = set_layout_ptr_->bindings_[binding];
 
-        assert(binding_description.descriptorCount == 1 and "Binding single descriptor info, but binding expects multiple");
+        assert(array_element < binding_description.descriptorCount and "Array element out of range for binding");
 
         VkWriteDescriptorSet write{};
         write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         write.descriptorType  = binding_description.descriptorType;
         write.dstBinding      = binding;
+        write.dstArrayElement = array_element;
         write.pImageInfo      = image_info;
         write.descriptorCount = 1;
 
@@ -22,19 +22,23 @@ namespace dae
             builder();
 
             auto add_binding(
-                uint32_t           binding,
-                VkDescriptorType   descriptor_type,
-                VkShaderStageFlags stage_flags,
-                uint32_t           count = 1) -> builder &;
+                uint32_t                 binding,
+                VkDescriptorType         descriptor_type,
+                VkShaderStageFlags       stage_flags,
+                uint32_t                 count         = 1,
+                VkDescriptorBindingFlags binding_flags = 0) -> builder &;
 
             [[nodiscard]] auto build() const -> std::unique_ptr<descriptor_set_layout>;
 
         private:
             device *device_ptr_ = nullptr;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings_{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> binding_flags_{};
         };
 
-        explicit descriptor_set_layout(std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+        explicit descriptor_set_layout(
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            std::unordered_map<uint32_t, VkDescriptorBindingFlags> binding_flags = {});
         ~descriptor_set_layout();
         
         descriptor_set_layout(descriptor_set_layout const &other)            = delete;
@@ -101,7 +105,7 @@ namespace dae
         descriptor_writer(descriptor_set_layout *set_layout_ptr, descriptor_pool *pool_ptr);
 
         auto write_buffer(uint32_t binding, VkDescriptorBufferInfo *buffer_info) -> descriptor_writer &;
-        auto write_image(uint32_t binding, VkDescriptorImageInfo *image_info) -> descriptor_writer &;
+        auto write_image(uint32_t binding, VkDescriptorImageInfo *image_info, uint32_t array_element = 0) -> descriptor_writer &;
 
         bool build(VkDescriptorSet &set);
         void overwrite(VkDescriptorSet &set);
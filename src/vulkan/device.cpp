@@ -1,17 +1,75 @@
 ﻿#include "device.h"
 
 // Project includes
+#include "src/engine/engine.h"
 #include "src/engine/window.h"
 #include "src/utility/utils.h"
 
 // Standard includes
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
 
+#if defined(CMAKE_BUILD)
+#ifndef ENGINE_DIR
+#define ENGINE_DIR "../../../"
+#endif
+#else
+#ifndef ENGINE_DIR
+#define ENGINE_DIR ""
+#endif
+#endif
+
 namespace dae
 {
+    namespace
+    {
+        // Prepended to the driver's cache blob. The blob's own header already carries vendor/device id and the
+        // pipeline cache UUID, but drivers differ in how carefully they check it, so it is validated here as well,
+        // together with the driver version and a checksum against truncated or corrupted files.
+        struct pipeline_cache_header
+        {
+            char     magic[4]       = {'D', 'A', 'E', 'P'};
+            uint32_t version        = 1;
+            uint32_t vendor_id      = 0;
+            uint32_t device_id      = 0;
+            uint32_t driver_version = 0;
+            uint8_t  uuid[VK_UUID_SIZE]{};
+            uint64_t data_size      = 0;
+            uint64_t data_hash      = 0;
+        };
+
+        auto pipeline_cache_path() -> std::string
+        {
+            return ENGINE_DIR + engine::data_path + "pipeline.cache";
+        }
+
+        // FNV-1a
+        auto hash_bytes(char const *data, size_t size) -> uint64_t
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= static_cast<uint8_t>(data[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        auto make_pipeline_cache_header(VkPhysicalDeviceProperties const &properties) -> pipeline_cache_header
+        {
+            pipeline_cache_header header{};
+            header.vendor_id      = properties.vendorID;
+            header.device_id      = properties.deviceID;
+            header.driver_version = properties.driverVersion;
+            std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+            return header;
+        }
+    }
+
     // local callback functions
     static auto VKAPI_CALL debug_callback(
         VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
@@ -55,7 +113,12 @@ namespace dae
 
     device::~device()
     {
+        save_pipeline_cache();
+        vkDestroyPipelineCache(device_, pipeline_cache_, nullptr);
         vkDestroyCommandPool(device_, command_pool_, nullptr);
+        vkDestroyCommandPool(device_, transfer_command_pool_, nullptr);
+        samplers_.reset();
+        allocator_.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enable_validation_layers)
@@ -75,7 +138,10 @@ namespace dae
         create_surface();
         pick_physical_device();
         create_logical_device();
+        allocator_ = std::make_unique<memory_allocator>(device_, physical_device_);
+        samplers_  = std::make_unique<sampler_cache>(device_);
         create_command_pool();
+        create_pipeline_cache();
     }
 
     void device::create_instance()
@@ -91,7 +157,7 @@ namespace dae
         app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         app_info.pEngineName        = "No Engine";
         app_info.engineVersion      = VK_MAKE_VERSION(1, 0, 0);
-        app_info.apiVersion         = VK_API_VERSION_1_0;
+        app_info.apiVersion         = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo create_info = {};
         create_info.sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -160,7 +226,7 @@ namespace dae
         queue_family_indices indices = find_queue_families(physical_device_);
 
         std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-        std::set<uint32_t> unique_queue_families = {indices.graphics_family, indices.present_family};
+        std::set<uint32_t> unique_queue_families = {indices.graphics_family, indices.present_family, indices.transfer_family};
 
         float queuePriority = 1.0f;
         for (uint32_t queue_family : unique_queue_families)
@@ -173,11 +239,38 @@ namespace dae
             queue_create_infos.push_back(queue_create_info);
         }
 
+        VkPhysicalDeviceFeatures supported_features = {};
+        vkGetPhysicalDeviceFeatures(physical_device_, &supported_features);
+
+        // block-compressed textures are optional, texture falls back to uncompressed sources without them
         VkPhysicalDeviceFeatures device_features = {};
-        device_features.samplerAnisotropy = VK_TRUE;
+        device_features.samplerAnisotropy    = VK_TRUE;
+        device_features.textureCompressionBC = supported_features.textureCompressionBC;
+
+        // GPU-driven culling draws through indirect commands with a count written on the device; optional as well
+        VkPhysicalDeviceVulkan12Features supported_12_features = {};
+        supported_12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supported_features_2 = {};
+        supported_features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supported_features_2.pNext = &supported_12_features;
+        vkGetPhysicalDeviceFeatures2(physical_device_, &supported_features_2);
+        draw_indirect_count_ = supported_features.multiDrawIndirect and supported_12_features.drawIndirectCount;
+        device_features.multiDrawIndirect = draw_indirect_count_ ? VK_TRUE : VK_FALSE;
+
+        // descriptor indexing for the bindless texture table
+        VkPhysicalDeviceVulkan12Features vulkan_12_features = {};
+        vulkan_12_features.sType                                        = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan_12_features.descriptorIndexing                           = VK_TRUE;
+        vulkan_12_features.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+        vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan_12_features.descriptorBindingUpdateUnusedWhilePending    = VK_TRUE;
+        vulkan_12_features.descriptorBindingPartiallyBound              = VK_TRUE;
+        vulkan_12_features.runtimeDescriptorArray                       = VK_TRUE;
+        vulkan_12_features.drawIndirectCount                            = draw_indirect_count_ ? VK_TRUE : VK_FALSE;
 
         VkDeviceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        create_info.pNext = &vulkan_12_features;
 
         create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
         create_info.pQueueCreateInfos    = queue_create_infos.data();
@@ -200,9 +293,11 @@ namespace dae
         {
             throw std::runtime_error("failed to create logical device!");
         }
+        enabled_features_ = device_features;
 
         vkGetDeviceQueue(device_, indices.graphics_family, 0, &graphics_queue_);
         vkGetDeviceQueue(device_, indices.present_family, 0, &present_queue_);
+        vkGetDeviceQueue(device_, indices.transfer_family, 0, &transfer_queue_);
     }
 
     void device::create_command_pool()
@@ -218,6 +313,113 @@ namespace dae
         {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        pool_info.queueFamilyIndex = queue_family_indices.transfer_family;
+        if (vkCreateCommandPool(device_, &pool_info, nullptr, &transfer_command_pool_) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create transfer command pool!");
+        }
+    }
+
+    void device::create_pipeline_cache()
+    {
+        // Reuse the blob from the previous run only if it was written by this exact device and driver
+        std::vector<char> data{};
+        if (std::ifstream file{pipeline_cache_path(), std::ios::binary}; file)
+        {
+            pipeline_cache_header header{};
+            pipeline_cache_header const expected = make_pipeline_cache_header(properties);
+            file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+            // the blob must fill the rest of the file exactly; a truncated or padded file is not trusted to size a read
+            std::error_code error{};
+            auto const file_size = std::filesystem::file_size(pipeline_cache_path(), error);
+            bool const matches = file
+                and not error
+                and file_size >= sizeof(header)
+                and header.data_size == file_size - sizeof(header)
+                and std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0
+                and header.version == expected.version
+                and header.vendor_id == expected.vendor_id
+                and header.device_id == expected.device_id
+                and header.driver_version == expected.driver_version
+                and std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) == 0;
+            if (matches)
+            {
+                data.resize(header.data_size);
+                file.read(data.data(), static_cast<std::streamsize>(data.size()));
+                if (not file or hash_bytes(data.data(), data.size()) != header.data_hash)
+                {
+                    data.clear();
+                }
+            }
+#ifndef NDEBUG
+            if (data.empty())
+            {
+                std::cout << YELLOW_TEXT("[Pipeline Cache] ") << "Discarding stale or corrupt " << pipeline_cache_path() << '\n';
+            }
+#endif
+        }
+
+        VkPipelineCacheCreateInfo cache_info{};
+        cache_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cache_info.initialDataSize = data.size();
+        cache_info.pInitialData    = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(device_, &cache_info, nullptr, &pipeline_cache_) != VK_SUCCESS)
+        {
+            // the driver may still reject data it does not like; fall back to an empty cache
+            cache_info.initialDataSize = 0;
+            cache_info.pInitialData    = nullptr;
+            data.clear();
+            if (vkCreatePipelineCache(device_, &cache_info, nullptr, &pipeline_cache_) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+        }
+        pipeline_cache_warm_ = not data.empty();
+    }
+
+    void device::save_pipeline_cache()
+    {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device_, pipeline_cache_, &size, nullptr) != VK_SUCCESS or size == 0)
+        {
+            return;
+        }
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device_, pipeline_cache_, &size, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+        data.resize(size);
+
+        pipeline_cache_header header = make_pipeline_cache_header(properties);
+        header.data_size = data.size();
+        header.data_hash = hash_bytes(data.data(), data.size());
+
+        // Write to a temporary file first so a crash never leaves a truncated cache behind
+        std::string const path      = pipeline_cache_path();
+        std::string const temp_path = path + ".tmp";
+        {
+            std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+            if (not file)
+            {
+                return;
+            }
+            file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (not file)
+            {
+                return;
+            }
+        }
+        std::error_code error{};
+        std::filesystem::rename(temp_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+        }
     }
 
     void device::create_surface() { window_ptr_->create_window_surface(instance_, &surface_); }
@@ -235,11 +437,24 @@ namespace dae
             swap_chain_adequate = !swap_chain_support.formats.empty() and !swap_chain_support.present_modes.empty();
         }
 
-        VkPhysicalDeviceFeatures supported_features;
-        vkGetPhysicalDeviceFeatures(device, &supported_features);
+        VkPhysicalDeviceVulkan12Features vulkan_12_features = {};
+        vulkan_12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+        VkPhysicalDeviceFeatures2 supported_features = {};
+        supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supported_features.pNext = &vulkan_12_features;
+        vkGetPhysicalDeviceFeatures2(device, &supported_features);
+
+        bool const descriptor_indexing_supported =
+            vulkan_12_features.descriptorIndexing and
+            vulkan_12_features.shaderSampledImageArrayNonUniformIndexing and
+            vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind and
+            vulkan_12_features.descriptorBindingUpdateUnusedWhilePending and
+            vulkan_12_features.descriptorBindingPartiallyBound and
+            vulkan_12_features.runtimeDescriptorArray;
 
         return indices.is_complete() and extensions_supported and swap_chain_adequate and
-            supported_features.samplerAnisotropy;
+            supported_features.features.samplerAnisotropy and descriptor_indexing_supported;
     }
 
     void device::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT &create_info)
@@ -392,6 +607,22 @@ namespace dae
             i++;
         }
 
+        for (uint32_t family = 0; family < queue_family_count; ++family)
+        {
+            VkQueueFlags const flags = queue_families[family].queueFlags;
+            if (queue_families[family].queueCount > 0 and (flags & VK_QUEUE_TRANSFER_BIT) and not (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                indices.transfer_family           = family;
+                indices.transfer_family_has_value = true;
+                break;
+            }
+        }
+        if (not indices.transfer_family_has_value)
+        {
+            indices.transfer_family           = indices.graphics_family;
+            indices.transfer_family_has_value = indices.graphics_family_has_value;
+        }
+
         return indices;
     }
 
@@ -463,7 +694,7 @@ namespace dae
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &buffer_memory)
+        memory_allocation &buffer_memory)
     {
         VkBufferCreateInfo buffer_info{};
         buffer_info.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -479,17 +710,8 @@ namespace dae
         VkMemoryRequirements mem_requirements;
         vkGetBufferMemoryRequirements(device_, buffer, &mem_requirements);
 
-        VkMemoryAllocateInfo alloc_info{};
-        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        alloc_info.allocationSize  = mem_requirements.size;
-        alloc_info.memoryTypeIndex = find_memory_type(mem_requirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &alloc_info, nullptr, &buffer_memory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(device_, buffer, buffer_memory, 0);
+        buffer_memory = allocator_->allocate(mem_requirements, properties, true);
+        vkBindBufferMemory(device_, buffer, buffer_memory.memory, buffer_memory.offset);
     }
 
     auto device::begin_single_time_commands() -> VkCommandBuffer
@@ -571,7 +793,7 @@ namespace dae
         VkImageCreateInfo const &image_info,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &image_memory)
+        memory_allocation &image_memory)
     {
         if (vkCreateImage(device_, &image_info, nullptr, &image) != VK_SUCCESS)
         {
@@ -581,17 +803,8 @@ namespace dae
         VkMemoryRequirements mem_requirements;
         vkGetImageMemoryRequirements(device_, image, &mem_requirements);
 
-        VkMemoryAllocateInfo alloc_info{};
-        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        alloc_info.allocationSize  = mem_requirements.size;
-        alloc_info.memoryTypeIndex = find_memory_type(mem_requirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &alloc_info, nullptr, &image_memory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, image_memory, 0) != VK_SUCCESS)
+        image_memory = allocator_->allocate(mem_requirements, properties, image_info.tiling == VK_IMAGE_TILING_LINEAR);
+        if (vkBindImageMemory(device_, image, image_memory.memory, image_memory.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
         }
@@ -2,8 +2,11 @@
 
 // Project includes
 #include "src/utility/singleton.h"
+#include "src/vulkan/memory_allocator.h"
+#include "src/vulkan/sampler_cache.h"
 
 // std lib headers
+#include <memory>
 #include <vector>
 
 // vulkan headers
@@ -25,10 +28,16 @@ namespace dae
     {
         uint32_t graphics_family;
         uint32_t present_family;
+        uint32_t transfer_family;
         bool     graphics_family_has_value = false;
         bool     present_family_has_value  = false;
+        bool     transfer_family_has_value = false;
         
         [[nodiscard]] auto is_complete() const -> bool { return graphics_family_has_value and present_family_has_value; }
+
+        // A family with transfer but no graphics or compute support; these map to the GPU's copy engines. Without
+        // one, transfer_family is the graphics family.
+        [[nodiscard]] auto has_dedicated_transfer() const -> bool { return transfer_family != graphics_family; }
     };
 
     class device final : public singleton<device>
@@ -49,11 +58,19 @@ namespace dae
         device &operator=(device &&other)      = delete;
 
         [[nodiscard]] auto command_pool() const -> VkCommandPool { return command_pool_; }
+        [[nodiscard]] auto transfer_command_pool() const -> VkCommandPool { return transfer_command_pool_; }
+        [[nodiscard]] auto pipeline_cache() const -> VkPipelineCache { return pipeline_cache_; }
+        [[nodiscard]] auto is_pipeline_cache_warm() const -> bool { return pipeline_cache_warm_; }
+        [[nodiscard]] auto allocator() const -> memory_allocator & { return *allocator_; }
+        [[nodiscard]] auto samplers() const -> sampler_cache & { return *samplers_; }
         [[nodiscard]] auto logical_device() const -> VkDevice { return device_; }
         [[nodiscard]] auto physical_device() const -> VkPhysicalDevice { return physical_device_; }
         [[nodiscard]] auto surface() const -> VkSurfaceKHR { return surface_; }
         [[nodiscard]] auto graphics_queue() const -> VkQueue { return graphics_queue_; }
         [[nodiscard]] auto present_queue() const -> VkQueue { return present_queue_; }
+        [[nodiscard]] auto transfer_queue() const -> VkQueue { return transfer_queue_; }
+        [[nodiscard]] auto enabled_features() const -> VkPhysicalDeviceFeatures const & { return enabled_features_; }
+        [[nodiscard]] auto supports_draw_indirect_count() const -> bool { return draw_indirect_count_; }
 
         auto get_swap_chain_support() -> swap_chain_support_details { return query_swap_chain_support(physical_device_); }
         auto find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) -> uint32_t;
@@ -66,7 +83,7 @@ namespace dae
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &buffer_memory);
+            memory_allocation &buffer_memory);
         auto begin_single_time_commands() -> VkCommandBuffer;
         void end_single_time_commands(VkCommandBuffer command_buffer);
         void copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
@@ -76,7 +93,7 @@ namespace dae
             VkImageCreateInfo const &image_info,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &image_memory);
+            memory_allocation &image_memory);
 
         VkPhysicalDeviceProperties properties;
 
@@ -91,6 +108,8 @@ namespace dae
         void pick_physical_device();
         void create_logical_device();
         void create_command_pool();
+        void create_pipeline_cache();
+        void save_pipeline_cache();
 
         // helper functions
         auto is_device_suitable(VkPhysicalDevice device) -> bool;
@@ -107,11 +126,21 @@ namespace dae
         VkPhysicalDevice         physical_device_ = VK_NULL_HANDLE;
         window                   *window_ptr_     = nullptr;
         VkCommandPool            command_pool_    = VK_NULL_HANDLE;
+        VkCommandPool            transfer_command_pool_ = VK_NULL_HANDLE;
+        VkPipelineCache          pipeline_cache_  = VK_NULL_HANDLE;
+        bool                     pipeline_cache_warm_ = false;
+
+        std::unique_ptr<memory_allocator> allocator_;
+        std::unique_ptr<sampler_cache>    samplers_;
+
+        VkPhysicalDeviceFeatures enabled_features_    = {};
+        bool                     draw_indirect_count_ = false;
 
         VkDevice     device_         = VK_NULL_HANDLE;
         VkSurfaceKHR surface_        = VK_NULL_HANDLE;
         VkQueue      graphics_queue_ = VK_NULL_HANDLE;
         VkQueue      present_queue_  = VK_NULL_HANDLE;
+        VkQueue      transfer_queue_ = VK_NULL_HANDLE;
 
         const std::vector<const char*> validation_layers_ = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char*> device_extensions_ = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
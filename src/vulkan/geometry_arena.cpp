@@ -0,0 +1,157 @@
+﻿#include "geometry_arena.h"
+
+// Project includes
+#include "src/core/model.h"
+#include "src/utility/utils.h"
+#include "src/vulkan/buffer.h"
+#include "src/vulkan/swap_chain.h"
+#include "src/vulkan/upload_queue.h"
+
+// Standard includes
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace dae
+{
+    uint32_t geometry_arena::vertex_capacity = 1u << 20;
+    uint32_t geometry_arena::index_capacity  = 1u << 22;
+
+    geometry_arena::geometry_arena()
+        : vertex_ranges_{vertex_capacity, 1}
+        , index_ranges_{index_capacity, 1}
+    {
+        vertex_buffer_ = std::make_unique<buffer>(
+            sizeof(model::packed_vertex),
+            vertex_capacity,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+        index_buffer_ = std::make_unique<buffer>(
+            sizeof(index_type),
+            index_capacity,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        );
+    }
+
+    geometry_arena::~geometry_arena()
+    {
+        // Destroyed after the device went idle, so whatever is still retired can go
+        for (auto const &retired : retired_)
+        {
+            retired.ranges->free(retired.node);
+            --range_count_;
+        }
+#ifndef NDEBUG
+        if (range_count_ > 0)
+        {
+            std::cout << RED_TEXT("[Geometry] ") << "arena destroyed with " << range_count_ << " ranges still allocated\n";
+        }
+#endif
+    }
+
+    auto geometry_arena::allocate_vertices(void const *vertices, uint32_t count) -> range
+    {
+        auto const vertices_range = allocate(vertex_ranges_, count, "vertices");
+        upload_queue::instance().upload_to_buffer(
+            vertex_buffer_->get_buffer(), vertices, VkDeviceSize{count} * sizeof(model::packed_vertex), VkDeviceSize{vertices_range.first} * sizeof(model::packed_vertex));
+        return vertices_range;
+    }
+
+    auto geometry_arena::allocate_indices(index_type const *indices, uint32_t count) -> range
+    {
+        auto const indices_range = allocate(index_ranges_, count, "indices");
+        upload_queue::instance().upload_to_buffer(
+            index_buffer_->get_buffer(), indices, VkDeviceSize{count} * sizeof(index_type), VkDeviceSize{indices_range.first} * sizeof(index_type));
+        return indices_range;
+    }
+
+    void geometry_arena::free_vertices(range &vertices)
+    {
+        retire(vertex_ranges_, vertices);
+    }
+
+    void geometry_arena::free_indices(range &indices)
+    {
+        retire(index_ranges_, indices);
+    }
+
+    void geometry_arena::update()
+    {
+        // Ranges retired MAX_FRAMES_IN_FLIGHT updates ago are drawn from by no frame in flight anymore
+        std::lock_guard lock{mutex_};
+        ++frame_;
+        while (not retired_.empty() and retired_.front().frame + swap_chain::MAX_FRAMES_IN_FLIGHT <= frame_)
+        {
+            retired_.front().ranges->free(retired_.front().node);
+            --range_count_;
+            retired_.pop_front();
+        }
+    }
+
+    void geometry_arena::bind(VkCommandBuffer command_buffer) const
+    {
+        VkBuffer     buffers[] = {vertex_buffer_->get_buffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(command_buffer, index_buffer_->get_buffer(), 0, vk_index_type);
+    }
+
+    auto geometry_arena::vertex_buffer() const -> VkBuffer
+    {
+        return vertex_buffer_->get_buffer();
+    }
+
+    auto geometry_arena::index_buffer() const -> VkBuffer
+    {
+        return index_buffer_->get_buffer();
+    }
+
+    auto geometry_arena::stats() const -> statistics
+    {
+        std::lock_guard lock{mutex_};
+        statistics stats{};
+        stats.vertices_used         = vertex_capacity - static_cast<uint32_t>(vertex_ranges_.free_bytes());
+        stats.indices_used          = index_capacity - static_cast<uint32_t>(index_ranges_.free_bytes());
+        stats.largest_free_vertices = static_cast<uint32_t>(vertex_ranges_.largest_free());
+        stats.largest_free_indices  = static_cast<uint32_t>(index_ranges_.largest_free());
+        stats.range_count           = range_count_;
+        return stats;
+    }
+
+    void geometry_arena::print_stats() const
+    {
+#ifndef NDEBUG
+        auto const s = stats();
+        std::cout << YELLOW_TEXT("[Geometry] ")
+                  << "vertices: " << s.vertices_used << " of " << vertex_capacity << " (" << sizeof(model::packed_vertex) << " bytes each)"
+                  << ONE_TAB << "indices: " << s.indices_used << " of " << index_capacity
+                  << ONE_TAB << "ranges: " << s.range_count << '\n';
+#endif
+    }
+
+    auto geometry_arena::allocate(tlsf &ranges, uint32_t count, char const *kind) -> range
+    {
+        std::lock_guard lock{mutex_};
+        VkDeviceSize offset = 0;
+        uint32_t const node = ranges.allocate(count, 1, offset);
+        if (node == tlsf::invalid_node)
+        {
+            throw std::runtime_error{std::string{"Geometry arena is out of "} + kind + ", raise its capacity"};
+        }
+        ++range_count_;
+        return {static_cast<uint32_t>(offset), count, node};
+    }
+
+    void geometry_arena::retire(tlsf &ranges, range &retired)
+    {
+        std::lock_guard lock{mutex_};
+        if (retired.node != tlsf::invalid_node)
+        {
+            retired_.push_back({&ranges, retired.node, frame_});
+        }
+        retired = {};
+    }
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+// Project includes
+#include "src/utility/singleton.h"
+#include "src/vulkan/tlsf.h"
+
+// Standard includes
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class buffer;
+
+    // One device local vertex buffer and one index buffer shared by every model, so a whole pipeline's draws need a
+    // single bind() and a model is nothing but ranges inside them: indexed draws pass the index range as firstIndex and
+    // the vertex range as vertexOffset, which is also what indirect commands need to draw many models from one call.
+    // Ranges come from a tlsf allocator counted in elements rather than bytes, so they are always whole vertices and
+    // indices, and freed ranges coalesce with their neighbours. Data reaches the buffers through the upload queue.
+    class geometry_arena final : public singleton<geometry_arena>
+    {
+    public:
+        struct range
+        {
+            uint32_t first = 0;
+            uint32_t count = 0;
+            uint32_t node  = tlsf::invalid_node;
+        };
+
+        struct statistics
+        {
+            uint32_t vertices_used         = 0;
+            uint32_t indices_used          = 0;
+            uint32_t largest_free_vertices = 0;
+            uint32_t largest_free_indices  = 0;
+            uint32_t range_count           = 0;
+        };
+
+        // Indices are relative to each draw's vertexOffset, so 16 bits cover any mesh once the builder splits the large
+        // ones into submeshes; a single index type keeps one bind and one indirect draw per pipeline
+        using index_type = uint16_t;
+        static constexpr VkIndexType vk_index_type = VK_INDEX_TYPE_UINT16;
+
+        // Capacities in elements, set before first use
+        static uint32_t vertex_capacity;
+        static uint32_t index_capacity;
+
+        ~geometry_arena() override;
+
+        geometry_arena(geometry_arena const &other)            = delete;
+        geometry_arena(geometry_arena &&other)                 = delete;
+        geometry_arena &operator=(geometry_arena const &other) = delete;
+        geometry_arena &operator=(geometry_arena &&other)      = delete;
+
+        // Claim a range and queue the upload of its data, which may be freed on return
+        auto allocate_vertices(void const *vertices, uint32_t count) -> range;
+        auto allocate_indices(index_type const *indices, uint32_t count) -> range;
+
+        // Frames in flight may still draw from the range, so it is only released by the update() MAX_FRAMES_IN_FLIGHT
+        // frames later; until then the range cannot be handed out and overwritten
+        void free_vertices(range &vertices);
+        void free_indices(range &indices);
+
+        // Main thread, once per frame after the renderer waited for the frame that used this frame's resources last time
+        void update();
+
+        void bind(VkCommandBuffer command_buffer) const;
+
+        [[nodiscard]] auto vertex_buffer() const -> VkBuffer;
+        [[nodiscard]] auto index_buffer() const -> VkBuffer;
+        [[nodiscard]] auto stats() const -> statistics;
+        void print_stats() const;
+
+    private:
+        friend class singleton<geometry_arena>;
+        geometry_arena();
+
+        struct retired_range
+        {
+            tlsf     *ranges;
+            uint32_t  node;
+            uint64_t  frame;
+        };
+
+        auto allocate(tlsf &ranges, uint32_t count, char const *kind) -> range;
+        void retire(tlsf &ranges, range &retired);
+
+        std::unique_ptr<buffer> vertex_buffer_;
+        std::unique_ptr<buffer> index_buffer_;
+        tlsf                    vertex_ranges_;
+        tlsf                    index_ranges_;
+        uint32_t                range_count_ = 0;
+        mutable std::mutex      mutex_;
+
+        std::deque<retired_range> retired_;
+        uint64_t                  frame_ = 0;
+    };
+}
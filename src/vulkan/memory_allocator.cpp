@@ -0,0 +1,317 @@
+﻿#include "memory_allocator.h"
+
+// Project includes
+#include "src/utility/utils.h"
+#include "src/vulkan/tlsf.h"
+
+// Standard includes
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace dae
+{
+    namespace
+    {
+        auto align_up(VkDeviceSize value, VkDeviceSize alignment) -> VkDeviceSize
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        auto align_down(VkDeviceSize value, VkDeviceSize alignment) -> VkDeviceSize
+        {
+            return value / alignment * alignment;
+        }
+    }
+
+    memory_allocator::memory_allocator(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize block_size)
+        : device_{device}
+        , block_size_{block_size}
+    {
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties_);
+
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(physical_device, &properties);
+        buffer_image_granularity_ = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+        non_coherent_atom_size_   = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    }
+
+    memory_allocator::~memory_allocator()
+    {
+#ifndef NDEBUG
+        if (bytes_used_ > 0)
+        {
+            std::cout << RED_TEXT("[Memory] ") << "allocator destroyed with " << bytes_used_ << " bytes still allocated\n";
+        }
+#endif
+        for (uint32_t i = 0; i < blocks_.size(); ++i)
+        {
+            destroy_block(i);
+        }
+    }
+
+    auto memory_allocator::allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags properties, bool linear) -> memory_allocation
+    {
+        uint32_t const              memory_type = find_memory_type(requirements.memoryTypeBits, properties);
+        VkMemoryPropertyFlags const type_flags  = memory_properties_.memoryTypes[memory_type].propertyFlags;
+
+        // Flushes are widened to nonCoherentAtomSize, which must never reach into a neighbouring allocation
+        bool const   non_coherent = (type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) and not (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkDeviceSize alignment    = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size         = requirements.size;
+        if (non_coherent)
+        {
+            alignment = std::max(alignment, non_coherent_atom_size_);
+            size      = align_up(size, non_coherent_atom_size_);
+        }
+
+        // With a granularity of one there is nothing to keep apart
+        linear = linear and buffer_image_granularity_ > 1;
+
+        std::lock_guard lock{mutex_};
+
+        memory_allocation allocation{};
+        allocation.size = requirements.size;
+
+        VkDeviceSize const block_size = block_size_for(memory_type);
+        if (size <= block_size / 2)
+        {
+            for (uint32_t i = 0; i < blocks_.size(); ++i)
+            {
+                block *block_ptr = blocks_[i].get();
+                if (block_ptr == nullptr or block_ptr->dedicated or block_ptr->memory_type != memory_type or block_ptr->linear != linear)
+                {
+                    continue;
+                }
+
+                VkDeviceSize   offset = 0;
+                uint32_t const node   = block_ptr->ranges->allocate(size, alignment, offset);
+                if (node != tlsf::invalid_node)
+                {
+                    allocation.block_index = i;
+                    allocation.node_index  = node;
+                    allocation.offset      = offset;
+                    break;
+                }
+            }
+
+            if (allocation.block_index == UINT32_MAX)
+            {
+                uint32_t const i = create_block(memory_type, block_size, linear, false);
+                if (i != UINT32_MAX)
+                {
+                    VkDeviceSize offset = 0;
+                    allocation.node_index  = blocks_[i]->ranges->allocate(size, alignment, offset);
+                    allocation.block_index = i;
+                    allocation.offset      = offset;
+                    assert(allocation.node_index != tlsf::invalid_node and "Fresh block cannot hold allocation");
+                }
+            }
+        }
+
+        // Too large for a block, or the heap cannot fit another full block: give the resource its own memory
+        if (allocation.block_index == UINT32_MAX)
+        {
+            uint32_t const i = create_block(memory_type, size, linear, true);
+            if (i == UINT32_MAX)
+            {
+                throw std::runtime_error{"Failed to allocate device memory!"};
+            }
+            allocation.block_index = i;
+            allocation.offset      = 0;
+        }
+
+        block &owner = *blocks_[allocation.block_index];
+        ++owner.allocation_count;
+        allocation.memory = owner.memory;
+        allocation.mapped = owner.mapped ? owner.mapped + allocation.offset : nullptr;
+        bytes_used_ += allocation.size;
+        return allocation;
+    }
+
+    void memory_allocator::free(memory_allocation &allocation)
+    {
+        if (allocation.memory == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        std::lock_guard lock{mutex_};
+
+        assert(allocation.block_index < blocks_.size() and blocks_[allocation.block_index] and "Allocation does not belong to this allocator");
+        block &owner = *blocks_[allocation.block_index];
+        bytes_used_ -= allocation.size;
+        --owner.allocation_count;
+
+        if (owner.dedicated)
+        {
+            destroy_block(allocation.block_index);
+        }
+        else
+        {
+            owner.ranges->free(allocation.node_index);
+
+            // Keep one empty block per memory type around, so a resource that is recreated every so often (depth
+            // buffers on resize) does not cost a vkAllocateMemory each time
+            if (owner.allocation_count == 0)
+            {
+                for (uint32_t i = 0; i < blocks_.size(); ++i)
+                {
+                    block const *other = blocks_[i].get();
+                    if (i != allocation.block_index and other and not other->dedicated and other->allocation_count == 0
+                        and other->memory_type == owner.memory_type and other->linear == owner.linear)
+                    {
+                        destroy_block(allocation.block_index);
+                        break;
+                    }
+                }
+            }
+        }
+
+        allocation = memory_allocation{};
+    }
+
+    auto memory_allocator::mapped_range(memory_allocation const &allocation, VkDeviceSize size, VkDeviceSize offset) const -> VkMappedMemoryRange
+    {
+        VkDeviceSize block_size;
+        {
+            std::lock_guard lock{mutex_};
+            block_size = blocks_[allocation.block_index]->size;
+        }
+
+        VkDeviceSize const begin = allocation.offset + offset;
+        VkDeviceSize const end   = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+        VkMappedMemoryRange range{};
+        range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = align_down(begin, non_coherent_atom_size_);
+        range.size   = std::min(align_up(end, non_coherent_atom_size_), block_size) - range.offset;
+        return range;
+    }
+
+    auto memory_allocator::stats() const -> statistics
+    {
+        std::lock_guard lock{mutex_};
+
+        statistics result{};
+        result.bytes_used = bytes_used_;
+
+        VkDeviceSize free_bytes          = 0;
+        VkDeviceSize largest_free_ranges = 0;
+        for (auto const &block_ptr : blocks_)
+        {
+            if (not block_ptr)
+            {
+                continue;
+            }
+            ++result.block_count;
+            result.allocation_count += block_ptr->allocation_count;
+            result.bytes_reserved   += block_ptr->size;
+            if (block_ptr->ranges)
+            {
+                VkDeviceSize const largest = block_ptr->ranges->largest_free();
+                free_bytes          += block_ptr->ranges->free_bytes();
+                largest_free_ranges += largest;
+                result.largest_free  = std::max(result.largest_free, largest);
+            }
+        }
+        if (free_bytes > 0)
+        {
+            result.fragmentation = 1.0f - static_cast<float>(largest_free_ranges) / static_cast<float>(free_bytes);
+        }
+        return result;
+    }
+
+    void memory_allocator::print_stats() const
+    {
+#ifndef NDEBUG
+        constexpr float mib = 1024.0f * 1024.0f;
+
+        auto const s = stats();
+        std::cout << YELLOW_TEXT("[Memory] ")
+                  << "used: " << static_cast<float>(s.bytes_used) / mib << " MiB"
+                  << ONE_TAB << "reserved: " << static_cast<float>(s.bytes_reserved) / mib << " MiB"
+                  << ONE_TAB << "blocks: " << s.block_count
+                  << ONE_TAB << "allocations: " << s.allocation_count
+                  << ONE_TAB << "fragmentation: " << s.fragmentation * 100.0f << " %\n";
+#endif
+    }
+
+    auto memory_allocator::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const -> uint32_t
+    {
+        for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i)
+        {
+            if ((type_filter & (1 << i)) and (memory_properties_.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error{"Failed to find suitable memory type!"};
+    }
+
+    // Small heaps (e.g. the 256 MiB host visible device local window) would be exhausted by a handful of full blocks
+    auto memory_allocator::block_size_for(uint32_t memory_type) const -> VkDeviceSize
+    {
+        VkDeviceSize const heap_size = memory_properties_.memoryHeaps[memory_properties_.memoryTypes[memory_type].heapIndex].size;
+        return align_down(std::min(block_size_, heap_size / 8), 256);
+    }
+
+    auto memory_allocator::create_block(uint32_t memory_type, VkDeviceSize size, bool linear, bool dedicated) -> uint32_t
+    {
+        VkMemoryAllocateInfo alloc_info{};
+        alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize  = size;
+        alloc_info.memoryTypeIndex = memory_type;
+
+        auto new_block = std::make_unique<block>();
+        if (vkAllocateMemory(device_, &alloc_info, nullptr, &new_block->memory) != VK_SUCCESS)
+        {
+            return UINT32_MAX;
+        }
+        new_block->size        = size;
+        new_block->memory_type = memory_type;
+        new_block->linear      = linear;
+        new_block->dedicated   = dedicated;
+        if (not dedicated)
+        {
+            new_block->ranges = std::make_unique<tlsf>(size, range_granularity);
+        }
+        if (memory_properties_.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            void *mapped = nullptr;
+            if (vkMapMemory(device_, new_block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+            {
+                vkFreeMemory(device_, new_block->memory, nullptr);
+                throw std::runtime_error{"Failed to map device memory block!"};
+            }
+            new_block->mapped = static_cast<char*>(mapped);
+        }
+
+        auto const empty_slot = std::find(blocks_.begin(), blocks_.end(), nullptr);
+        if (empty_slot != blocks_.end())
+        {
+            *empty_slot = std::move(new_block);
+            return static_cast<uint32_t>(empty_slot - blocks_.begin());
+        }
+        blocks_.push_back(std::move(new_block));
+        return static_cast<uint32_t>(blocks_.size() - 1);
+    }
+
+    void memory_allocator::destroy_block(uint32_t block_index)
+    {
+        auto &block_ptr = blocks_[block_index];
+        if (not block_ptr)
+        {
+            return;
+        }
+        if (block_ptr->mapped)
+        {
+            vkUnmapMemory(device_, block_ptr->memory);
+        }
+        vkFreeMemory(device_, block_ptr->memory, nullptr);
+        block_ptr.reset();
+    }
+}
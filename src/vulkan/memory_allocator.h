@@ -0,0 +1,99 @@
+﻿#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class tlsf;
+
+    // A range of device memory handed out by memory_allocator. Resources bind at memory + offset.
+    struct memory_allocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize   offset = 0;
+        VkDeviceSize   size   = 0;
+        void          *mapped = nullptr; // Host address of offset, null unless the memory type is host visible
+
+        uint32_t block_index = UINT32_MAX;
+        uint32_t node_index  = UINT32_MAX;
+    };
+
+    // Sub-allocates buffers and images from large VkDeviceMemory blocks instead of one vkAllocateMemory per resource.
+    // Every memory type gets its own list of blocks, and ranges inside a block are managed by a TLSF (two-level
+    // segregated fit) allocator. When bufferImageGranularity is larger than one, linear resources (buffers, linear
+    // images) and optimal tiled images never share a block, so no granularity padding is needed between neighbours.
+    // Host visible blocks stay mapped for their whole lifetime. Requests larger than half a block get a dedicated
+    // VkDeviceMemory.
+    class memory_allocator final
+    {
+    public:
+        struct statistics
+        {
+            VkDeviceSize bytes_used       = 0; // Sum of live allocation sizes
+            VkDeviceSize bytes_reserved   = 0; // Sum of VkDeviceMemory sizes
+            VkDeviceSize largest_free     = 0; // Largest contiguous free range in any block
+            uint32_t     block_count      = 0;
+            uint32_t     allocation_count = 0;
+            float        fragmentation    = 0.0f; // 1 - sum of each block's largest free range / free bytes; 0 when no block has holes
+        };
+
+        static constexpr VkDeviceSize default_block_size = 64ull * 1024 * 1024;
+        static constexpr VkDeviceSize range_granularity  = 16; // bytes; no resource needs a finer alignment
+
+        memory_allocator(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize block_size = default_block_size);
+        ~memory_allocator();
+
+        memory_allocator(memory_allocator const &other)            = delete;
+        memory_allocator(memory_allocator &&other)                 = delete;
+        memory_allocator &operator=(memory_allocator const &other) = delete;
+        memory_allocator &operator=(memory_allocator &&other)      = delete;
+
+        // linear is true for buffers and VK_IMAGE_TILING_LINEAR images
+        auto allocate(VkMemoryRequirements const &requirements, VkMemoryPropertyFlags properties, bool linear) -> memory_allocation;
+        void free(memory_allocation &allocation);
+
+        // Range for vkFlushMappedMemoryRanges / vkInvalidateMappedMemoryRanges, offset and size relative to the
+        // allocation and widened to nonCoherentAtomSize
+        auto mapped_range(memory_allocation const &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const -> VkMappedMemoryRange;
+
+        [[nodiscard]] auto stats() const -> statistics;
+        void print_stats() const;
+
+    private:
+        struct block
+        {
+            VkDeviceMemory        memory      = VK_NULL_HANDLE;
+            VkDeviceSize          size        = 0;
+            uint32_t              memory_type = 0;
+            bool                  linear      = false;
+            bool                  dedicated   = false;
+            char                 *mapped      = nullptr;
+            std::unique_ptr<tlsf> ranges;
+            uint32_t              allocation_count = 0;
+        };
+
+        auto find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const -> uint32_t;
+        auto block_size_for(uint32_t memory_type) const -> VkDeviceSize;
+        auto create_block(uint32_t memory_type, VkDeviceSize size, bool linear, bool dedicated) -> uint32_t;
+        void destroy_block(uint32_t block_index);
+
+        VkDevice                         device_ = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties memory_properties_{};
+        VkDeviceSize                     block_size_               = default_block_size;
+        VkDeviceSize                     buffer_image_granularity_ = 1;
+        VkDeviceSize                     non_coherent_atom_size_   = 1;
+
+        // Destroyed blocks leave an empty slot so the indices stored in live allocations stay valid
+        std::vector<std::unique_ptr<block>> blocks_;
+        VkDeviceSize                        bytes_used_ = 0;
+        mutable std::mutex                  mutex_;
+    };
+}
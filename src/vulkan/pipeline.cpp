@@ -32,16 +32,24 @@ namespace dae
         create_graphics_pipeline(vertex_file_path, fragment_file_path, config_info);
     }
 
+    pipeline::pipeline(std::string const &compute_file_path, VkPipelineLayout pipeline_layout)
+        : device_ptr_{&device::instance()}
+        , bind_point_{VK_PIPELINE_BIND_POINT_COMPUTE}
+    {
+        create_compute_pipeline(compute_file_path, pipeline_layout);
+    }
+
     pipeline::~pipeline()
     {
         vkDestroyShaderModule(device_ptr_->logical_device(), vertex_shader_module_, nullptr);
         vkDestroyShaderModule(device_ptr_->logical_device(), fragment_shader_module_, nullptr);
-        vkDestroyPipeline(device_ptr_->logical_device(), graphics_pipeline_, nullptr);
+        vkDestroyShaderModule(device_ptr_->logical_device(), compute_shader_module_, nullptr);
+        vkDestroyPipeline(device_ptr_->logical_device(), pipeline_, nullptr);
     }
 
     void pipeline::bind(VkCommandBuffer command_buffer)
     {
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline_);
+        vkCmdBindPipeline(command_buffer, bind_point_, pipeline_);
     }
 
     void pipeline::default_pipeline_config_info(pipeline_config_info &config_info)
@@ -112,8 +120,8 @@ namespace dae
         config_info.dynamic_state_info.dynamicStateCount = static_cast<uint32_t>(config_info.dynamic_state_enables.size());
         config_info.dynamic_state_info.flags             = 0;
 
-        config_info.binding_descriptions   = model::vertex::get_binding_description();
-        config_info.attribute_descriptions = model::vertex::get_attribute_descriptions();
+        config_info.binding_descriptions   = model::packed_vertex::get_binding_description();
+        config_info.attribute_descriptions = model::packed_vertex::get_attribute_descriptions();
     }
 
     void pipeline::enable_alpha_blending(pipeline_config_info &config_info)
@@ -211,12 +219,36 @@ namespace dae
         pipeline_info.basePipelineIndex  = -1;
         pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(device_ptr_->logical_device(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline_) != VK_SUCCESS)
+        if (vkCreateGraphicsPipelines(device_ptr_->logical_device(), device_ptr_->pipeline_cache(), 1, &pipeline_info, nullptr, &pipeline_) != VK_SUCCESS)
         {
             throw std::runtime_error{"Failed to create graphics pipeline!"};
         }
     }
 
+    void pipeline::create_compute_pipeline(std::string const &compute_file_path, VkPipelineLayout pipeline_layout)
+    {
+        assert(pipeline_layout != VK_NULL_HANDLE and "Cannot create compute pipeline: no pipeline_layout provided");
+
+        auto const comp_code = read_file(compute_file_path);
+        create_shader_module(comp_code, &compute_shader_module_);
+
+        VkComputePipelineCreateInfo pipeline_info{};
+        pipeline_info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_info.stage.module = compute_shader_module_;
+        pipeline_info.stage.pName  = "main";
+        pipeline_info.layout       = pipeline_layout;
+
+        pipeline_info.basePipelineIndex  = -1;
+        pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+        if (vkCreateComputePipelines(device_ptr_->logical_device(), device_ptr_->pipeline_cache(), 1, &pipeline_info, nullptr, &pipeline_) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to create compute pipeline!"};
+        }
+    }
+
     void pipeline::create_shader_module(std::vector<char> const &code, VkShaderModule *shader_module)
     {
         VkShaderModuleCreateInfo create_info{};
@@ -46,6 +46,7 @@ namespace dae
             std::string const &vertex_file_path,
             std::string const &fragment_file_path,
             pipeline_config_info const &config_info);
+        pipeline(std::string const &compute_file_path, VkPipelineLayout pipeline_layout);
 
         ~pipeline();
 
@@ -67,11 +68,15 @@ namespace dae
             std::string const &fragment_file_path,
             pipeline_config_info const &config_info);
 
+        void create_compute_pipeline(std::string const &compute_file_path, VkPipelineLayout pipeline_layout);
+
         void create_shader_module(std::vector<char> const &code, VkShaderModule *shader_module);
 
-        device         *device_ptr_            = nullptr;
-        VkPipeline     graphics_pipeline_      = VK_NULL_HANDLE;
-        VkShaderModule vertex_shader_module_   = VK_NULL_HANDLE;
-        VkShaderModule fragment_shader_module_ = VK_NULL_HANDLE;
+        device              *device_ptr_            = nullptr;
+        VkPipelineBindPoint bind_point_             = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        VkPipeline          pipeline_              = VK_NULL_HANDLE;
+        VkShaderModule      vertex_shader_module_   = VK_NULL_HANDLE;
+        VkShaderModule      fragment_shader_module_ = VK_NULL_HANDLE;
+        VkShaderModule      compute_shader_module_  = VK_NULL_HANDLE;
     };
 }
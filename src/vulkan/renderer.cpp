@@ -71,7 +71,7 @@ namespace dae
         current_frame_index_ = (current_frame_index_ + 1) % swap_chain::MAX_FRAMES_IN_FLIGHT;
     }
 
-    void renderer::begin_swap_chain_render_pass(VkCommandBuffer command_buffer)
+    void renderer::begin_swap_chain_render_pass(VkCommandBuffer command_buffer, VkSubpassContents contents)
     {
         assert(is_frame_started_ and "Can't call begin_swap_chain_render_pass if frame is not in progesss");
         assert(command_buffer == current_command_buffer() and "Can't begin render pass on command buffer from a different frame");
@@ -90,8 +90,47 @@ namespace dae
         render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
         render_pass_info.pClearValues    = clear_values.data();
 
-        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE); // we don't have secondary command buffer
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, contents);
 
+        // with secondary command buffers the primary may only execute them; each one sets its own dynamic state
+        if (contents == VK_SUBPASS_CONTENTS_INLINE)
+        {
+            set_viewport_and_scissor(command_buffer);
+        }
+    }
+
+    void renderer::end_swap_chain_render_pass(VkCommandBuffer command_buffer)
+    {
+        assert(is_frame_started_ and "Can't call end_swap_chain_render_pass if frame is not in progesss");
+        assert(command_buffer == current_command_buffer() and "Can't end render pass on command buffer from a different frame");
+        
+        vkCmdEndRenderPass(command_buffer);
+    }
+
+    void renderer::begin_secondary_command_buffer(VkCommandBuffer command_buffer) const
+    {
+        assert(is_frame_started_ and "Can't begin a secondary command buffer if frame is not in progesss");
+
+        VkCommandBufferInheritanceInfo inheritance_info{};
+        inheritance_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass  = swap_chain_->render_pass();
+        inheritance_info.subpass     = 0;
+        inheritance_info.framebuffer = swap_chain_->get_frame_buffer(current_image_index_);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        begin_info.pInheritanceInfo = &inheritance_info;
+
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to begin recording secondary command buffer"};
+        }
+        set_viewport_and_scissor(command_buffer);
+    }
+
+    void renderer::set_viewport_and_scissor(VkCommandBuffer command_buffer) const
+    {
         VkViewport viewport{};
         viewport.x        = 0.0f;
         viewport.y        = 0.0f;
@@ -104,14 +143,6 @@ namespace dae
         vkCmdSetScissor(command_buffer, 0, 1, &scissor);
     }
 
-    void renderer::end_swap_chain_render_pass(VkCommandBuffer command_buffer)
-    {
-        assert(is_frame_started_ and "Can't call end_swap_chain_render_pass if frame is not in progesss");
-        assert(command_buffer == current_command_buffer() and "Can't end render pass on command buffer from a different frame");
-        
-        vkCmdEndRenderPass(command_buffer);
-    }
-
     renderer::renderer()
         : window_ptr_{&window::instance()}
         , device_ptr_{&device::instance()}
@@ -28,6 +28,7 @@ namespace dae
 
         [[nodiscard]] auto swap_chain_render_pass() const -> VkRenderPass { return swap_chain_->render_pass(); }
         [[nodiscard]] auto aspect_ratio() const -> float { return swap_chain_->extent_aspect_ratio(); }
+        [[nodiscard]] auto extent() const -> VkExtent2D { return swap_chain_->swap_chain_extent(); }
         [[nodiscard]] auto is_frame_in_progress() const -> bool { return is_frame_started_; }
         [[nodiscard]] auto current_command_buffer() const -> VkCommandBuffer
         {
@@ -43,9 +44,12 @@ namespace dae
 
         auto begin_frame() -> VkCommandBuffer;
         void end_frame();
-        void begin_swap_chain_render_pass(VkCommandBuffer command_buffer);
+        void begin_swap_chain_render_pass(VkCommandBuffer command_buffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void end_swap_chain_render_pass(VkCommandBuffer command_buffer);
 
+        // Begins a secondary command buffer that continues the current swap chain render pass
+        void begin_secondary_command_buffer(VkCommandBuffer command_buffer) const;
+
     private:
         friend class singleton<renderer>;
         renderer();
@@ -53,6 +57,7 @@ namespace dae
         void create_command_buffers();
         void free_command_buffers();
         void recreate_swap_chain();
+        void set_viewport_and_scissor(VkCommandBuffer command_buffer) const;
         
     private:
         window                      *window_ptr_ = nullptr;
@@ -0,0 +1,76 @@
+﻿#include "sampler_cache.h"
+
+// Project includes
+#include "src/utility/utils.h"
+
+// Standard includes
+#include <cassert>
+#include <stdexcept>
+#include <tuple>
+
+namespace dae
+{
+    namespace
+    {
+        // Every field that affects sampling; sType and pNext are left out on purpose
+        auto tie(VkSamplerCreateInfo const &info)
+        {
+            return std::tie(
+                info.flags, info.magFilter, info.minFilter, info.mipmapMode,
+                info.addressModeU, info.addressModeV, info.addressModeW,
+                info.mipLodBias, info.anisotropyEnable, info.maxAnisotropy,
+                info.compareEnable, info.compareOp, info.minLod, info.maxLod,
+                info.borderColor, info.unnormalizedCoordinates);
+        }
+    }
+
+    sampler_cache::sampler_cache(VkDevice device)
+        : device_{device}
+    {
+    }
+
+    sampler_cache::~sampler_cache()
+    {
+        for (auto const &[info, sampler] : samplers_)
+        {
+            vkDestroySampler(device_, sampler, nullptr);
+        }
+    }
+
+    auto sampler_cache::get(VkSamplerCreateInfo const &info) -> VkSampler
+    {
+        assert(info.pNext == nullptr and "Sampler create info chains are not part of the cache key");
+
+        std::lock_guard lock{mutex_};
+        if (auto const it = samplers_.find(info); it != samplers_.end())
+        {
+            return it->second;
+        }
+
+        VkSampler sampler = VK_NULL_HANDLE;
+        if (vkCreateSampler(device_, &info, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to create texture sampler!"};
+        }
+        samplers_.emplace(info, sampler);
+        return sampler;
+    }
+
+    auto sampler_cache::size() const -> size_t
+    {
+        std::lock_guard lock{mutex_};
+        return samplers_.size();
+    }
+
+    auto sampler_cache::info_hash::operator()(VkSamplerCreateInfo const &info) const -> size_t
+    {
+        size_t seed = 0;
+        std::apply([&seed](auto const &... fields) { hash_combine(seed, fields...); }, tie(info));
+        return seed;
+    }
+
+    auto sampler_cache::info_equal::operator()(VkSamplerCreateInfo const &lhs, VkSamplerCreateInfo const &rhs) const -> bool
+    {
+        return tie(lhs) == tie(rhs);
+    }
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+
+// Standard includes
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Hands out one VkSampler per distinct VkSamplerCreateInfo, so textures that sample the same way share it instead
+    // of each creating their own. Samplers live as long as the cache; callers never destroy them.
+    class sampler_cache final
+    {
+    public:
+        explicit sampler_cache(VkDevice device);
+        ~sampler_cache();
+
+        sampler_cache(sampler_cache const &other)            = delete;
+        sampler_cache(sampler_cache &&other)                 = delete;
+        sampler_cache &operator=(sampler_cache const &other) = delete;
+        sampler_cache &operator=(sampler_cache &&other)      = delete;
+
+        // Thread safe. Extension chains are not part of the key, info.pNext has to be null
+        auto get(VkSamplerCreateInfo const &info) -> VkSampler;
+
+        [[nodiscard]] auto size() const -> size_t;
+
+    private:
+        struct info_hash
+        {
+            auto operator()(VkSamplerCreateInfo const &info) const -> size_t;
+        };
+
+        struct info_equal
+        {
+            auto operator()(VkSamplerCreateInfo const &lhs, VkSamplerCreateInfo const &rhs) const -> bool;
+        };
+
+    private:
+        VkDevice           device_ = VK_NULL_HANDLE;
+        mutable std::mutex mutex_;
+        std::unordered_map<VkSamplerCreateInfo, VkSampler, info_hash, info_equal> samplers_;
+    };
+}
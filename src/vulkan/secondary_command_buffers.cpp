@@ -0,0 +1,92 @@
+﻿#include "secondary_command_buffers.h"
+
+// Project includes
+#include "src/vulkan/device.h"
+#include "src/vulkan/renderer.h"
+#include "src/vulkan/swap_chain.h"
+
+// Standard includes
+#include <cassert>
+#include <stdexcept>
+
+namespace dae
+{
+    secondary_command_buffers::secondary_command_buffers(uint32_t thread_count)
+        : device_ptr_{&device::instance()}
+    {
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.queueFamilyIndex = device_ptr_->find_physical_queue_families().graphics_family;
+        pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        pools_.resize(swap_chain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame_pools : pools_)
+        {
+            frame_pools.resize(thread_count);
+            for (auto &thread_pool : frame_pools)
+            {
+                if (vkCreateCommandPool(device_ptr_->logical_device(), &pool_info, nullptr, &thread_pool.pool) != VK_SUCCESS)
+                {
+                    throw std::runtime_error{"Failed to create secondary command pool!"};
+                }
+            }
+        }
+    }
+
+    secondary_command_buffers::~secondary_command_buffers()
+    {
+        for (auto const &frame_pools : pools_)
+        {
+            for (auto const &thread_pool : frame_pools)
+            {
+                // destroying the pool frees its command buffers
+                vkDestroyCommandPool(device_ptr_->logical_device(), thread_pool.pool, nullptr);
+            }
+        }
+    }
+
+    void secondary_command_buffers::reset(int frame_index)
+    {
+        for (auto &thread_pool : pools_[frame_index])
+        {
+            if (thread_pool.used > 0)
+            {
+                vkResetCommandPool(device_ptr_->logical_device(), thread_pool.pool, 0);
+                thread_pool.used = 0;
+            }
+        }
+    }
+
+    auto secondary_command_buffers::begin(int frame_index, uint32_t thread_index) -> VkCommandBuffer
+    {
+        assert(thread_index < pools_[frame_index].size() and "No command pool for this thread");
+        auto &thread_pool = pools_[frame_index][thread_index];
+        if (thread_pool.used == thread_pool.command_buffers.size())
+        {
+            VkCommandBufferAllocateInfo alloc_info{};
+            alloc_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            alloc_info.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            alloc_info.commandPool        = thread_pool.pool;
+            alloc_info.commandBufferCount = 1;
+
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+            if (vkAllocateCommandBuffers(device_ptr_->logical_device(), &alloc_info, &command_buffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error{"Failed to allocate secondary command buffer!"};
+            }
+            thread_pool.command_buffers.push_back(command_buffer);
+        }
+
+        auto command_buffer = thread_pool.command_buffers[thread_pool.used++];
+        renderer::instance().begin_secondary_command_buffer(command_buffer);
+        return command_buffer;
+    }
+
+    void secondary_command_buffers::end(VkCommandBuffer command_buffer)
+    {
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to record secondary command buffer!"};
+        }
+    }
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <vector>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class device;
+
+    // Command pools for recording secondary command buffers from several threads. Pools are externally synchronized,
+    // so there is one per thread per frame in flight; a frame's pools are reset as a whole once its fence signaled
+    // and their command buffers are reused the next time around.
+    class secondary_command_buffers final
+    {
+    public:
+        explicit secondary_command_buffers(uint32_t thread_count);
+        ~secondary_command_buffers();
+
+        secondary_command_buffers(secondary_command_buffers const &other)            = delete;
+        secondary_command_buffers(secondary_command_buffers &&other)                 = delete;
+        secondary_command_buffers &operator=(secondary_command_buffers const &other) = delete;
+        secondary_command_buffers &operator=(secondary_command_buffers &&other)      = delete;
+
+        // Call once per frame before any begin(), after the frame's previous submission completed
+        void reset(int frame_index);
+
+        // Returns a secondary command buffer from the calling thread's pool, begun inside the swap chain render pass
+        auto begin(int frame_index, uint32_t thread_index) -> VkCommandBuffer;
+        void end(VkCommandBuffer command_buffer);
+
+    private:
+        struct thread_pool
+        {
+            VkCommandPool                pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> command_buffers;
+            size_t                       used = 0;
+        };
+
+        device *device_ptr_ = nullptr;
+
+        // [frame_index][thread_index]
+        std::vector<std::vector<thread_pool>> pools_;
+    };
+}
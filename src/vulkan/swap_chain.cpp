@@ -49,7 +49,7 @@ namespace dae
         {
             vkDestroyImageView(device_ptr_->logical_device(), depth_image_views_[i], nullptr);
             vkDestroyImage(device_ptr_->logical_device(), depth_images_[i], nullptr);
-            vkFreeMemory(device_ptr_->logical_device(), depth_image_memories_[i], nullptr);
+            device_ptr_->allocator().free(depth_image_memories_[i]);
         }
 
         for (auto framebuffer : swap_chain_framebuffers_)
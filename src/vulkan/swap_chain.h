@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+// Project includes
+#include "src/vulkan/memory_allocator.h"
+
 // Standard includes
 #include <memory>
 #include <vector>
@@ -68,11 +71,11 @@ namespace dae
         std::vector<VkFramebuffer> swap_chain_framebuffers_ = {};
         VkRenderPass               render_pass_             = VK_NULL_HANDLE;
 
-        std::vector<VkImage>        depth_images_           = {};
-        std::vector<VkDeviceMemory> depth_image_memories_   = {};
-        std::vector<VkImageView>    depth_image_views_      = {};
-        std::vector<VkImage>        swap_chain_images_      = {};
-        std::vector<VkImageView>    swap_chain_image_views_ = {};
+        std::vector<VkImage>           depth_images_           = {};
+        std::vector<memory_allocation> depth_image_memories_   = {};
+        std::vector<VkImageView>       depth_image_views_      = {};
+        std::vector<VkImage>           swap_chain_images_      = {};
+        std::vector<VkImageView>       swap_chain_image_views_ = {};
 
         device     *device_ptr_   = nullptr;
         VkExtent2D window_extent_ = {};
@@ -0,0 +1,263 @@
+﻿#include "tlsf.h"
+
+// Standard includes
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace dae
+{
+    namespace
+    {
+        auto align_up(VkDeviceSize value, VkDeviceSize alignment) -> VkDeviceSize
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        auto align_down(VkDeviceSize value, VkDeviceSize alignment) -> VkDeviceSize
+        {
+            return value / alignment * alignment;
+        }
+    }
+
+    tlsf::tlsf(VkDeviceSize size, VkDeviceSize granularity)
+        : granularity_{std::max<VkDeviceSize>(granularity, 1)}
+    {
+        for (auto &level : heads_)
+        {
+            level.fill(invalid_node);
+        }
+        free_bytes_ = align_down(size, granularity_);
+        insert_free(new_node(0, free_bytes_));
+    }
+
+    auto tlsf::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) -> uint32_t
+    {
+        size      = align_up(std::max<VkDeviceSize>(size, 1), granularity_);
+        alignment = align_up(std::max<VkDeviceSize>(alignment, 1), granularity_);
+
+        uint32_t const index = find_suitable(size + alignment - granularity_);
+        if (index == invalid_node)
+        {
+            return invalid_node;
+        }
+        remove_free(index);
+
+        // Give the alignment padding in front back to the free lists
+        VkDeviceSize const padding = align_up(nodes_[index].offset, alignment) - nodes_[index].offset;
+        if (padding > 0)
+        {
+            uint32_t const prev = nodes_[index].prev_physical;
+            if (prev != invalid_node and nodes_[prev].free)
+            {
+                remove_free(prev);
+                nodes_[prev].size += padding;
+                insert_free(prev);
+            }
+            else
+            {
+                uint32_t const front = new_node(nodes_[index].offset, padding);
+                link_before(front, index);
+                insert_free(front);
+            }
+            nodes_[index].offset += padding;
+            nodes_[index].size   -= padding;
+        }
+
+        // And the tail
+        if (nodes_[index].size > size)
+        {
+            uint32_t const back = new_node(nodes_[index].offset + size, nodes_[index].size - size);
+            nodes_[index].size = size;
+            link_after(back, index);
+            insert_free(back);
+        }
+
+        nodes_[index].free = false;
+        free_bytes_ -= nodes_[index].size;
+        offset = nodes_[index].offset;
+        return index;
+    }
+
+    void tlsf::free(uint32_t index)
+    {
+        assert(index < nodes_.size() and not nodes_[index].free and "Freeing a range that is not allocated");
+        nodes_[index].free = true;
+        free_bytes_ += nodes_[index].size;
+
+        uint32_t const next = nodes_[index].next_physical;
+        if (next != invalid_node and nodes_[next].free)
+        {
+            remove_free(next);
+            nodes_[index].size += nodes_[next].size;
+            unlink(next);
+        }
+
+        uint32_t const prev = nodes_[index].prev_physical;
+        if (prev != invalid_node and nodes_[prev].free)
+        {
+            remove_free(prev);
+            nodes_[prev].size += nodes_[index].size;
+            unlink(index);
+            insert_free(prev);
+            return;
+        }
+        insert_free(index);
+    }
+
+    auto tlsf::largest_free() const -> VkDeviceSize
+    {
+        if (fl_bitmap_ == 0)
+        {
+            return 0;
+        }
+        uint32_t const fl = 63 - std::countl_zero(fl_bitmap_);
+        uint32_t const sl = 31 - std::countl_zero(sl_bitmaps_[fl]);
+
+        VkDeviceSize largest = 0;
+        for (uint32_t index = heads_[fl][sl]; index != invalid_node; index = nodes_[index].next_free)
+        {
+            largest = std::max(largest, nodes_[index].size);
+        }
+        return largest;
+    }
+
+    void tlsf::mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+    {
+        if (size < sl_count)
+        {
+            fl = 0;
+            sl = static_cast<uint32_t>(size);
+            return;
+        }
+        fl = static_cast<uint32_t>(std::bit_width(size)) - 1;
+        sl = static_cast<uint32_t>(size >> (fl - sl_bits)) & (sl_count - 1);
+    }
+
+    auto tlsf::find_suitable(VkDeviceSize size) const -> uint32_t
+    {
+        // Small bins hold a single size, so only larger ones need rounding up
+        if (size >= sl_count)
+        {
+            size += (VkDeviceSize{1} << (std::bit_width(size) - 1 - sl_bits)) - 1;
+        }
+        uint32_t fl, sl;
+        mapping(size, fl, sl);
+
+        uint32_t sl_map = sl_bitmaps_[fl] & (~0u << sl);
+        if (sl_map == 0)
+        {
+            uint64_t const fl_map = fl + 1 < fl_count ? fl_bitmap_ & (~0ull << (fl + 1)) : 0;
+            if (fl_map == 0)
+            {
+                return invalid_node;
+            }
+            fl     = static_cast<uint32_t>(std::countr_zero(fl_map));
+            sl_map = sl_bitmaps_[fl];
+        }
+        sl = static_cast<uint32_t>(std::countr_zero(sl_map));
+        return heads_[fl][sl];
+    }
+
+    void tlsf::insert_free(uint32_t index)
+    {
+        uint32_t fl, sl;
+        mapping(nodes_[index].size, fl, sl);
+
+        nodes_[index].free      = true;
+        nodes_[index].prev_free = invalid_node;
+        nodes_[index].next_free = heads_[fl][sl];
+        if (heads_[fl][sl] != invalid_node)
+        {
+            nodes_[heads_[fl][sl]].prev_free = index;
+        }
+        heads_[fl][sl] = index;
+        fl_bitmap_     |= 1ull << fl;
+        sl_bitmaps_[fl] |= 1u << sl;
+    }
+
+    void tlsf::remove_free(uint32_t index)
+    {
+        uint32_t fl, sl;
+        mapping(nodes_[index].size, fl, sl);
+
+        node &n = nodes_[index];
+        if (n.prev_free != invalid_node)
+        {
+            nodes_[n.prev_free].next_free = n.next_free;
+        }
+        else
+        {
+            heads_[fl][sl] = n.next_free;
+        }
+        if (n.next_free != invalid_node)
+        {
+            nodes_[n.next_free].prev_free = n.prev_free;
+        }
+        n.prev_free = n.next_free = invalid_node;
+
+        if (heads_[fl][sl] == invalid_node)
+        {
+            sl_bitmaps_[fl] &= ~(1u << sl);
+            if (sl_bitmaps_[fl] == 0)
+            {
+                fl_bitmap_ &= ~(1ull << fl);
+            }
+        }
+    }
+
+    auto tlsf::new_node(VkDeviceSize offset, VkDeviceSize size) -> uint32_t
+    {
+        uint32_t index;
+        if (not unused_nodes_.empty())
+        {
+            index = unused_nodes_.back();
+            unused_nodes_.pop_back();
+            nodes_[index] = node{};
+        }
+        else
+        {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[index].offset = offset;
+        nodes_[index].size   = size;
+        return index;
+    }
+
+    void tlsf::link_before(uint32_t index, uint32_t next)
+    {
+        nodes_[index].prev_physical = nodes_[next].prev_physical;
+        nodes_[index].next_physical = next;
+        if (nodes_[next].prev_physical != invalid_node)
+        {
+            nodes_[nodes_[next].prev_physical].next_physical = index;
+        }
+        nodes_[next].prev_physical = index;
+    }
+
+    void tlsf::link_after(uint32_t index, uint32_t prev)
+    {
+        nodes_[index].next_physical = nodes_[prev].next_physical;
+        nodes_[index].prev_physical = prev;
+        if (nodes_[prev].next_physical != invalid_node)
+        {
+            nodes_[nodes_[prev].next_physical].prev_physical = index;
+        }
+        nodes_[prev].next_physical = index;
+    }
+
+    void tlsf::unlink(uint32_t index)
+    {
+        node const &n = nodes_[index];
+        if (n.prev_physical != invalid_node)
+        {
+            nodes_[n.prev_physical].next_physical = n.next_physical;
+        }
+        if (n.next_physical != invalid_node)
+        {
+            nodes_[n.next_physical].prev_physical = n.prev_physical;
+        }
+        unused_nodes_.push_back(index);
+    }
+}
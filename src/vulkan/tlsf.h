@@ -0,0 +1,79 @@
+﻿#pragma once
+
+// Standard includes
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Two-level segregated fit over the offsets [0, size). Free ranges are binned by the position of their highest set
+    // bit (first level) and the next sl_bits bits (second level); two bitmaps make finding a non-empty bin that is
+    // guaranteed to fit O(1). Every range knows its physical neighbours so freeing coalesces in O(1) as well. Offsets
+    // are unitless: memory_allocator manages the bytes of a block with it, geometry_arena the elements of a buffer.
+    class tlsf final
+    {
+    public:
+        static constexpr uint32_t invalid_node = UINT32_MAX;
+
+        // Every range's size and offset is a multiple of granularity: 16 suits byte offsets, 1 element offsets
+        tlsf(VkDeviceSize size, VkDeviceSize granularity);
+        ~tlsf() = default;
+
+        tlsf(tlsf const &other)            = delete;
+        tlsf(tlsf &&other)                 = delete;
+        tlsf &operator=(tlsf const &other) = delete;
+        tlsf &operator=(tlsf &&other)      = delete;
+
+        // Returns the range's node, or invalid_node when no free range can hold size bytes at the requested alignment.
+        // Sizes and alignments are rounded up to the granularity.
+        auto allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) -> uint32_t;
+        void free(uint32_t index);
+
+        [[nodiscard]] auto free_bytes() const -> VkDeviceSize { return free_bytes_; }
+        [[nodiscard]] auto largest_free() const -> VkDeviceSize;
+
+    private:
+        static constexpr uint32_t     sl_bits     = 4;
+        static constexpr uint32_t     sl_count    = 1u << sl_bits;
+        static constexpr uint32_t     fl_count    = 64;
+
+        struct node
+        {
+            VkDeviceSize offset        = 0;
+            VkDeviceSize size          = 0;
+            uint32_t     prev_physical = invalid_node;
+            uint32_t     next_physical = invalid_node;
+            uint32_t     prev_free     = invalid_node;
+            uint32_t     next_free     = invalid_node;
+            bool         free          = true;
+        };
+
+        // Sizes below sl_count get a bin of their own in the first level 0, larger ones start at first level sl_bits
+        static void mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+
+        // Rounds size up to the next bin boundary, so every range in the returned bin is large enough
+        auto find_suitable(VkDeviceSize size) const -> uint32_t;
+
+        void insert_free(uint32_t index);
+        void remove_free(uint32_t index);
+        auto new_node(VkDeviceSize offset, VkDeviceSize size) -> uint32_t;
+        void link_before(uint32_t index, uint32_t next);
+        void link_after(uint32_t index, uint32_t prev);
+
+        // Drops a node whose range was merged into a physical neighbour
+        void unlink(uint32_t index);
+
+        VkDeviceSize          granularity_;
+        std::vector<node>     nodes_;
+        std::vector<uint32_t> unused_nodes_;
+
+        uint64_t                                                 fl_bitmap_ = 0;
+        std::array<uint32_t, fl_count>                           sl_bitmaps_{};
+        std::array<std::array<uint32_t, sl_count>, fl_count>     heads_;
+        VkDeviceSize                                             free_bytes_ = 0;
+    };
+}
@@ -0,0 +1,69 @@
+﻿#include "uniform_ring.h"
+
+// Project includes
+#include "src/vulkan/buffer.h"
+#include "src/vulkan/device.h"
+#include "src/vulkan/swap_chain.h"
+
+// Standard includes
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace dae
+{
+    uniform_ring::uniform_ring(VkDeviceSize frame_size)
+        : device_ptr_{&device::instance()}
+    {
+        // Regions also start on a flush atom, so flushing one frame never touches the region the GPU reads
+        auto const &limits = device_ptr_->properties.limits;
+        alignment_  = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+        VkDeviceSize const region_alignment = std::max(alignment_, limits.nonCoherentAtomSize);
+        frame_size_ = (frame_size + region_alignment - 1) / region_alignment * region_alignment;
+
+        buffer_ = std::make_unique<buffer>(
+            frame_size_,
+            swap_chain::MAX_FRAMES_IN_FLIGHT,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        buffer_->map();
+        mapped_ = static_cast<char*>(buffer_->mapped_memory());
+    }
+
+    uniform_ring::~uniform_ring() = default;
+
+    void uniform_ring::begin_frame(int frame_index)
+    {
+        frame_base_ = static_cast<VkDeviceSize>(frame_index) * frame_size_;
+        used_.store(0, std::memory_order_relaxed);
+    }
+
+    auto uniform_ring::push(void const *data, VkDeviceSize size) -> uint32_t
+    {
+        VkDeviceSize const aligned_size = (size + alignment_ - 1) / alignment_ * alignment_;
+        VkDeviceSize const offset       = used_.fetch_add(aligned_size, std::memory_order_relaxed);
+        if (offset + aligned_size > frame_size_)
+        {
+            throw std::runtime_error{"Uniform ring frame region exhausted!"};
+        }
+
+        std::memcpy(mapped_ + frame_base_ + offset, data, size);
+        return static_cast<uint32_t>(frame_base_ + offset);
+    }
+
+    void uniform_ring::flush()
+    {
+        VkDeviceSize const used = std::min(used_.load(std::memory_order_relaxed), frame_size_);
+        if (used > 0)
+        {
+            buffer_->flush(used, frame_base_);
+        }
+    }
+
+    auto uniform_ring::descriptor_info(VkDeviceSize range) const -> VkDescriptorBufferInfo
+    {
+        assert(range <= device_ptr_->properties.limits.maxUniformBufferRange and "Dynamic uniform range too large");
+        return VkDescriptorBufferInfo{buffer_->get_buffer(), 0, range};
+    }
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class buffer;
+    class device;
+
+    // Linear allocator for uniform data that only lives for one frame. One persistently mapped buffer is split into
+    // a region per frame in flight; begin_frame() rewinds the frame's region and push() bumps through it with
+    // minUniformBufferOffsetAlignment-aligned blocks. Blocks are read through UNIFORM_BUFFER_DYNAMIC descriptors
+    // that all point at the ring, with the value push() returned as dynamic offset, so any number of blocks needs
+    // neither a buffer nor a descriptor set of its own. push() may be called from several threads while recording.
+    class uniform_ring final
+    {
+    public:
+        explicit uniform_ring(VkDeviceSize frame_size);
+        ~uniform_ring();
+
+        uniform_ring(uniform_ring const &other)            = delete;
+        uniform_ring(uniform_ring &&other)                 = delete;
+        uniform_ring &operator=(uniform_ring const &other) = delete;
+        uniform_ring &operator=(uniform_ring &&other)      = delete;
+
+        // Only once the fence of the frame that last used frame_index signaled
+        void begin_frame(int frame_index);
+
+        // Copies size bytes into the frame's region and returns the dynamic offset to bind them with
+        auto push(void const *data, VkDeviceSize size) -> uint32_t;
+
+        template <typename T>
+        auto push(T const &value) -> uint32_t { return push(&value, sizeof(T)); }
+
+        // Flushes the bytes pushed this frame and nothing else; call after recording, before submitting
+        void flush();
+
+        // For a dynamic descriptor reading blocks of at most range bytes
+        [[nodiscard]] auto descriptor_info(VkDeviceSize range) const -> VkDescriptorBufferInfo;
+        [[nodiscard]] auto bytes_used() const -> VkDeviceSize { return used_.load(std::memory_order_relaxed); }
+
+    private:
+        device                  *device_ptr_ = nullptr;
+        std::unique_ptr<buffer> buffer_;
+        char                    *mapped_     = nullptr;
+        VkDeviceSize            alignment_   = 0;
+        VkDeviceSize            frame_size_  = 0;
+        VkDeviceSize            frame_base_  = 0;
+        std::atomic<VkDeviceSize> used_      = 0;
+    };
+}
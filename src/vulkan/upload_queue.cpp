@@ -0,0 +1,527 @@
+﻿#include "upload_queue.h"
+
+// Project includes
+#include "src/vulkan/buffer.h"
+#include "src/vulkan/device.h"
+
+// Standard includes
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace dae
+{
+    namespace
+    {
+        // Everything the graphics queue may do with an uploaded resource next
+        constexpr VkPipelineStageFlags acquire_stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                                                        | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        constexpr VkAccessFlags        buffer_acquire_access = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                                                               | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        constexpr VkAccessFlags        image_acquire_access  = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+    }
+
+    VkDeviceSize upload_queue::staging_size = 32ull * 1024 * 1024;
+
+    upload_queue::upload_queue()
+        : device_ptr_{&device::instance()}
+    {
+        auto const families = device_ptr_->find_physical_queue_families();
+        graphics_family_    = families.graphics_family;
+        transfer_family_    = families.transfer_family;
+        dedicated_transfer_ = families.has_dedicated_transfer();
+
+        if (dedicated_transfer_)
+        {
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.queueFamilyIndex = graphics_family_;
+            pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+            if (vkCreateCommandPool(device_ptr_->logical_device(), &pool_info, nullptr, &graphics_command_pool_) != VK_SUCCESS)
+            {
+                throw std::runtime_error{"Failed to create upload command pool!"};
+            }
+        }
+
+        // Buffer to image copies want offsets that are a multiple of the texel size (4 for every format used here)
+        alignment_ = std::max<VkDeviceSize>(16, device_ptr_->properties.limits.optimalBufferCopyOffsetAlignment);
+        ring_size_ = staging_size;
+        ring_      = std::make_unique<buffer>(
+            ring_size_,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        ring_->map();
+        ring_data_ = static_cast<char*>(ring_->mapped_memory());
+
+        current_.value = 1;
+    }
+
+    upload_queue::~upload_queue()
+    {
+        flush();
+
+        spare_batches_.push_back(std::move(current_));
+        for (auto const &spare : spare_batches_)
+        {
+            if (spare.transfer_command_buffer != VK_NULL_HANDLE)
+            {
+                vkFreeCommandBuffers(device_ptr_->logical_device(), device_ptr_->transfer_command_pool(), 1, &spare.transfer_command_buffer);
+            }
+            vkDestroySemaphore(device_ptr_->logical_device(), spare.semaphore, nullptr);
+            vkDestroyFence(device_ptr_->logical_device(), spare.fence, nullptr);
+        }
+        vkDestroyCommandPool(device_ptr_->logical_device(), graphics_command_pool_, nullptr);
+    }
+
+    void upload_queue::upload_to_buffer(VkBuffer dst_buffer, void const *data, VkDeviceSize size, VkDeviceSize dst_offset)
+    {
+        std::lock_guard lock{mutex_};
+
+        VkBuffer     src_buffer;
+        VkDeviceSize src_offset;
+        stage(data, size, src_buffer, src_offset);
+
+        VkBufferCopy copy_region{};
+        copy_region.srcOffset = src_offset;
+        copy_region.dstOffset = dst_offset;
+        copy_region.size      = size;
+        vkCmdCopyBuffer(begin_batch(), src_buffer, dst_buffer, 1, &copy_region);
+
+        if (dedicated_transfer_)
+        {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = transfer_family_;
+            barrier.dstQueueFamilyIndex = graphics_family_;
+            barrier.buffer              = dst_buffer;
+            barrier.offset              = dst_offset;
+            barrier.size                = size;
+            current_.buffer_transfers.push_back(barrier);
+        }
+    }
+
+    void upload_queue::upload_to_image(VkImage image, void const *data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layer_count, uint32_t mip_level)
+    {
+        std::lock_guard lock{mutex_};
+
+        VkBuffer     src_buffer;
+        VkDeviceSize src_offset;
+        stage(data, size, src_buffer, src_offset);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset      = src_offset;
+        region.bufferRowLength   = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = mip_level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount     = layer_count;
+
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+
+        vkCmdCopyBufferToImage(begin_batch(), src_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    void upload_queue::record(std::function<void(VkCommandBuffer)> const &fn)
+    {
+        std::lock_guard lock{mutex_};
+        fn(begin_batch());
+    }
+
+    void upload_queue::record_graphics(std::function<void(VkCommandBuffer)> fn)
+    {
+        std::lock_guard lock{mutex_};
+        begin_batch();
+        current_.graphics_work.push_back(std::move(fn));
+    }
+
+    void upload_queue::transfer_ownership(VkImage image, VkImageSubresourceRange const &range, VkImageLayout layout)
+    {
+        if (not dedicated_transfer_)
+        {
+            return;
+        }
+
+        std::lock_guard lock{mutex_};
+        begin_batch();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout           = layout;
+        barrier.newLayout           = layout;
+        barrier.srcQueueFamilyIndex = transfer_family_;
+        barrier.dstQueueFamilyIndex = graphics_family_;
+        barrier.image               = image;
+        barrier.subresourceRange    = range;
+        current_.image_transfers.push_back(barrier);
+    }
+
+    auto upload_queue::current_ticket() const -> ticket
+    {
+        std::lock_guard lock{mutex_};
+        return current_.value;
+    }
+
+    auto upload_queue::submit() -> ticket
+    {
+        std::lock_guard lock{mutex_};
+        return submit_batch();
+    }
+
+    void upload_queue::wait(ticket value)
+    {
+        std::lock_guard lock{mutex_};
+        if (value >= current_.value and current_.recording)
+        {
+            submit_batch();
+        }
+        while (completed_ < value and not in_flight_.empty())
+        {
+            retire_batch(true);
+        }
+    }
+
+    auto upload_queue::is_complete(ticket value) -> bool
+    {
+        std::lock_guard lock{mutex_};
+        while (not in_flight_.empty() and completed_ < value)
+        {
+            ticket const before = completed_;
+            retire_batch(false);
+            if (completed_ == before)
+            {
+                break;
+            }
+        }
+        return completed_ >= value;
+    }
+
+    auto upload_queue::submit_count() const -> uint32_t
+    {
+        std::lock_guard lock{mutex_};
+        return submit_count_;
+    }
+
+    auto upload_queue::begin_batch() -> VkCommandBuffer
+    {
+        if (current_.recording)
+        {
+            return current_.transfer_command_buffer;
+        }
+
+        if (current_.transfer_command_buffer == VK_NULL_HANDLE)
+        {
+            // Only the Vulkan objects are taken over; staging done for this batch is already accounted
+            if (not spare_batches_.empty())
+            {
+                current_.transfer_command_buffer = spare_batches_.back().transfer_command_buffer;
+                current_.graphics_command_buffer = spare_batches_.back().graphics_command_buffer;
+                current_.semaphore               = spare_batches_.back().semaphore;
+                current_.fence                   = spare_batches_.back().fence;
+                spare_batches_.pop_back();
+            }
+            else
+            {
+                VkCommandBufferAllocateInfo alloc_info{};
+                alloc_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                alloc_info.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                alloc_info.commandPool        = device_ptr_->transfer_command_pool();
+                alloc_info.commandBufferCount = 1;
+                if (vkAllocateCommandBuffers(device_ptr_->logical_device(), &alloc_info, &current_.transfer_command_buffer) != VK_SUCCESS)
+                {
+                    throw std::runtime_error{"Failed to allocate upload command buffer!"};
+                }
+
+                VkFenceCreateInfo fence_info{};
+                fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+                if (vkCreateFence(device_ptr_->logical_device(), &fence_info, nullptr, &current_.fence) != VK_SUCCESS)
+                {
+                    throw std::runtime_error{"Failed to create upload fence!"};
+                }
+
+                if (dedicated_transfer_)
+                {
+                    alloc_info.commandPool = graphics_command_pool_;
+                    if (vkAllocateCommandBuffers(device_ptr_->logical_device(), &alloc_info, &current_.graphics_command_buffer) != VK_SUCCESS)
+                    {
+                        throw std::runtime_error{"Failed to allocate upload command buffer!"};
+                    }
+
+                    VkSemaphoreCreateInfo semaphore_info{};
+                    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                    if (vkCreateSemaphore(device_ptr_->logical_device(), &semaphore_info, nullptr, &current_.semaphore) != VK_SUCCESS)
+                    {
+                        throw std::runtime_error{"Failed to create upload semaphore!"};
+                    }
+                }
+            }
+        }
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(current_.transfer_command_buffer, &begin_info);
+
+        current_.recording = true;
+        return current_.transfer_command_buffer;
+    }
+
+    auto upload_queue::submit_batch() -> ticket
+    {
+        // Recycle whatever finished in the meantime, so the ring and batches get reused without ever blocking
+        while (not in_flight_.empty())
+        {
+            ticket const before = completed_;
+            retire_batch(false);
+            if (completed_ == before)
+            {
+                break;
+            }
+        }
+
+        if (not current_.recording)
+        {
+            return current_.value - 1;
+        }
+
+        VkCommandBuffer graphics_command_buffer = current_.transfer_command_buffer;
+        if (dedicated_transfer_)
+        {
+            // Release on the transfer queue...
+            for (auto &barrier : current_.buffer_transfers)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+            }
+            for (auto &barrier : current_.image_transfers)
+            {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+            }
+            vkCmdPipelineBarrier(
+                current_.transfer_command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0,
+                nullptr,
+                static_cast<uint32_t>(current_.buffer_transfers.size()),
+                current_.buffer_transfers.data(),
+                static_cast<uint32_t>(current_.image_transfers.size()),
+                current_.image_transfers.data());
+            vkEndCommandBuffer(current_.transfer_command_buffer);
+
+            VkSubmitInfo transfer_submit{};
+            transfer_submit.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            transfer_submit.commandBufferCount   = 1;
+            transfer_submit.pCommandBuffers      = &current_.transfer_command_buffer;
+            transfer_submit.signalSemaphoreCount = 1;
+            transfer_submit.pSignalSemaphores    = &current_.semaphore;
+            if (vkQueueSubmit(device_ptr_->transfer_queue(), 1, &transfer_submit, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error{"Failed to submit upload batch!"};
+            }
+
+            // ...and acquire with the matching barriers on the graphics queue
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(current_.graphics_command_buffer, &begin_info);
+            graphics_command_buffer = current_.graphics_command_buffer;
+
+            for (auto &barrier : current_.buffer_transfers)
+            {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = buffer_acquire_access;
+            }
+            for (auto &barrier : current_.image_transfers)
+            {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = image_acquire_access;
+            }
+            vkCmdPipelineBarrier(
+                graphics_command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                acquire_stages,
+                0,
+                0,
+                nullptr,
+                static_cast<uint32_t>(current_.buffer_transfers.size()),
+                current_.buffer_transfers.data(),
+                static_cast<uint32_t>(current_.image_transfers.size()),
+                current_.image_transfers.data());
+        }
+
+        for (auto const &work : current_.graphics_work)
+        {
+            work(graphics_command_buffer);
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+            graphics_command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            1,
+            &barrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+        vkEndCommandBuffer(graphics_command_buffer);
+
+        VkPipelineStageFlags const wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers    = &graphics_command_buffer;
+        if (dedicated_transfer_)
+        {
+            submit_info.waitSemaphoreCount = 1;
+            submit_info.pWaitSemaphores    = &current_.semaphore;
+            submit_info.pWaitDstStageMask  = &wait_stage;
+        }
+        if (vkQueueSubmit(device_ptr_->graphics_queue(), 1, &submit_info, current_.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error{"Failed to submit upload batch!"};
+        }
+        ++submit_count_;
+
+        ticket const submitted = current_.value;
+        current_.recording = false;
+        in_flight_.push_back(std::move(current_));
+        current_       = batch{};
+        current_.value = submitted + 1;
+        return submitted;
+    }
+
+    // Batches go to one queue, so their fences signal in submission order and only the oldest needs checking
+    void upload_queue::retire_batch(bool block)
+    {
+        batch &oldest = in_flight_.front();
+        if (block)
+        {
+            vkWaitForFences(device_ptr_->logical_device(), 1, &oldest.fence, VK_TRUE, UINT64_MAX);
+        }
+        else if (vkGetFenceStatus(device_ptr_->logical_device(), oldest.fence) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        vkResetFences(device_ptr_->logical_device(), 1, &oldest.fence);
+        vkResetCommandBuffer(oldest.transfer_command_buffer, 0);
+        if (oldest.graphics_command_buffer != VK_NULL_HANDLE)
+        {
+            vkResetCommandBuffer(oldest.graphics_command_buffer, 0);
+        }
+        if (oldest.ring_bytes > 0)
+        {
+            tail_  = oldest.ring_end;
+            used_ -= oldest.ring_bytes;
+        }
+        completed_ = oldest.value;
+
+        oldest.overflow_buffers.clear();
+        oldest.buffer_transfers.clear();
+        oldest.image_transfers.clear();
+        oldest.graphics_work.clear();
+        oldest.ring_bytes = 0;
+        spare_batches_.push_back(std::move(oldest));
+        in_flight_.pop_front();
+    }
+
+    void upload_queue::stage(void const *data, VkDeviceSize size, VkBuffer &src_buffer, VkDeviceSize &src_offset)
+    {
+        if (size <= ring_size_)
+        {
+            // Out of ring space: hand the batch that holds it to the GPU and reclaim the oldest one until it fits
+            while (not allocate_staging(size, src_offset))
+            {
+                if (current_.ring_bytes > 0)
+                {
+                    submit_batch();
+                }
+                assert(not in_flight_.empty() and "Staging ring full without any batch holding it");
+                retire_batch(true);
+            }
+
+            std::memcpy(ring_data_ + src_offset, data, size);
+            src_buffer = ring_->get_buffer();
+            return;
+        }
+
+        auto staging_buffer = std::make_unique<buffer>(
+            size,
+            1,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        staging_buffer->map();
+        staging_buffer->write_to_buffer(const_cast<void*>(data));
+
+        src_buffer = staging_buffer->get_buffer();
+        src_offset = 0;
+        current_.overflow_buffers.push_back(std::move(staging_buffer));
+    }
+
+    auto upload_queue::allocate_staging(VkDeviceSize size, VkDeviceSize &offset) -> bool
+    {
+        if (used_ == 0)
+        {
+            head_ = tail_ = 0;
+        }
+        else if (head_ == tail_)
+        {
+            return false;
+        }
+
+        VkDeviceSize const start = (head_ + alignment_ - 1) / alignment_ * alignment_;
+        VkDeviceSize       end   = 0;
+        if (head_ >= tail_)
+        {
+            // Free space is [head_, ring_size_) followed by [0, tail_)
+            if (start + size <= ring_size_)
+            {
+                offset = start;
+                end    = start + size;
+            }
+            else if (size <= tail_)
+            {
+                offset = 0;
+                end    = size;
+                // The skipped tail end of the ring is released together with this batch
+                used_               += ring_size_ - head_;
+                current_.ring_bytes += ring_size_ - head_;
+                head_                = 0;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (start + size <= tail_)
+        {
+            offset = start;
+            end    = start + size;
+        }
+        else
+        {
+            return false;
+        }
+
+        used_               += end - head_;
+        current_.ring_bytes += end - head_;
+        head_                = end;
+        current_.ring_end    = head_;
+        return true;
+    }
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+// Project includes
+#include "src/utility/singleton.h"
+
+// Standard includes
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    // Forward declarations
+    class buffer;
+    class device;
+
+    // Collects staging copies and layout transitions into one command buffer per batch instead of a blocking
+    // single-time submit for each of them. Source data is copied into a persistently mapped staging ring right away,
+    // so callers can free it on return; ring space is reclaimed once the batch that used it signals its fence.
+    // Uploads larger than the whole ring get a temporary staging buffer that lives until its batch completed.
+    //
+    // When the device has a dedicated transfer queue, copies run there while frames render. A batch then is two
+    // submits: the transfer work, ending in ownership release barriers, and a short graphics submit that waits on it
+    // through a semaphore, acquires the resources for the graphics family and runs record_graphics() work such as
+    // mip generation. Without one, both halves go into a single command buffer on the graphics queue.
+    //
+    // Every batch ends with a memory barrier from transfer writes to vertex, index, uniform and shader reads on the
+    // graphics queue, so anything submitted to it afterwards sees the uploaded data without a CPU wait. Callers that
+    // want to free the destination wait on the batch's ticket instead. Submits happen from the calling thread and
+    // the graphics queue is shared with the renderer, so submit(), wait() and flush() belong on the main thread.
+    class upload_queue final : public singleton<upload_queue>
+    {
+    public:
+        using ticket = uint64_t;
+
+        // Size of the staging ring, set before first use
+        static VkDeviceSize staging_size;
+
+        ~upload_queue() override;
+
+        upload_queue(upload_queue const &other)            = delete;
+        upload_queue(upload_queue &&other)                 = delete;
+        upload_queue &operator=(upload_queue const &other) = delete;
+        upload_queue &operator=(upload_queue &&other)      = delete;
+
+        void upload_to_buffer(VkBuffer dst_buffer, void const *data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+
+        // The image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL by then, see record(). Hand it over with
+        // transfer_ownership() once everything the transfer queue does to it is recorded.
+        void upload_to_image(VkImage image, void const *data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t layer_count, uint32_t mip_level = 0);
+
+        // Records transfer queue commands (layout transitions, copies) into the batch being built, in order with the
+        // uploads around them. fn must not call back into the upload queue.
+        void record(std::function<void(VkCommandBuffer)> const &fn);
+
+        // Queues commands that need the graphics queue, like blits; they run after all of the batch's transfers
+        void record_graphics(std::function<void(VkCommandBuffer)> fn);
+
+        // Releases the image range to the graphics family at the end of the batch's transfer work and acquires it
+        // there, keeping its layout. Buffers written by upload_to_buffer() are handed over automatically.
+        void transfer_ownership(VkImage image, VkImageSubresourceRange const &range, VkImageLayout layout);
+
+        // Ticket of the batch currently being built, completes once that batch executed
+        [[nodiscard]] auto current_ticket() const -> ticket;
+
+        // Submits the batch being built, if it recorded anything, and returns its ticket
+        auto submit() -> ticket;
+        void wait(ticket value);
+        [[nodiscard]] auto is_complete(ticket value) -> bool;
+        void flush() { wait(submit()); }
+
+        [[nodiscard]] auto submit_count() const -> uint32_t;
+
+    private:
+        friend class singleton<upload_queue>;
+        upload_queue();
+
+        struct batch
+        {
+            VkCommandBuffer                      transfer_command_buffer = VK_NULL_HANDLE;
+            VkCommandBuffer                      graphics_command_buffer = VK_NULL_HANDLE; // Dedicated transfer queue only
+            VkSemaphore                          semaphore               = VK_NULL_HANDLE; // Dedicated transfer queue only
+            VkFence                              fence                   = VK_NULL_HANDLE;
+            ticket                               value                   = 0;
+            VkDeviceSize                         ring_end                = 0;
+            VkDeviceSize                         ring_bytes              = 0;
+            std::vector<std::unique_ptr<buffer>> overflow_buffers;
+            std::vector<VkBufferMemoryBarrier>   buffer_transfers;
+            std::vector<VkImageMemoryBarrier>    image_transfers;
+            std::vector<std::function<void(VkCommandBuffer)>> graphics_work;
+            bool                                 recording               = false;
+        };
+
+        auto begin_batch() -> VkCommandBuffer;
+        auto submit_batch() -> ticket;
+        void retire_batch(bool block);
+        void stage(void const *data, VkDeviceSize size, VkBuffer &src_buffer, VkDeviceSize &src_offset);
+        auto allocate_staging(VkDeviceSize size, VkDeviceSize &offset) -> bool;
+
+        device        *device_ptr_             = nullptr;
+        VkCommandPool graphics_command_pool_ = VK_NULL_HANDLE;
+        uint32_t      graphics_family_       = 0;
+        uint32_t      transfer_family_       = 0;
+        bool          dedicated_transfer_    = false;
+
+        // Used range is [tail_, head_), wrapping around; used_ tells a full ring from an empty one
+        std::unique_ptr<buffer> ring_;
+        char                   *ring_data_ = nullptr;
+        VkDeviceSize            ring_size_ = 0;
+        VkDeviceSize            alignment_ = 16;
+        VkDeviceSize            head_      = 0;
+        VkDeviceSize            tail_      = 0;
+        VkDeviceSize            used_      = 0;
+
+        batch              current_;
+        std::deque<batch>  in_flight_;
+        std::vector<batch> spare_batches_;
+        ticket             completed_    = 0;
+        uint32_t           submit_count_ = 0;
+        mutable std::mutex mutex_;
+    };
+}
@@ -0,0 +1,613 @@
+﻿// Offline texture cooker: turns PNG/JPG assets into block-compressed KTX2 files with a precomputed mip chain, so the
+// engine uploads them as-is instead of decoding RGBA8 and blitting mips at load time.
+//
+//     texture_cooker <input> <output.ktx2> <color|normal|gloss>
+//
+// color  -> BC7 sRGB (mode 6), mips filtered in linear space
+// normal -> BC5 with the tangent-space x and y, mips renormalized; shaders reconstruct z
+// gloss  -> BC4 of the red channel, decoded from sRGB first so it samples like the R8G8B8A8_SRGB upload it replaces
+
+// Project includes
+#include "src/utility/ktx2.h"
+
+// Standard includes
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// STB includes
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// Vulkan includes
+#include <vulkan/vulkan.h>
+
+namespace dae
+{
+    namespace
+    {
+        enum class texture_role { color, normal, gloss };
+
+        struct float_image
+        {
+            int width  = 0;
+            int height = 0;
+            std::vector<std::array<float, 4>> texels;
+
+            [[nodiscard]] auto at(int x, int y) const -> std::array<float, 4> const &
+            {
+                return texels[static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + std::clamp(x, 0, width - 1)];
+            }
+        };
+
+        auto srgb_to_linear(float c) -> float
+        {
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        auto linear_to_srgb(float c) -> float
+        {
+            return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        }
+
+        auto to_byte(float c) -> float
+        {
+            return std::clamp(std::round(c * 255.0f), 0.0f, 255.0f);
+        }
+
+        // Working values: linear color, unit normals in [-1, 1], or linear gloss in x
+        auto load_image(std::string const &path, texture_role role) -> float_image
+        {
+            int width, height, channels;
+            stbi_uc *pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+            if (not pixels)
+            {
+                return {};
+            }
+
+            float_image image{width, height, {}};
+            image.texels.resize(static_cast<size_t>(width) * height);
+            for (size_t i = 0; i < image.texels.size(); ++i)
+            {
+                auto &texel = image.texels[i];
+                for (int c = 0; c < 4; ++c)
+                {
+                    texel[c] = static_cast<float>(pixels[i * 4 + c]) / 255.0f;
+                }
+                switch (role)
+                {
+                case texture_role::color:
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        texel[c] = srgb_to_linear(texel[c]);
+                    }
+                    break;
+                case texture_role::normal:
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        texel[c] = texel[c] * 2.0f - 1.0f;
+                    }
+                    break;
+                case texture_role::gloss:
+                    texel[0] = srgb_to_linear(texel[0]);
+                    break;
+                }
+            }
+            stbi_image_free(pixels);
+            return image;
+        }
+
+        // 2x2 box filter; odd edges repeat their last row or column
+        auto downsample(float_image const &source, texture_role role) -> float_image
+        {
+            float_image image{std::max(source.width / 2, 1), std::max(source.height / 2, 1), {}};
+            image.texels.resize(static_cast<size_t>(image.width) * image.height);
+            for (int y = 0; y < image.height; ++y)
+            {
+                for (int x = 0; x < image.width; ++x)
+                {
+                    auto &texel = image.texels[static_cast<size_t>(y) * image.width + x];
+                    texel = {};
+                    for (auto const &sample : {source.at(2 * x, 2 * y), source.at(2 * x + 1, 2 * y), source.at(2 * x, 2 * y + 1), source.at(2 * x + 1, 2 * y + 1)})
+                    {
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            texel[c] += sample[c] * 0.25f;
+                        }
+                    }
+                    if (role == texture_role::normal)
+                    {
+                        float const length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+                        for (int c = 0; length > 0.0f and c < 3; ++c)
+                        {
+                            texel[c] /= length;
+                        }
+                    }
+                }
+            }
+            return image;
+        }
+
+        // Little-endian bit writer for one 64 or 128 bit block
+        template <size_t Bytes>
+        struct block_writer
+        {
+            std::array<uint8_t, Bytes> bytes{};
+            uint32_t                   position = 0;
+
+            void write(uint32_t value, uint32_t bit_count)
+            {
+                for (uint32_t i = 0; i < bit_count; ++i, ++position)
+                {
+                    bytes[position / 8] |= static_cast<uint8_t>(((value >> i) & 1u) << (position % 8));
+                }
+            }
+        };
+
+        //--------------------------------------------------------------------------------------------------
+        // BC4: two 8-bit endpoints and 3-bit indices into the eight values between them
+        //--------------------------------------------------------------------------------------------------
+        void encode_bc4(std::array<float, 16> const &values, block_writer<8> &block)
+        {
+            auto const [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+            auto const r0 = static_cast<uint32_t>(*max_it);
+            auto const r1 = static_cast<uint32_t>(*min_it);
+
+            // r0 > r1 selects the eight-value palette; equal endpoints decode to r0 at index 0
+            std::array<float, 8> palette{static_cast<float>(r0), static_cast<float>(r1)};
+            for (uint32_t i = 2; i < 8; ++i)
+            {
+                palette[i] = static_cast<float>(((8 - i) * r0 + (i - 1) * r1) / 7);
+            }
+
+            block.write(r0, 8);
+            block.write(r1, 8);
+            for (float const value : values)
+            {
+                uint32_t best = 0;
+                for (uint32_t i = 1; r0 != r1 and i < 8; ++i)
+                {
+                    if (std::abs(palette[i] - value) < std::abs(palette[best] - value))
+                    {
+                        best = i;
+                    }
+                }
+                block.write(best, 3);
+            }
+        }
+
+        //--------------------------------------------------------------------------------------------------
+        // BC7 mode 6: one subset, RGBA endpoints with 7 bits plus a shared p-bit each, 4-bit indices
+        //--------------------------------------------------------------------------------------------------
+        constexpr std::array<uint32_t, 16> bc7_weights{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        using color = std::array<float, 4>;
+
+        struct bc7_endpoint
+        {
+            std::array<uint32_t, 4> value; // 7 bits per channel
+            uint32_t                p_bit;
+
+            [[nodiscard]] auto decoded(int c) const -> uint32_t { return value[c] << 1 | p_bit; }
+        };
+
+        auto quantize_bc7(color const &endpoint) -> bc7_endpoint
+        {
+            bc7_endpoint best{};
+            float best_error = std::numeric_limits<float>::max();
+            for (uint32_t p_bit = 0; p_bit < 2; ++p_bit)
+            {
+                bc7_endpoint candidate{{}, p_bit};
+                float error = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    candidate.value[c] = static_cast<uint32_t>(std::clamp(std::round((endpoint[c] - static_cast<float>(p_bit)) / 2.0f), 0.0f, 127.0f));
+                    float const delta = static_cast<float>(candidate.decoded(c)) - endpoint[c];
+                    error += delta * delta;
+                }
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best = candidate;
+                }
+            }
+            return best;
+        }
+
+        // Picks the nearest palette entry for every texel and returns the summed squared error
+        auto assign_bc7_indices(std::array<color, 16> const &texels, bc7_endpoint const &e0, bc7_endpoint const &e1, std::array<uint32_t, 16> &indices) -> float
+        {
+            std::array<color, 16> palette{};
+            for (size_t i = 0; i < palette.size(); ++i)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    palette[i][c] = static_cast<float>(((64 - bc7_weights[i]) * e0.decoded(c) + bc7_weights[i] * e1.decoded(c) + 32) >> 6);
+                }
+            }
+
+            float total_error = 0.0f;
+            for (size_t t = 0; t < texels.size(); ++t)
+            {
+                float best_error = std::numeric_limits<float>::max();
+                for (uint32_t i = 0; i < palette.size(); ++i)
+                {
+                    float error = 0.0f;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        float const delta = palette[i][c] - texels[t][c];
+                        error += delta * delta;
+                    }
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        indices[t] = i;
+                    }
+                }
+                total_error += best_error;
+            }
+            return total_error;
+        }
+
+        void encode_bc7(std::array<color, 16> const &texels, block_writer<16> &block)
+        {
+            // Principal axis of the block by power iteration on the covariance
+            color mean{};
+            for (auto const &texel : texels)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    mean[c] += texel[c] / 16.0f;
+                }
+            }
+            std::array<std::array<float, 4>, 4> covariance{};
+            for (auto const &texel : texels)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+                    }
+                }
+            }
+            color axis{1.0f, 1.0f, 1.0f, 1.0f};
+            for (int iteration = 0; iteration < 8; ++iteration)
+            {
+                color next{};
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                    {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+                }
+                float const length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+                if (length < 1e-6f)
+                {
+                    break;
+                }
+                for (int c = 0; c < 4; ++c)
+                {
+                    axis[c] = next[c] / length;
+                }
+            }
+
+            float t_min = std::numeric_limits<float>::max();
+            float t_max = std::numeric_limits<float>::lowest();
+            for (auto const &texel : texels)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    t += (texel[c] - mean[c]) * axis[c];
+                }
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+            color end0{};
+            color end1{};
+            for (int c = 0; c < 4; ++c)
+            {
+                end0[c] = std::clamp(mean[c] + t_min * axis[c], 0.0f, 255.0f);
+                end1[c] = std::clamp(mean[c] + t_max * axis[c], 0.0f, 255.0f);
+            }
+
+            auto e0 = quantize_bc7(end0);
+            auto e1 = quantize_bc7(end1);
+            std::array<uint32_t, 16> indices{};
+            float error = assign_bc7_indices(texels, e0, e1, indices);
+
+            // Least-squares refit of the endpoints to the chosen weights, kept only while it lowers the error
+            for (int iteration = 0; iteration < 2; ++iteration)
+            {
+                float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+                color ax{};
+                color bx{};
+                for (size_t t = 0; t < texels.size(); ++t)
+                {
+                    float const w = static_cast<float>(bc7_weights[indices[t]]) / 64.0f;
+                    aa += (1.0f - w) * (1.0f - w);
+                    ab += (1.0f - w) * w;
+                    bb += w * w;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        ax[c] += (1.0f - w) * texels[t][c];
+                        bx[c] += w * texels[t][c];
+                    }
+                }
+                float const determinant = aa * bb - ab * ab;
+                if (std::abs(determinant) < 1e-6f)
+                {
+                    break;
+                }
+                for (int c = 0; c < 4; ++c)
+                {
+                    end0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+                    end1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+                }
+
+                auto const refit0 = quantize_bc7(end0);
+                auto const refit1 = quantize_bc7(end1);
+                std::array<uint32_t, 16> refit_indices{};
+                float const refit_error = assign_bc7_indices(texels, refit0, refit1, refit_indices);
+                if (refit_error >= error)
+                {
+                    break;
+                }
+                e0 = refit0;
+                e1 = refit1;
+                indices = refit_indices;
+                error = refit_error;
+            }
+
+            // The anchor index only stores three bits, so its top bit has to be zero
+            if (indices[0] & 8)
+            {
+                std::swap(e0, e1);
+                for (auto &index : indices)
+                {
+                    index = 15 - index;
+                }
+            }
+
+            block.write(1u << 6, 7);
+            for (int c = 0; c < 4; ++c)
+            {
+                block.write(e0.value[c], 7);
+                block.write(e1.value[c], 7);
+            }
+            block.write(e0.p_bit, 1);
+            block.write(e1.p_bit, 1);
+            for (size_t t = 0; t < indices.size(); ++t)
+            {
+                block.write(indices[t], t == 0 ? 3 : 4);
+            }
+        }
+
+        auto encode_level(float_image const &image, texture_role role) -> std::vector<uint8_t>
+        {
+            int const blocks_x = (image.width + 3) / 4;
+            int const blocks_y = (image.height + 3) / 4;
+            std::vector<uint8_t> data{};
+            data.reserve(static_cast<size_t>(blocks_x) * blocks_y * 16);
+
+            for (int by = 0; by < blocks_y; ++by)
+            {
+                for (int bx = 0; bx < blocks_x; ++bx)
+                {
+                    // Partial blocks on the right and bottom edges repeat the last texel
+                    std::array<color, 16> texels{};
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        texels[i] = image.at(bx * 4 + i % 4, by * 4 + i / 4);
+                    }
+
+                    switch (role)
+                    {
+                    case texture_role::color:
+                    {
+                        for (auto &texel : texels)
+                        {
+                            for (int c = 0; c < 3; ++c)
+                            {
+                                texel[c] = to_byte(linear_to_srgb(texel[c]));
+                            }
+                            texel[3] = to_byte(texel[3]);
+                        }
+                        block_writer<16> block{};
+                        encode_bc7(texels, block);
+                        data.insert(data.end(), block.bytes.begin(), block.bytes.end());
+                        break;
+                    }
+                    case texture_role::normal:
+                    {
+                        for (int channel = 0; channel < 2; ++channel)
+                        {
+                            std::array<float, 16> values{};
+                            for (int i = 0; i < 16; ++i)
+                            {
+                                values[i] = to_byte(texels[i][channel] * 0.5f + 0.5f);
+                            }
+                            block_writer<8> block{};
+                            encode_bc4(values, block);
+                            data.insert(data.end(), block.bytes.begin(), block.bytes.end());
+                        }
+                        break;
+                    }
+                    case texture_role::gloss:
+                    {
+                        std::array<float, 16> values{};
+                        for (int i = 0; i < 16; ++i)
+                        {
+                            values[i] = to_byte(texels[i][0]);
+                        }
+                        block_writer<8> block{};
+                        encode_bc4(values, block);
+                        data.insert(data.end(), block.bytes.begin(), block.bytes.end());
+                        break;
+                    }
+                    }
+                }
+            }
+            return data;
+        }
+
+        // Basic data format descriptor (Khronos Data Format 1.3, section 5), required by KTX2 even though the engine
+        // only reads vkFormat
+        auto make_dfd(texture_role role) -> std::vector<uint32_t>
+        {
+            constexpr uint32_t khr_df_model_bc4      = 131;
+            constexpr uint32_t khr_df_model_bc5      = 132;
+            constexpr uint32_t khr_df_model_bc7      = 134;
+            constexpr uint32_t khr_df_primaries_bt709 = 1;
+            constexpr uint32_t khr_df_transfer_linear = 1;
+            constexpr uint32_t khr_df_transfer_srgb   = 2;
+
+            uint32_t const model         = role == texture_role::color ? khr_df_model_bc7 : role == texture_role::normal ? khr_df_model_bc5 : khr_df_model_bc4;
+            uint32_t const transfer      = role == texture_role::color ? khr_df_transfer_srgb : khr_df_transfer_linear;
+            uint32_t const block_bytes   = role == texture_role::gloss ? 8 : 16;
+            uint32_t const sample_count  = role == texture_role::normal ? 2 : 1;
+            uint32_t const block_size    = 24 + 16 * sample_count;
+
+            std::vector<uint32_t> dfd{
+                4 + block_size,
+                0,                                              // vendor id and descriptor type: Khronos basic
+                2 | block_size << 16,                           // version 1.3
+                model | khr_df_primaries_bt709 << 8 | transfer << 16,
+                3 | 3 << 8,                                     // 4x4 texel blocks
+                block_bytes,
+                0
+            };
+            for (uint32_t sample = 0; sample < sample_count; ++sample)
+            {
+                uint32_t const bit_length = block_bytes * 8 / sample_count;
+                dfd.push_back(sample * bit_length | (bit_length - 1) << 16 | sample << 24); // channel: red, then green
+                dfd.push_back(0);
+                dfd.push_back(0);
+                dfd.push_back(0xFFFFFFFF);
+            }
+            return dfd;
+        }
+
+        auto write_ktx2(std::string const &path, texture_role role, std::vector<float_image> const &levels) -> size_t
+        {
+            std::vector<std::vector<uint8_t>> level_data{};
+            for (auto const &level : levels)
+            {
+                level_data.push_back(encode_level(level, role));
+            }
+
+            auto const dfd = make_dfd(role);
+
+            ktx2::header header{};
+            std::memcpy(header.identifier, ktx2::identifier.data(), ktx2::identifier.size());
+            header.vk_format              = role == texture_role::color ? VK_FORMAT_BC7_SRGB_BLOCK : role == texture_role::normal ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_BC4_UNORM_BLOCK;
+            header.type_size              = 1;
+            header.pixel_width            = static_cast<uint32_t>(levels.front().width);
+            header.pixel_height           = static_cast<uint32_t>(levels.front().height);
+            header.face_count             = 1;
+            header.level_count            = static_cast<uint32_t>(levels.size());
+            header.dfd_byte_offset        = static_cast<uint32_t>(sizeof(ktx2::header) + sizeof(ktx2::level_index) * levels.size());
+            header.dfd_byte_length        = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+            // Mip data goes smallest level first, each level aligned to the block size
+            size_t const alignment = role == texture_role::gloss ? 8 : 16;
+            size_t offset = header.dfd_byte_offset + header.dfd_byte_length;
+            std::vector<ktx2::level_index> level_index(levels.size());
+            for (size_t i = levels.size(); i-- > 0;)
+            {
+                offset = (offset + alignment - 1) / alignment * alignment;
+                level_index[i] = {offset, level_data[i].size(), level_data[i].size()};
+                offset += level_data[i].size();
+            }
+
+            std::ofstream file{path, std::ios::binary};
+            if (not file)
+            {
+                return 0;
+            }
+            file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+            file.write(reinterpret_cast<char const *>(level_index.data()), static_cast<std::streamsize>(level_index.size() * sizeof(ktx2::level_index)));
+            file.write(reinterpret_cast<char const *>(dfd.data()), static_cast<std::streamsize>(dfd.size() * sizeof(uint32_t)));
+            for (size_t i = levels.size(); i-- > 0;)
+            {
+                while (static_cast<uint64_t>(file.tellp()) < level_index[i].byte_offset)
+                {
+                    file.put(0);
+                }
+                file.write(reinterpret_cast<char const *>(level_data[i].data()), static_cast<std::streamsize>(level_data[i].size()));
+            }
+            return offset;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace dae;
+
+    if (argc != 4)
+    {
+        std::cerr << "usage: texture_cooker <input> <output.ktx2> <color|normal|gloss>\n";
+        return 1;
+    }
+
+    std::string const role_name = argv[3];
+    texture_role role;
+    if (role_name == "color")
+    {
+        role = texture_role::color;
+    }
+    else if (role_name == "normal")
+    {
+        role = texture_role::normal;
+    }
+    else if (role_name == "gloss")
+    {
+        role = texture_role::gloss;
+    }
+    else
+    {
+        std::cerr << "Unknown texture role: " << role_name << '\n';
+        return 1;
+    }
+
+    auto const start = std::chrono::high_resolution_clock::now();
+    std::vector<float_image> levels{};
+    levels.push_back(load_image(argv[1], role));
+    if (levels.front().texels.empty())
+    {
+        std::cerr << "Failed to load texture: " << argv[1] << '\n';
+        return 1;
+    }
+    while (levels.back().width > 1 or levels.back().height > 1)
+    {
+        levels.push_back(downsample(levels.back(), role));
+    }
+
+    auto const file_size = write_ktx2(argv[2], role, levels);
+    if (file_size == 0)
+    {
+        std::cerr << "Failed to write: " << argv[2] << '\n';
+        return 1;
+    }
+
+    size_t rgba_size = 0;
+    for (auto const &level : levels)
+    {
+        rgba_size += static_cast<size_t>(level.width) * level.height * 4;
+    }
+    std::cout << argv[1] << " -> " << argv[2] << " (" << role_name << ", " << levels.size() << " mips): "
+              << rgba_size / 1024 << " KiB as RGBA8, " << file_size / 1024 << " KiB cooked, "
+              << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms\n";
+    return 0;
+}